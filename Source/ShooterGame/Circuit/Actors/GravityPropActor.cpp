@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Circuit/Components/CustomGravityComponent.h"
+#include "Circuit/Actors/GravityPropActor.h"
+
+// Sets default values
+AGravityPropActor::AGravityPropActor()
+{
+	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
+	Mesh->SetSimulatePhysics(true);
+	Mesh->SetCollisionProfileName(UCollisionProfile::PhysicsActor_ProfileName);
+	RootComponent = Mesh;
+
+	// Attached to the mesh so it picks it up as EffectedComponent
+	GravityComponent = CreateDefaultSubobject<UCustomGravityComponent>(TEXT("GravityComponent"));
+	GravityComponent->SetupAttachment(Mesh);
+
+	bReplicates = true;
+	SetReplicatingMovement(true);
+
+	// Props spend most of their life asleep, UCustomGravityComponent::UpdateOwnerNetDormancy wakes them
+	NetDormancy = DORM_DormantAll;
+}
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "GravityPropActor.generated.h"
+
+/**
+ * Base class for replicated physics props that fall under custom gravity. Starts net dormant, so the replication graph routes it as
+ * Spatialize_Dormancy. GravityComponent wakes it while the mesh is moving and puts it back to sleep with the rigid bodies.
+ */
+UCLASS()
+class SHOOTERGAME_API AGravityPropActor : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	AGravityPropActor();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Gravity")
+	class UStaticMeshComponent* Mesh;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Gravity")
+	class UCustomGravityComponent* GravityComponent;
+};
@@ -54,7 +54,12 @@ void UCustomGravityComponent::InitializeComponent()
 // Called when the game starts
 void UCustomGravityComponent::BeginPlay()
 {
-	Super::BeginPlay();	
+	Super::BeginPlay();
+
+	bOwnerNetDormant = GetOwner() && GetOwner()->NetDormancy > DORM_Awake;
+
+	// Otherwise the first tick sees a rotated prop as having turned and wakes it
+	LastRotation = GetComponentRotation();
 }
 
 
@@ -70,15 +75,26 @@ void UCustomGravityComponent::TickComponent(float DeltaTime, ELevelTick TickType
 		return;
 	}
 
-	if (GravityFieldArray.Num() == 0 && AdditiveGravityFieldArray.Num() == 0) {
-		return;
-	}
+	const bool bMoving = GetComponentVelocity().Size() >= 0.07f || !GetComponentRotation().Equals(LastRotation, 0.05f);
+	LastRotation = GetComponentRotation();
 
-	if (GetComponentVelocity().Size() < 0.07f && GetComponentRotation().Equals(LastRotation, 0.05f)) {
-		TimeSpentNotMoving += DeltaTime;
+	if (bMoving) {
+		TimeSpentNotMoving = 0.0f;
 	}
 	else {
-		TimeSpentNotMoving = 0.0f;
+		TimeSpentNotMoving += DeltaTime;
+	}
+
+	// Props start dormant (DORM_Initial), so only wake the owner once something actually moves it, and let it go back to sleep after a while idle
+	if (bMoving) {
+		UpdateOwnerNetDormancy(false);
+	}
+	else if (TimeSpentNotMoving > 8.0f) {
+		UpdateOwnerNetDormancy(true);
+	}
+
+	if (GravityFieldArray.Num() == 0 && AdditiveGravityFieldArray.Num() == 0) {
+		return;
 	}
 
 	if (TimeSpentNotMoving > 8.0f) {
@@ -86,8 +102,6 @@ void UCustomGravityComponent::TickComponent(float DeltaTime, ELevelTick TickType
 		return;
 	}
 
-	LastRotation = GetComponentRotation();
-
 	CalculateCurrentGravity();
 
 	if (bIsSkeletalMesh) {
@@ -110,6 +124,24 @@ void UCustomGravityComponent::TickComponent(float DeltaTime, ELevelTick TickType
 	}
 }
 
+void UCustomGravityComponent::UpdateOwnerNetDormancy(bool bAsleep) {
+	if (bOwnerNetDormant == bAsleep) {
+		return;
+	}
+
+	AActor* Owner = GetOwner();
+	if (Owner == nullptr || !Owner->HasAuthority() || !Owner->GetIsReplicated()) {
+		return;
+	}
+
+	if (Owner->GetClass()->GetDefaultObject<AActor>()->NetDormancy <= DORM_Awake) {
+		return;
+	}
+
+	bOwnerNetDormant = bAsleep;
+	Owner->SetNetDormancy(bAsleep ? DORM_DormantAll : DORM_Awake);
+}
+
 void UCustomGravityComponent::AddToGravityFieldArray(UBaseGravityComponent* FieldToAdd) {
 	GravityFieldArray.AddUnique(FieldToAdd);
 
@@ -77,4 +77,10 @@ public:
 
 	// Used in putting physics actors to sleep after not moving
 	FVector LastPosition = FVector(0.0f, 0.0f, 0.0f);
+
+	// Owner is net dormant while its rigid bodies sleep. Server only.
+	bool bOwnerNetDormant = false;
+
+	// Only owners that start dormant in their class defaults are touched, see ShooterReplicationGraph.cpp
+	void UpdateOwnerNetDormancy(bool bAsleep);
 };
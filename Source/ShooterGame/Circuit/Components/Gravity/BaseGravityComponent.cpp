@@ -3,6 +3,7 @@
 #include "ShooterGame.h"
 #include "Circuit/Components/CustomGravityComponent.h"
 #include "Circuit/Components/Gravity/BaseGravityComponent.h"
+#include "Circuit/Subsystems/GravityFieldSubsystem.h"
 
 // Sets default values for this component's properties
 UBaseGravityComponent::UBaseGravityComponent()
@@ -33,6 +34,10 @@ void UBaseGravityComponent::BeginPlay()
         return;
     }
 
+    if (UGravityFieldSubsystem* GravityFields = GetWorld()->GetSubsystem<UGravityFieldSubsystem>()) {
+        GravityFields->RegisterField(this);
+    }
+
     OnComponentBeginOverlap.AddDynamic(this, &UBaseGravityComponent::OnOverlapBegin);
     OnComponentEndOverlap.AddDynamic(this, &UBaseGravityComponent::OnOverlapEnd);
 
@@ -65,6 +70,15 @@ void UBaseGravityComponent::BeginPlay()
         }, 0.1f, false);
 }
 
+void UBaseGravityComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UGravityFieldSubsystem* GravityFields = GetWorld()->GetSubsystem<UGravityFieldSubsystem>()) {
+        GravityFields->UnregisterField(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
 void UBaseGravityComponent::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent,
     AActor* OtherActor,
     UPrimitiveComponent* OtherComp,
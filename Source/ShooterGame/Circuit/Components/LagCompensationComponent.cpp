@@ -0,0 +1,316 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Circuit/Components/LagCompensationComponent.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+
+// Sets default values for this component's properties
+ULagCompensationComponent::ULagCompensationComponent()
+{
+	// Record after movement and physics so the frame matches what gets replicated
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+	MaxFrames = 40;
+	NextFrame = 0;
+	NumFrames = 0;
+
+	// The head has no body of its own in HeroTPP_Physics, the neck's covers it
+	BoneRegions.Add(TEXT("b_Neck"), ECircuitHitboxRegion::Head);
+	BoneRegions.Add(TEXT("b_LeftShoulder"), ECircuitHitboxRegion::Arm);
+	BoneRegions.Add(TEXT("b_RightShoulder"), ECircuitHitboxRegion::Arm);
+	BoneRegions.Add(TEXT("b_LeftUpLeg"), ECircuitHitboxRegion::Leg);
+	BoneRegions.Add(TEXT("b_RightUpLeg"), ECircuitHitboxRegion::Leg);
+}
+
+
+// Called when the game starts
+void ULagCompensationComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Everyone needs the regions for damage, only the history is server side
+	BuildHitboxes();
+
+	// Only the server validates hits, and nobody needs history in standalone
+	if (GetOwner() && GetOwner()->HasAuthority() && GetNetMode() != NM_Standalone)
+	{
+		Frames.SetNum(FMath::Max(MaxFrames, 2));
+		HitboxPoses.SetNum(Frames.Num() * Hitboxes.Num());
+		SetComponentTickEnabled(true);
+	}
+}
+
+
+// Called every frame
+void ULagCompensationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	RecordFrame();
+}
+
+void ULagCompensationComponent::BuildHitboxes()
+{
+	Hitboxes.Reset();
+
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	const USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+	const UPhysicsAsset* PhysicsAsset = Mesh ? Mesh->GetPhysicsAsset() : nullptr;
+	if (PhysicsAsset == nullptr)
+	{
+		return;
+	}
+
+	const float MeshScale = Mesh->GetComponentScale().GetAbsMax();
+
+	for (const USkeletalBodySetup* BodySetup : PhysicsAsset->SkeletalBodySetups)
+	{
+		const int32 BoneIndex = BodySetup ? Mesh->GetBoneIndex(BodySetup->BoneName) : INDEX_NONE;
+		if (BoneIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		// One shape per body is plenty for hit regions, take the first in order of preference
+		const FKAggregateGeom& Geom = BodySetup->AggGeom;
+		FCircuitHitbox Hitbox;
+		if (Geom.SphylElems.Num() > 0)
+		{
+			const FKSphylElem& Sphyl = Geom.SphylElems[0];
+			Hitbox.Center = Sphyl.Center;
+			Hitbox.Axis = Sphyl.Rotation.RotateVector(FVector(0.0f, 0.0f, Sphyl.Length * 0.5f));
+			Hitbox.Radius = Sphyl.Radius;
+		}
+		else if (Geom.SphereElems.Num() > 0)
+		{
+			const FKSphereElem& Sphere = Geom.SphereElems[0];
+			Hitbox.Center = Sphere.Center;
+			Hitbox.Radius = Sphere.Radius;
+		}
+		else if (Geom.BoxElems.Num() > 0)
+		{
+			const FKBoxElem& Box = Geom.BoxElems[0];
+			const FVector HalfExtent(Box.X * 0.5f, Box.Y * 0.5f, Box.Z * 0.5f);
+			const int32 LongAxis = HalfExtent.X >= HalfExtent.Y ? (HalfExtent.X >= HalfExtent.Z ? 0 : 2) : (HalfExtent.Y >= HalfExtent.Z ? 1 : 2);
+
+			FVector AxisDir = FVector::ZeroVector;
+			AxisDir[LongAxis] = 1.0f;
+
+			Hitbox.Center = Box.Center;
+			Hitbox.Radius = FMath::Max(HalfExtent[(LongAxis + 1) % 3], HalfExtent[(LongAxis + 2) % 3]);
+			Hitbox.Axis = Box.Rotation.RotateVector(AxisDir) * FMath::Max(HalfExtent[LongAxis] - Hitbox.Radius, 0.0f);
+		}
+		else
+		{
+			continue;
+		}
+
+		Hitbox.BoneName = BodySetup->BoneName;
+		Hitbox.BoneIndex = BoneIndex;
+		Hitbox.Radius *= MeshScale;
+
+		// Walk up to the nearest bone with a region, so forearms and hands count as arms
+		for (FName BoneName = Hitbox.BoneName; BoneName != NAME_None; BoneName = Mesh->GetParentBone(BoneName))
+		{
+			if (const TEnumAsByte<ECircuitHitboxRegion::Type>* Region = BoneRegions.Find(BoneName))
+			{
+				Hitbox.Region = *Region;
+				break;
+			}
+		}
+
+		Hitboxes.Add(Hitbox);
+	}
+}
+
+ECircuitHitboxRegion::Type ULagCompensationComponent::GetHitboxRegion(FName BoneName) const
+{
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	const USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+
+	for (; BoneName != NAME_None; BoneName = Mesh ? Mesh->GetParentBone(BoneName) : NAME_None)
+	{
+		for (const FCircuitHitbox& Hitbox : Hitboxes)
+		{
+			if (Hitbox.BoneName == BoneName)
+			{
+				return Hitbox.Region;
+			}
+		}
+	}
+
+	return ECircuitHitboxRegion::Torso;
+}
+
+void ULagCompensationComponent::RecordFrame()
+{
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	if (Character == nullptr || Character->GetCapsuleComponent() == nullptr)
+	{
+		return;
+	}
+
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+
+	FCircuitHitboxFrame& Frame = Frames[NextFrame];
+	Frame.Time = GetWorld()->GetTimeSeconds();
+	Frame.Location = Capsule->GetComponentLocation();
+	Frame.Rotation = Capsule->GetComponentQuat();
+	Frame.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	Frame.CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+	// Remote characters are always seen in third person on the server, so their bones are refreshed every tick
+	if (const USkeletalMeshComponent* Mesh = Character->GetMesh())
+	{
+		FCircuitHitboxPose* Poses = HitboxPoses.GetData() + NextFrame * Hitboxes.Num();
+		for (int32 HitboxIndex = 0; HitboxIndex < Hitboxes.Num(); ++HitboxIndex)
+		{
+			const FCircuitHitbox& Hitbox = Hitboxes[HitboxIndex];
+			const FTransform BoneTransform = Mesh->GetBoneTransform(Hitbox.BoneIndex);
+
+			Poses[HitboxIndex].Center = BoneTransform.TransformPosition(Hitbox.Center);
+			Poses[HitboxIndex].Axis = BoneTransform.GetRotation().RotateVector(Hitbox.Axis) * BoneTransform.GetScale3D().GetAbsMax();
+		}
+	}
+
+	NextFrame = (NextFrame + 1) % Frames.Num();
+	NumFrames = FMath::Min(NumFrames + 1, Frames.Num());
+}
+
+int32 ULagCompensationComponent::GetFrameSlot(int32 AgeIndex) const
+{
+	return (NextFrame - 1 - AgeIndex + Frames.Num()) % Frames.Num();
+}
+
+const FCircuitHitboxFrame& ULagCompensationComponent::GetFrame(int32 AgeIndex) const
+{
+	return Frames[GetFrameSlot(AgeIndex)];
+}
+
+bool ULagCompensationComponent::FindFramesAtTime(double Time, int32& OutOlderAge, int32& OutNewerAge, float& OutAlpha) const
+{
+	if (NumFrames == 0)
+	{
+		return false;
+	}
+
+	OutOlderAge = 0;
+	OutNewerAge = 0;
+	OutAlpha = 0.0f;
+
+	if (Time >= GetFrame(0).Time)
+	{
+		return true;
+	}
+
+	for (int32 AgeIndex = 1; AgeIndex < NumFrames; ++AgeIndex)
+	{
+		const FCircuitHitboxFrame& Newer = GetFrame(AgeIndex - 1);
+		const FCircuitHitboxFrame& Older = GetFrame(AgeIndex);
+		if (Time >= Older.Time)
+		{
+			OutOlderAge = AgeIndex;
+			OutNewerAge = AgeIndex - 1;
+			OutAlpha = (Newer.Time > Older.Time) ? (float)((Time - Older.Time) / (Newer.Time - Older.Time)) : 0.0f;
+			return true;
+		}
+	}
+
+	OutOlderAge = NumFrames - 1;
+	OutNewerAge = NumFrames - 1;
+	return true;
+}
+
+bool ULagCompensationComponent::GetFrameAtTime(double Time, FCircuitHitboxFrame& OutFrame) const
+{
+	int32 OlderAge;
+	int32 NewerAge;
+	float Alpha;
+	if (!FindFramesAtTime(Time, OlderAge, NewerAge, Alpha))
+	{
+		return false;
+	}
+
+	const FCircuitHitboxFrame& Older = GetFrame(OlderAge);
+	const FCircuitHitboxFrame& Newer = GetFrame(NewerAge);
+	if (OlderAge == NewerAge)
+	{
+		OutFrame = Newer;
+		return true;
+	}
+
+	OutFrame.Time = Time;
+	OutFrame.Location = FMath::Lerp(Older.Location, Newer.Location, Alpha);
+	OutFrame.Rotation = FQuat::Slerp(Older.Rotation, Newer.Rotation, Alpha);
+	OutFrame.CapsuleRadius = FMath::Lerp(Older.CapsuleRadius, Newer.CapsuleRadius, Alpha);
+	OutFrame.CapsuleHalfHeight = FMath::Lerp(Older.CapsuleHalfHeight, Newer.CapsuleHalfHeight, Alpha);
+	return true;
+}
+
+bool ULagCompensationComponent::RewindTrace(double Time, const FVector& Start, const FVector& End, float Leeway, FVector& OutHitLocation, FName& OutBoneName) const
+{
+	OutBoneName = NAME_None;
+
+	if (Hitboxes.Num() == 0)
+	{
+		FCircuitHitboxFrame Frame;
+		if (!GetFrameAtTime(Time, Frame))
+		{
+			return false;
+		}
+
+		// A capsule is every point within its radius of the segment between its two sphere centres
+		const FVector Axis = Frame.Rotation.GetUpVector() * FMath::Max(Frame.CapsuleHalfHeight - Frame.CapsuleRadius, 0.0f);
+
+		FVector OnTrace;
+		FVector OnAxis;
+		FMath::SegmentDistToSegmentSafe(Start, End, Frame.Location - Axis, Frame.Location + Axis, OnTrace, OnAxis);
+
+		if (FVector::DistSquared(OnTrace, OnAxis) <= FMath::Square(Frame.CapsuleRadius + Leeway))
+		{
+			OutHitLocation = OnTrace;
+			return true;
+		}
+
+		return false;
+	}
+
+	int32 OlderAge;
+	int32 NewerAge;
+	float Alpha;
+	if (!FindFramesAtTime(Time, OlderAge, NewerAge, Alpha))
+	{
+		return false;
+	}
+
+	const FCircuitHitboxPose* OlderPoses = HitboxPoses.GetData() + GetFrameSlot(OlderAge) * Hitboxes.Num();
+	const FCircuitHitboxPose* NewerPoses = HitboxPoses.GetData() + GetFrameSlot(NewerAge) * Hitboxes.Num();
+
+	// Same test as the capsule for each hitbox, keeping the one nearest the start of the trace
+	float BestDistSquared = MAX_FLT;
+	for (int32 HitboxIndex = 0; HitboxIndex < Hitboxes.Num(); ++HitboxIndex)
+	{
+		const FVector Center = FMath::Lerp(OlderPoses[HitboxIndex].Center, NewerPoses[HitboxIndex].Center, Alpha);
+		const FVector Axis = FMath::Lerp(OlderPoses[HitboxIndex].Axis, NewerPoses[HitboxIndex].Axis, Alpha);
+
+		FVector OnTrace;
+		FVector OnAxis;
+		FMath::SegmentDistToSegmentSafe(Start, End, Center - Axis, Center + Axis, OnTrace, OnAxis);
+
+		if (FVector::DistSquared(OnTrace, OnAxis) <= FMath::Square(Hitboxes[HitboxIndex].Radius + Leeway))
+		{
+			const float DistSquared = FVector::DistSquared(Start, OnTrace);
+			if (DistSquared < BestDistSquared)
+			{
+				BestDistSquared = DistSquared;
+				OutHitLocation = OnTrace;
+				OutBoneName = Hitboxes[HitboxIndex].BoneName;
+			}
+		}
+	}
+
+	return OutBoneName != NAME_None;
+}
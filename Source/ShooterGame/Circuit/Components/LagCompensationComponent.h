@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "LagCompensationComponent.generated.h"
+
+UENUM(BlueprintType)
+namespace ECircuitHitboxRegion
+{
+	enum Type
+	{
+		Torso,
+		Head,
+		Arm,
+		Leg,
+		MAX UMETA(Hidden)
+	};
+}
+
+/* One physics asset body reduced to a capsule, in its bone's space. Spheres have no axis, boxes become the capsule along their longest side */
+struct FCircuitHitbox
+{
+	FName BoneName;
+	int32 BoneIndex = INDEX_NONE;
+	FVector Center = FVector::ZeroVector;
+
+	/* Half the segment between the sphere centres */
+	FVector Axis = FVector::ZeroVector;
+
+	/* Scaled by the mesh, which doesn't change after spawning */
+	float Radius = 0.0f;
+
+	ECircuitHitboxRegion::Type Region = ECircuitHitboxRegion::Torso;
+};
+
+/* A hitbox placed in the world at one frame */
+struct FCircuitHitboxPose
+{
+	FVector Center = FVector::ZeroVector;
+	FVector Axis = FVector::ZeroVector;
+};
+
+/* Where the owner's capsule was at one point in server time */
+struct FCircuitHitboxFrame
+{
+	double Time = 0.0;
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	float CapsuleRadius = 0.0f;
+	float CapsuleHalfHeight = 0.0f;
+};
+
+/*
+ * Server side history of the owning character's capsule, kept in a fixed size ring buffer and recorded once per tick after physics.
+ * AShooterWeapon_Instant rewinds the target to the shooter's client timestamp and re-traces against the capsule as it was then.
+ * Capsules follow the character's rotation, so characters standing on a planet's side are checked along their own up axis.
+ *
+ * Characters with a physics asset also get hitboxes: each body cached once as a capsule on its bone, tagged with the region it belongs to.
+ * Their poses are recorded alongside the capsule, rewound traces test them instead, and the region of a hit bone scales weapon damage.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class SHOOTERGAME_API ULagCompensationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:	
+	// Sets default values for this component's properties
+	ULagCompensationComponent();
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+public:	
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/* Frames of history kept. At a 30Hz server tick the default covers a little over a second */
+	UPROPERTY(EditDefaultsOnly, Category = "Circuit|LagCompensation")
+	int32 MaxFrames;
+
+	/* Region of each bone listed and the bones below it, anything else is Torso. Defaults match the HeroTPP skeleton */
+	UPROPERTY(EditDefaultsOnly, Category = "Circuit|LagCompensation")
+	TMap<FName, TEnumAsByte<ECircuitHitboxRegion::Type>> BoneRegions;
+
+	const TArray<FCircuitHitbox>& GetHitboxes() const { return Hitboxes; }
+
+	/* Region of the hitbox on BoneName, or of the nearest bone above it with one. Torso if there is none */
+	ECircuitHitboxRegion::Type GetHitboxRegion(FName BoneName) const;
+
+	/* Capsule at Time, interpolated between the two frames around it. Times older than the history use the oldest frame. False if nothing was recorded yet */
+	bool GetFrameAtTime(double Time, FCircuitHitboxFrame& OutFrame) const;
+
+	/* Traces Start to End against the hitboxes (or the capsule, without a physics asset) as they were at Time, grown by Leeway. OutBoneName is the hitbox's bone, None for the capsule */
+	bool RewindTrace(double Time, const FVector& Start, const FVector& End, float Leeway, FVector& OutHitLocation, FName& OutBoneName) const;
+
+protected:
+	void BuildHitboxes();
+
+	void RecordFrame();
+
+	/* Slot in Frames of the frame AgeIndex frames old, 0 is the newest */
+	int32 GetFrameSlot(int32 AgeIndex) const;
+
+	const FCircuitHitboxFrame& GetFrame(int32 AgeIndex) const;
+
+	/* The two frames around Time and how far between them it is. Both are the same frame outside the history */
+	bool FindFramesAtTime(double Time, int32& OutOlderAge, int32& OutNewerAge, float& OutAlpha) const;
+
+	TArray<FCircuitHitboxFrame> Frames;
+
+	TArray<FCircuitHitbox> Hitboxes;
+
+	/* Hitboxes.Num() poses per slot in Frames */
+	TArray<FCircuitHitboxPose> HitboxPoses;
+
+	/* Slot the next frame is written to */
+	int32 NextFrame;
+
+	int32 NumFrames;
+};
@@ -2,32 +2,23 @@
 
 #include "ShooterGame.h"
 #include "Circuit/Components/WireComponent.h"
+#include "Circuit/Subsystems/WireSubsystem.h"
+#include "Circuit/Subsystems/WireProfiler.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
-/*
-static TAutoConsoleVariable<int32> CVarWireTickRate(
-	TEXT("wire.TickRate"),
-	20,
-	TEXT("Defines how quickly wire ticks, adjust for quality or performance.\n")
-	TEXT("<=0: off\n")
-	TEXT("  20: normal quality (default)\n"),
-	ECVF_Scalability | ECVF_RenderThreadSafe);
-
-FAutoConsoleVariableSink CVarWireTickRateSink(FConsoleCommandDelegate::CreateLambda([]()
-	{
-	// @TODO - Place wire tick rate somewhere and compare/set from server
-		if (UWireComponent::GetComponentTickInterval() != CVarWireTickRate.GetValueOnGameThread()) {
+/* How many SendValue calls are currently on the stack, and which component started the chain. Wires only run on the game thread. */
+static int32 WirePropagationDepth = 0;
+static const UWireComponent* WireChainRoot = nullptr;
 
-		}
-		UE_LOG(LogTemp, Warning, TEXT("UWireComponent HERE"));
-	}));
-
-*/
 // Sets default values for this component's properties
 UWireComponent::UWireComponent()
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
+
+	// Existing Blueprint devices rely on the ReceiveData* events
+	bDispatchBlueprintEvents = true;
 }
 
 
@@ -36,8 +27,137 @@ void UWireComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
-	
+	// Components placed before GUIDs existed won't have one until the level is resaved
+	if (!WireGuid.IsValid())
+	{
+		WireGuid = MakeStableWireGuid();
+	}
+
+	if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(GetWorld()))
+	{
+		WireSubsystem->RegisterWireComponent(this);
+	}
+}
+
+void UWireComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(GetWorld()))
+	{
+		WireSubsystem->UnregisterWireComponent(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UWireComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
+{
+	// Everything wired to us holds a weak pointer, but unhooking now keeps their lists clean
+	DisconnectFromAllWires();
+
+	Super::OnComponentDestroyed(bDestroyingHierarchy);
+}
+
+void UWireComponent::OnComponentCreated()
+{
+	Super::OnComponentCreated();
+
+	if (!WireGuid.IsValid())
+	{
+		// Only components placed in a level get a GUID derived from their path. Spawned ones can reuse a path once the first is gone.
+		const UWorld* World = GetWorld();
+		WireGuid = (World && World->IsGameWorld()) ? FGuid::NewGuid() : MakeStableWireGuid();
+	}
+}
+
+void UWireComponent::PostLoad()
+{
+	Super::PostLoad();
+
+	if (!WireGuid.IsValid() && !HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		WireGuid = MakeStableWireGuid();
+	}
+}
+
+FGuid UWireComponent::MakeStableWireGuid() const
+{
+	// Level package (without the PIE prefix) plus the path inside the level, so the same placed component gets the same GUID every session
+	const FString LevelPackage = UWorld::RemovePIEPrefix(GetOutermost()->GetName());
+	const ULevel* Level = GetComponentLevel();
+	return FGuid::NewDeterministicGuid(LevelPackage + TEXT(":") + (Level ? GetPathName(Level) : GetPathName()));
+}
+
+#if WITH_EDITOR
+void UWireComponent::PostEditImport()
+{
+	Super::PostEditImport();
+
+	// Pasted components must not share an identity with the component they were copied from
+	WireGuid = FGuid::NewGuid();
+}
+#endif
+
+void UWireComponent::SetWireGuid(FGuid NewGuid)
+{
+	UWireSubsystem* WireSubsystem = HasBegunPlay() ? UWorld::GetSubsystem<UWireSubsystem>(GetWorld()) : nullptr;
+	if (WireSubsystem)
+	{
+		WireSubsystem->UnregisterWireComponent(this);
+	}
+
+	WireGuid = NewGuid;
+
+	if (WireSubsystem)
+	{
+		WireSubsystem->RegisterWireComponent(this);
+	}
+}
+
+int32 UWireComponent::FindEventIndex(FName EventName) const
+{
+	if (const int32* Cached = EventIndexCache.Find(EventName))
+	{
+		if (Events.IsValidIndex(*Cached) && Events[*Cached].EventName == EventName)
+		{
+			return *Cached;
+		}
+	}
+
+	const int32 Index = Events.IndexOfByPredicate([EventName](const FWireEvent& Event) { return Event.EventName == EventName; });
+	if (Index != INDEX_NONE)
+	{
+		EventIndexCache.Add(EventName, Index);
+	}
+	return Index;
+}
+
+int32 UWireComponent::FindInputIndex(FName InputName) const
+{
+	if (const int32* Cached = InputIndexCache.Find(InputName))
+	{
+		if (Inputs.IsValidIndex(*Cached) && Inputs[*Cached].EventName == InputName)
+		{
+			return *Cached;
+		}
+	}
+
+	const int32 Index = Inputs.IndexOfByPredicate([InputName](const FWireListen& Input) { return Input.EventName == InputName; });
+	if (Index != INDEX_NONE)
+	{
+		InputIndexCache.Add(InputName, Index);
+	}
+	return Index;
+}
+
+void UWireComponent::RemoveIncomingLink(int32 InputIndex, const UWireComponent* Output, FName EventName)
+{
+	if (Inputs.IsValidIndex(InputIndex))
+	{
+		Inputs[InputIndex].Connections.RemoveAll([Output, EventName](const FWireConnectedOutputInfo& Connection)
+		{
+			return Connection.EventName == EventName && Connection.OutputComponent.Get() == Output;
+		});
+	}
 }
 
 
@@ -60,141 +180,269 @@ void UWireComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorC
 */
 bool UWireComponent::AddObserverToActorEvent_Implementation(UWireComponent* OutputActor, UWireComponent* Observer, FName InputName, FName EventName)
 {
-	for (int i = Events.Num() - 1; i >= 0; i--)
+	const int32 EventIndex = FindEventIndex(EventName);
+	if (EventIndex == INDEX_NONE || Observer == nullptr)
 	{
-		if (Events[i].EventName.IsEqual(EventName))
-		{
-			//Make sure not already an observer
-			for (int x = 0; x < Events[i].Observers.Num(); x++)
-			{
-				if (Events[i].Observers[x].InputComponent == Observer) {
-					return false;
-				}
-			}
+		return false;
+	}
 
-			FWireConnectedInputInfo NewObserver;
-			NewObserver.InputComponent = Observer;
-			NewObserver.InputName = InputName;
+	FWireEvent& Event = Events[EventIndex];
 
-			for (int y = 0; y < Observer->Inputs.Num(); y++) {
-				if (Observer->Inputs[y].EventName == InputName) {
-					Observer->Inputs[y].OutputComponents.Push(OutputActor);
-				}
-			}
+	//Make sure not already an observer
+	for (const FWireConnectedInputInfo& Existing : Event.Observers)
+	{
+		if (Existing.InputComponent.Get() == Observer) {
+			return false;
+		}
+	}
 
-			switch (Events[i].EnumType)
-			{
-			case EWireDataType::Int32:
-			{
-				Events[i].Observers.Push(NewObserver);
-				Observer->SendDataInt32(Observer, EventName, InputName, Observer->GetDataInt32(EventName));
-				return true;
-				break;
-			}
-			case EWireDataType::Float:
-			{
-				Events[i].Observers.Push(NewObserver);
-				Observer->SendDataFloat(Observer, EventName, InputName, Observer->GetDataFloat(EventName));
-				return true;
-				break;
-			}
-			case EWireDataType::String:
-			{
-				Events[i].Observers.Push(NewObserver);
-				Observer->SendDataString(Observer, EventName, InputName, Observer->GetDataString(EventName));
-				return true;
-				break;
-			}
-			case EWireDataType::Bool:
-			{
-				Events[i].Observers.Push(NewObserver);
-				Observer->SendDataBool(Observer, EventName, InputName, Observer->GetDataBool(EventName));
-				return true;
-				break;
-			}
-			default:
-				return false;
-				break;
-			}
-			return true;
+	FWireConnectedInputInfo NewObserver;
+	NewObserver.InputComponent = Observer;
+	NewObserver.InputName = InputName;
 
-		}
+	const int32 InputIndex = Observer->FindInputIndex(InputName);
+	if (InputIndex != INDEX_NONE)
+	{
+		FWireConnectedOutputInfo Connection;
+		Connection.OutputComponent = OutputActor;
+		Connection.EventName = EventName;
+		Observer->Inputs[InputIndex].Connections.Add(Connection);
 	}
-	return false;
+
+	Event.Observers.Add(NewObserver);
+	Observer->ReceiveValue(OutputActor, InputName, GetValue(EventName));
+	return true;
 }
 
 bool UWireComponent::DisconnectObserverFromActorEvent_Implementation(UWireComponent* Observer, FName InputName, FName EventName)
 {
-	for (int y = Observer->Inputs.Num() - 1; y >= 0; y--) {
-		if (Observer->Inputs[y].EventName == InputName) {
-			for (int w = Observer->Inputs[y].OutputComponents.Num() - 1; w >= 0; w--) {
-				if (Observer->Inputs[y].OutputComponents[w] == this) {
-					Observer->Inputs[y].OutputComponents.RemoveAt(w);
-					break;
-				}
-				if (Observer->Inputs[y].OutputComponents[w] == NULL) {
-					Observer->Inputs[y].OutputComponents.RemoveAt(w);
-				}
+	if (Observer == nullptr)
+	{
+		return false;
+	}
+
+	Observer->RemoveIncomingLink(Observer->FindInputIndex(InputName), this, EventName);
+
+	const int32 EventIndex = FindEventIndex(EventName);
+	if (EventIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	TArray<FWireConnectedInputInfo>& Observers = Events[EventIndex].Observers;
+	const int32 ObserverIndex = Observers.IndexOfByPredicate([Observer](const FWireConnectedInputInfo& Info) { return Info.InputComponent.Get() == Observer; });
+	if (ObserverIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	Observers.RemoveAt(ObserverIndex);
+	return true;
+}
+
+void UWireComponent::DisconnectFromAllWires()
+{
+	// Outgoing: each observer only needs the one input we feed looked up
+	for (FWireEvent& Event : Events)
+	{
+		for (const FWireConnectedInputInfo& Observer : Event.Observers)
+		{
+			if (UWireComponent* InputComponent = Observer.InputComponent.Get())
+			{
+				InputComponent->RemoveIncomingLink(InputComponent->FindInputIndex(Observer.InputName), this, Event.EventName);
 			}
 		}
+		Event.Observers.Reset();
 	}
 
-	for (int i = Events.Num() - 1; i >= 0; i--)
+	// Incoming: the connection records say exactly which event on which output to unhook
+	for (FWireListen& Input : Inputs)
 	{
-		if (Events[i].EventName.IsEqual(EventName))
+		for (const FWireConnectedOutputInfo& Connection : Input.Connections)
 		{
-			for (int x = Events[i].Observers.Num() - 1; x >= 0; x--) {
-				if (Events[i].Observers[x].InputComponent == NULL)
-				{
-					Events[i].Observers.RemoveAt(x);
-					continue;
-				}
-				if (Events[i].Observers[x].InputComponent == Observer)
+			UWireComponent* OutputComponent = Connection.OutputComponent.Get();
+			const int32 EventIndex = OutputComponent ? OutputComponent->FindEventIndex(Connection.EventName) : INDEX_NONE;
+			if (EventIndex != INDEX_NONE)
+			{
+				const FName InputName = Input.EventName;
+				OutputComponent->Events[EventIndex].Observers.RemoveAll([this, InputName](const FWireConnectedInputInfo& Info)
 				{
-					Events[i].Observers.RemoveAt(x);
-					return true;
-				}
+					return Info.InputComponent.Get() == this && Info.InputName == InputName;
+				});
 			}
-			return false;
 		}
+		Input.Connections.Reset();
 	}
-	return false;
 }
 
-void UWireComponent::DisconnectFromAllWires()
+FWireValue UWireComponent::GetValue(FName EventName)
 {
-	for (int i = Events.Num() - 1; i >= 0; i--) {
-		for (int y = Events[i].Observers.Num() - 1; y >= 0; y--) {
-			DisconnectObserverFromActorEvent(Events[i].Observers[y].InputComponent, Events[i].Observers[y].InputName, Events[i].EventName);
-		}
+	const int32 EventIndex = FindEventIndex(EventName);
+	if (EventIndex == INDEX_NONE)
+	{
+		return FWireValue();
+	}
+
+	const FWireEvent& Event = Events[EventIndex];
+	if (Event.bHasCurrentValue)
+	{
+		return Event.CurrentValue;
+	}
+
+	// Nothing sent yet, fall back to whatever the Blueprint exposes
+	switch (Event.EnumType)
+	{
+	case EWireDataType::Int32:	return FWireValue::MakeInt32(GetDataInt32(EventName));
+	case EWireDataType::Float:	return FWireValue::MakeFloat(GetDataFloat(EventName));
+	case EWireDataType::String:	return FWireValue::MakeName(GetDataString(EventName));
+	case EWireDataType::Vector:	return FWireValue::MakeVector(GetDataVector(EventName));
+	case EWireDataType::Bool:
+	default:
+		return FWireValue::MakeBool(GetDataBool(EventName));
 	}
 }
 
-// No implementation, needs to be implemented in blueprints.
-bool UWireComponent::GetDataBool_Implementation(FName EventName)
+void UWireComponent::SendValue(FName EventName, const FWireValue& Value)
 {
-	return false;
+	SCOPE_CYCLE_COUNTER(STAT_WireSendValue);
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(UWireComponent_SendValue, WireChannel);
+
+	const int32 EventIndex = FindEventIndex(EventName);
+	if (EventIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Observers were wired up against the event's type and read the matching field of the value
+	if (Value.Type != Events[EventIndex].EnumType)
+	{
+		UE_LOG(LogCircuitWire, Warning, TEXT("%s: %s value sent on %s event %s, ignored"), *GetPathName(), *UEnum::GetValueAsString(Value.Type), *UEnum::GetValueAsString(Events[EventIndex].EnumType), *EventName.ToString());
+		return;
+	}
+
+	// A send from inside a receive handler is one link further down the chain
+	const int32 MaxDepth = FWireProfiler::GetMaxPropagationDepth();
+	if (MaxDepth > 0 && WirePropagationDepth >= MaxDepth)
+	{
+		INC_DWORD_STAT(STAT_WireThrottledSends);
+		if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(GetWorld()))
+		{
+			WireSubsystem->GetProfiler().RecordThrottled(this, EventName, WirePropagationDepth);
+		}
+		return;
+	}
+
+	TGuardValue<int32> DepthGuard(WirePropagationDepth, WirePropagationDepth + 1);
+	TGuardValue<const UWireComponent*> RootGuard(WireChainRoot, WireChainRoot ? WireChainRoot : this);
+
+	FWireEvent& Event = Events[EventIndex];
+	Event.CurrentValue = Value;
+	Event.bHasCurrentValue = true;
+
+	if (FWireProfiler::IsEnabled())
+	{
+		if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(GetWorld()))
+		{
+			WireSubsystem->GetProfiler().RecordSend(this, EventName, Event.Observers.Num(), WirePropagationDepth, WireChainRoot);
+		}
+	}
+
+	// Observers unhook themselves when destroyed, so a stale entry here only means it was garbage collected without being destroyed.
+	// A receiver may also disconnect wires while we are sending, so the array is re-checked every iteration.
+	bool bFoundStale = false;
+	for (int x = Event.Observers.Num() - 1; x >= 0; x--) {
+		if (!Events.IsValidIndex(EventIndex) || !Events[EventIndex].Observers.IsValidIndex(x))
+		{
+			continue;
+		}
+
+		const FWireConnectedInputInfo Observer = Events[EventIndex].Observers[x];
+		if (UWireComponent* InputComponent = Observer.InputComponent.Get())
+		{
+			InputComponent->ReceiveValue(this, Observer.InputName, Value);
+		}
+		else
+		{
+			bFoundStale = true;
+		}
+	}
+
+	if (bFoundStale && Events.IsValidIndex(EventIndex))
+	{
+		Events[EventIndex].Observers.RemoveAll([](const FWireConnectedInputInfo& Info) { return !Info.InputComponent.IsValid(); });
+	}
 }
 
-void UWireComponent::SendDataBool_Implementation(UWireComponent* Sender, FName EventName, FName InputName, bool Data)
+void UWireComponent::ReceiveValue(UWireComponent* Sender, FName InputName, const FWireValue& Value)
 {
-	for (int i = 0; i < Events.Num(); i++)
+	// Wire devices sit dormant until a value arrives, whatever the handlers change has to go out
+	AActor* Owner = GetOwner();
+	if (Owner && Owner->NetDormancy > DORM_Awake && Owner->HasAuthority())
+	{
+		Owner->FlushNetDormancy();
+	}
+
+	OnValueReceived.Broadcast(Sender, InputName, Value);
+
+	const bool bProfile = FWireProfiler::IsEnabled();
+	if (!bDispatchBlueprintEvents)
 	{
-		if (Events[i].EventName.IsEqual(EventName))
+		if (bProfile)
 		{
-			for (int x = Events[i].Observers.Num() - 1; x >= 0; x--) {
-				if (Events[i].Observers[x].InputComponent == NULL)
-				{
-					Events[i].Observers.RemoveAt(x);
-					continue;
-				}
-				Events[i].Observers[x].InputComponent->ReceiveDataBool.Broadcast(this, Events[i].Observers[x].InputName, Data);
+			if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(GetWorld()))
+			{
+				WireSubsystem->GetProfiler().RecordReceive(this, 0.0);
 			}
-			return;
+		}
+		return;
+	}
+
+	const double StartTime = bProfile ? FPlatformTime::Seconds() : 0.0;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_WireBlueprintReceive);
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(UWireComponent_BlueprintReceive, WireChannel);
+
+		switch (Value.Type)
+		{
+		case EWireDataType::Bool:
+			ReceiveDataBool.Broadcast(Sender, InputName, Value.BoolValue);
+			break;
+		case EWireDataType::Int32:
+			ReceiveDataInt32(Sender, InputName, Value.IntValue);
+			break;
+		case EWireDataType::Float:
+			ReceiveDataFloat(Sender, InputName, Value.FloatValue);
+			break;
+		case EWireDataType::String:
+			ReceiveDataString(Sender, InputName, Value.NameValue);
+			break;
+		case EWireDataType::Vector:
+			ReceiveDataVector(Sender, InputName, Value.VectorValue);
+			break;
+		}
+	}
+
+	if (bProfile)
+	{
+		if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(GetWorld()))
+		{
+			// Includes any sends made from the handler, which is what a circuit author cares about
+			WireSubsystem->GetProfiler().RecordReceive(this, FPlatformTime::Seconds() - StartTime);
 		}
 	}
 }
 
+// No implementation, needs to be implemented in blueprints.
+bool UWireComponent::GetDataBool_Implementation(FName EventName)
+{
+	return false;
+}
+
+void UWireComponent::SendDataBool_Implementation(UWireComponent* Sender, FName EventName, FName InputName, bool Data)
+{
+	SendValue(EventName, FWireValue::MakeBool(Data));
+}
+
 // No implementation, needs to be implemented in blueprints.
 int32 UWireComponent::GetDataInt32_Implementation(FName EventName)
 {
@@ -203,21 +451,7 @@ int32 UWireComponent::GetDataInt32_Implementation(FName EventName)
 
 void UWireComponent::SendDataInt32_Implementation(UWireComponent* Sender, FName EventName, FName InputName, int32 Data)
 {
-	for (int i = 0; i < Events.Num(); i++)
-	{
-		if (Events[i].EventName.IsEqual(EventName))
-		{
-			for (int x = Events[i].Observers.Num() - 1; x >= 0; x--) {
-				if (Events[i].Observers[x].InputComponent == NULL)
-				{
-					Events[i].Observers.RemoveAt(x);
-					continue;
-				}
-				Events[i].Observers[x].InputComponent->ReceiveDataInt32(this, Events[i].Observers[x].InputName, Data);
-			}
-			return;
-		}
-	}
+	SendValue(EventName, FWireValue::MakeInt32(Data));
 }
 
 void UWireComponent::ReceiveDataInt32_Implementation(UWireComponent* Sender, FName InputName, int32 Data)
@@ -233,21 +467,7 @@ float UWireComponent::GetDataFloat_Implementation(FName EventName)
 
 void UWireComponent::SendDataFloat_Implementation(UWireComponent* Sender, FName EventName, FName InputName, float Data)
 {
-	for (int i = 0; i < Events.Num(); i++)
-	{
-		if (Events[i].EventName.IsEqual(EventName))
-		{
-			for (int x = Events[i].Observers.Num() - 1; x >= 0; x--) {
-				if (Events[i].Observers[x].InputComponent == NULL)
-				{
-					Events[i].Observers.RemoveAt(x);
-					continue;
-				}
-				Events[i].Observers[x].InputComponent->ReceiveDataFloat(this, Events[i].Observers[x].InputName, Data);
-			}
-			return;
-		}
-	}
+	SendValue(EventName, FWireValue::MakeFloat(Data));
 }
 
 void UWireComponent::ReceiveDataFloat_Implementation(UWireComponent* Sender, FName InputName, float Data)
@@ -263,24 +483,26 @@ FName UWireComponent::GetDataString_Implementation(FName EventName)
 
 void UWireComponent::SendDataString_Implementation(UWireComponent* Sender, FName EventName, FName InputName, FName Data)
 {
-	for (int i = 0; i < Events.Num(); i++)
-	{
-		if (Events[i].EventName.IsEqual(EventName))
-		{
-			for (int x = Events[i].Observers.Num() - 1; x >= 0; x--) {
-				if (Events[i].Observers[x].InputComponent == NULL)
-				{
-					Events[i].Observers.RemoveAt(x);
-					continue;
-				}
-				Events[i].Observers[x].InputComponent->ReceiveDataString(this, Events[i].Observers[x].InputName, Data);
-			}
-			return;
-		}
-	}
+	SendValue(EventName, FWireValue::MakeName(Data));
 }
 
 void UWireComponent::ReceiveDataString_Implementation(UWireComponent* Sender, FName InputName, FName Data)
 {
 
-}
\ No newline at end of file
+}
+
+// No implementation, needs to be implemented in blueprints.
+FVector UWireComponent::GetDataVector_Implementation(FName EventName)
+{
+	return FVector::ZeroVector;
+}
+
+void UWireComponent::SendDataVector_Implementation(UWireComponent* Sender, FName EventName, FName InputName, FVector Data)
+{
+	SendValue(EventName, FWireValue::MakeVector(Data));
+}
+
+void UWireComponent::ReceiveDataVector_Implementation(UWireComponent* Sender, FName InputName, FVector Data)
+{
+
+}
@@ -13,7 +13,69 @@ enum class EWireDataType : uint8
 	Bool = 0,
 	Int32,
 	Float,
-	String
+	String,
+	Vector
+};
+
+/* A single value carried on a wire. Only the member matching Type is meaningful. */
+USTRUCT(BlueprintType)
+struct SHOOTERGAME_API FWireValue
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
+	EWireDataType Type;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
+	bool BoolValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
+	int32 IntValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
+	float FloatValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
+	FName NameValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
+	FVector VectorValue;
+
+	FWireValue()
+		: Type(EWireDataType::Bool)
+		, BoolValue(false)
+		, IntValue(0)
+		, FloatValue(0.0f)
+		, NameValue(NAME_None)
+		, VectorValue(FVector::ZeroVector)
+	{
+	}
+
+	static FWireValue MakeBool(bool Value) { FWireValue Result; Result.Type = EWireDataType::Bool; Result.BoolValue = Value; return Result; }
+	static FWireValue MakeInt32(int32 Value) { FWireValue Result; Result.Type = EWireDataType::Int32; Result.IntValue = Value; return Result; }
+	static FWireValue MakeFloat(float Value) { FWireValue Result; Result.Type = EWireDataType::Float; Result.FloatValue = Value; return Result; }
+	static FWireValue MakeName(FName Value) { FWireValue Result; Result.Type = EWireDataType::String; Result.NameValue = Value; return Result; }
+	static FWireValue MakeVector(const FVector& Value) { FWireValue Result; Result.Type = EWireDataType::Vector; Result.VectorValue = Value; return Result; }
+
+	bool operator==(const FWireValue& Other) const
+	{
+		if (Type != Other.Type)
+		{
+			return false;
+		}
+
+		switch (Type)
+		{
+		case EWireDataType::Bool:	return BoolValue == Other.BoolValue;
+		case EWireDataType::Int32:	return IntValue == Other.IntValue;
+		case EWireDataType::Float:	return FloatValue == Other.FloatValue;
+		case EWireDataType::String:	return NameValue == Other.NameValue;
+		case EWireDataType::Vector:	return VectorValue == Other.VectorValue;
+		}
+		return false;
+	}
+
+	bool operator!=(const FWireValue& Other) const { return !(*this == Other); }
 };
 
 /* Contains the actor and the message identifier. */
@@ -22,9 +84,9 @@ struct FWireConnectedInputInfo
 {
 	GENERATED_USTRUCT_BODY()
 
-	/* This is the input actor we are sending data to. */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
-	UWireComponent* InputComponent;
+	/* This is the input actor we are sending data to. Weak so a destroyed observer can never be called. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Circuit|Wire")
+	TWeakObjectPtr<UWireComponent> InputComponent;
 
 	/* Input actor uses this as a message identifier. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
@@ -48,6 +110,27 @@ struct FWireEvent
 	/* Each observer is sent a message with a data type from an output actor. */
 	//UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
 	TArray<FWireConnectedInputInfo> Observers;
+
+	/* Last value sent on this event. Only valid once bHasCurrentValue is set. */
+	UPROPERTY(Transient, VisibleAnywhere, BlueprintReadOnly, Category = "Circuit|Wire")
+	FWireValue CurrentValue;
+
+	bool bHasCurrentValue = false;
+};
+
+/* Reverse of FWireConnectedInputInfo, kept on the observer so it can find every wire feeding it. */
+USTRUCT(BlueprintType)
+struct FWireConnectedOutputInfo
+{
+	GENERATED_USTRUCT_BODY()
+
+	/* The output actor sending data to this input. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Circuit|Wire")
+	TWeakObjectPtr<UWireComponent> OutputComponent;
+
+	/* Event on OutputComponent this input is observing. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
+	FName EventName;
 };
 
 USTRUCT(BlueprintType)
@@ -55,8 +138,8 @@ struct FWireListen
 {
 	GENERATED_USTRUCT_BODY()
 
-	//UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wire|Data")
-	TArray<UWireComponent*> OutputComponents;
+	/* Every output event wired into this input. */
+	TArray<FWireConnectedOutputInfo> Connections;
 
 	/* In game friendly name to allow searching event names. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire")
@@ -80,7 +163,29 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or the component is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
+
+	virtual void OnComponentCreated() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditImport() override;
+#endif
+
+	/* Stable identifier used by UWireSubsystem to save and restore connections. Regenerated when the component is copy/pasted. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Wire", meta = (DisplayName = "Wire GUID"))
+	FGuid WireGuid;
+
+	/* Used by the save system when respawning a saved contraption, so connections can be matched back to it. */
+	UFUNCTION(BlueprintCallable, Category = "Wire|Save")
+	void SetWireGuid(FGuid NewGuid);
+
+	/* GUID derived from the level and the component's path in it, for components that were saved without one. */
+	FGuid MakeStableWireGuid() const;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wire")
 	TArray<FWireListen> Inputs;
 
@@ -105,6 +210,13 @@ public:
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Get Event Data (string)"))
 	FName GetDataString(FName EventName);
 
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Get Event Data (vector)"))
+	FVector GetDataVector(FName EventName);
+
+	/* Current value of an event. Uses the last value sent, only asking the Blueprint getters if nothing has been sent yet. */
+	UFUNCTION(BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Get Event Data (value)"))
+	FWireValue GetValue(FName EventName);
+
 	/* Adds observers to any event. Updates observer with current event variable value. */
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Add Observer to Event"))
 		bool AddObserverToActorEvent(UWireComponent* OutputActor, UWireComponent* Observer, FName InputName, FName EventName);
@@ -113,11 +225,47 @@ public:
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Disconnect Observer from Event"))
 		bool DisconnectObserverFromActorEvent(UWireComponent* Observer, FName InputName, FName EventName);
 
-	/* Removes observers from a specific event. */
+	/* Removes every wire connected to this component, both to its outputs and from its inputs. */
 	UFUNCTION(BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Disconnect All Wires"))
 		void DisconnectFromAllWires();
 
+	/* Returns the index into Events for EventName, or INDEX_NONE. */
+	int32 FindEventIndex(FName EventName) const;
+
+	/* Returns the index into Inputs for InputName, or INDEX_NONE. */
+	int32 FindInputIndex(FName InputName) const;
+
+private:
+	/* Name to index lookups. Events/Inputs are editable from Blueprint, so a hit is checked against the array before use. */
+	mutable TMap<FName, int32> EventIndexCache;
+	mutable TMap<FName, int32> InputIndexCache;
+
+	/* Removes the observer side of a single link. */
+	void RemoveIncomingLink(int32 InputIndex, const UWireComponent* Output, FName EventName);
+
+public:
+
 	/* Messaging System */
+
+	/*
+	* Native send path. Every typed SendData* ends up here. Observers get ReceiveValue called directly,
+	* Blueprint receive events are only dispatched for observers with bDispatchBlueprintEvents set.
+	* Values whose type doesn't match the event's EnumType are dropped with a warning.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Send Message (value)"))
+		void SendValue(FName EventName, const FWireValue& Value);
+
+	/* Called on an observer for every value sent to one of its inputs. */
+	virtual void ReceiveValue(UWireComponent* Sender, FName InputName, const FWireValue& Value);
+
+	DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnWireValueReceived, UWireComponent* /* Sender */, FName /* InputName */, const FWireValue& /* Value */);
+	/* Native listeners, called without going through ProcessEvent. */
+	FOnWireValueReceived OnValueReceived;
+
+	/* When false only native listeners are notified, which skips the Blueprint VM entirely for pure C++ devices. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wire")
+	bool bDispatchBlueprintEvents;
+
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FReceiveDataBool, UWireComponent*, Sender, FName, InputName, bool, Data);
 	UPROPERTY(BlueprintAssignable, Category = "Wire|Data")
 		FReceiveDataBool ReceiveDataBool;
@@ -141,5 +289,10 @@ public:
 		void SendDataString(UWireComponent* Sender, FName EventName, FName InputName, FName Data);
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Receive Message (string)"))
 		void ReceiveDataString(UWireComponent* Sender, FName InputName, FName Data);
-		
+
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Send Message (vector)"))
+		void SendDataVector(UWireComponent* Sender, FName EventName, FName InputName, FVector Data);
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Wire|Data", meta = (DisplayName = "Receive Message (vector)"))
+		void ReceiveDataVector(UWireComponent* Sender, FName InputName, FVector Data);
+
 };
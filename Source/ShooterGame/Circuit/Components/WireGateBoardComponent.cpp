@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Circuit/Components/WireGateBoardComponent.h"
+#include "Circuit/Subsystems/WireSubsystem.h"
+
+static float WireValueToSignal(const FWireValue& Value)
+{
+	switch (Value.Type)
+	{
+	case EWireDataType::Bool:	return Value.BoolValue ? 1.0f : 0.0f;
+	case EWireDataType::Int32:	return (float)Value.IntValue;
+	case EWireDataType::Float:	return Value.FloatValue;
+	case EWireDataType::String:	return Value.NameValue.IsNone() ? 0.0f : 1.0f;
+	case EWireDataType::Vector:	return Value.VectorValue.Size();
+	}
+	return 0.0f;
+}
+
+UWireGateBoardComponent::UWireGateBoardComponent()
+{
+	// Boards are run by UWireSubsystem at wire.TickRate
+	PrimaryComponentTick.bCanEverTick = false;
+
+	// Gates are native, nothing to tell Blueprints about unless a subclass wants it
+	bDispatchBlueprintEvents = false;
+
+	bInputsDirty = true;
+	bHasExecuted = false;
+}
+
+void UWireGateBoardComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	CompileGates();
+
+	if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(GetWorld()))
+	{
+		WireSubsystem->RegisterGateBoard(this);
+	}
+}
+
+void UWireGateBoardComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(GetWorld()))
+	{
+		WireSubsystem->UnregisterGateBoard(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UWireGateBoardComponent::SetGates(const TArray<FWireGate>& NewGates)
+{
+	Gates = NewGates;
+	CompileGates();
+}
+
+bool UWireGateBoardComponent::CompileGates()
+{
+	TArray<FName> InputNames;
+	InputNames.Reserve(Inputs.Num());
+	for (const FWireListen& Input : Inputs)
+	{
+		InputNames.Add(Input.EventName);
+	}
+
+	const FString OwnerName = GetOwner() ? FString::Printf(TEXT("%s.%s"), *GetOwner()->GetName(), *GetName()) : GetName();
+	const bool bCompiled = Program.Compile(Gates, InputNames, OwnerName);
+
+	OutputPorts.Reset();
+	for (int32 EventIdx = 0; EventIdx < Events.Num(); EventIdx++)
+	{
+		const FWireEvent& Event = Events[EventIdx];
+		const int32 Register = Program.FindRegister(Event.EventName);
+		if (Register == INDEX_NONE)
+		{
+			continue;
+		}
+
+		if (Event.EnumType != EWireDataType::Bool && Event.EnumType != EWireDataType::Int32 && Event.EnumType != EWireDataType::Float)
+		{
+			UE_LOG(LogCircuitWire, Warning, TEXT("%s: output %s is not a bool, int32 or float, gates can't drive it"), *OwnerName, *Event.EventName.ToString());
+			continue;
+		}
+
+		OutputPorts.Add({ EventIdx, Register, 0.0f });
+	}
+
+	// Carry over anything already received before the program existed
+	for (int32 InputIdx = 0; InputIdx < Inputs.Num(); InputIdx++)
+	{
+		for (const FWireConnectedOutputInfo& Connection : Inputs[InputIdx].Connections)
+		{
+			if (const UWireComponent* Output = Connection.OutputComponent.Get())
+			{
+				const int32 EventIndex = Output->FindEventIndex(Connection.EventName);
+				if (EventIndex != INDEX_NONE && Output->Events[EventIndex].bHasCurrentValue)
+				{
+					Program.SetRegister(Program.GetInputRegister(InputIdx), WireValueToSignal(Output->Events[EventIndex].CurrentValue));
+				}
+			}
+		}
+	}
+
+	bInputsDirty = true;
+	bHasExecuted = false;
+
+	return bCompiled;
+}
+
+float UWireGateBoardComponent::GetSignal(FName Signal) const
+{
+	const int32 Register = Program.FindRegister(Signal);
+	return Register != INDEX_NONE ? Program.GetRegister(Register) : 0.0f;
+}
+
+void UWireGateBoardComponent::ExecuteGates(float DeltaSeconds)
+{
+	if (!bInputsDirty && bHasExecuted && !Program.NeedsContinuousExecution())
+	{
+		return;
+	}
+
+	bInputsDirty = false;
+	Program.Execute(DeltaSeconds);
+
+	const bool bSendAll = !bHasExecuted;
+	bHasExecuted = true;
+
+	for (FOutputPort& Port : OutputPorts)
+	{
+		const float Value = Program.GetRegister(Port.Register);
+		if (!bSendAll && Value == Port.LastSent)
+		{
+			continue;
+		}
+		Port.LastSent = Value;
+
+		const FWireEvent& Event = Events[Port.EventIndex];
+		switch (Event.EnumType)
+		{
+		case EWireDataType::Bool:
+			SendValue(Event.EventName, FWireValue::MakeBool(Value != 0.0f));
+			break;
+		case EWireDataType::Int32:
+			SendValue(Event.EventName, FWireValue::MakeInt32(FMath::RoundToInt(Value)));
+			break;
+		case EWireDataType::Float:
+			SendValue(Event.EventName, FWireValue::MakeFloat(Value));
+			break;
+		}
+	}
+}
+
+void UWireGateBoardComponent::ReceiveValue(UWireComponent* Sender, FName InputName, const FWireValue& Value)
+{
+	const int32 InputIdx = FindInputIndex(InputName);
+	if (InputIdx != INDEX_NONE)
+	{
+		const float Signal = WireValueToSignal(Value);
+		const int32 Register = Program.GetInputRegister(InputIdx);
+		if (Program.GetRegister(Register) != Signal)
+		{
+			Program.SetRegister(Register, Signal);
+			bInputsDirty = true;
+		}
+	}
+
+	Super::ReceiveValue(Sender, InputName, Value);
+}
+
+float UWireGateBoardComponent::GetDataFloat_Implementation(FName EventName)
+{
+	return GetSignal(EventName);
+}
+
+bool UWireGateBoardComponent::GetDataBool_Implementation(FName EventName)
+{
+	return GetSignal(EventName) != 0.0f;
+}
+
+int32 UWireGateBoardComponent::GetDataInt32_Implementation(FName EventName)
+{
+	return FMath::RoundToInt(GetSignal(EventName));
+}
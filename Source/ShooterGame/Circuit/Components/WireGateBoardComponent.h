@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Circuit/Components/WireComponent.h"
+#include "Circuit/Subsystems/WireGateProgram.h"
+#include "WireGateBoardComponent.generated.h"
+
+/*
+* A circuit board of native logic gates. Inputs and Outputs work like any other wire component,
+* the gates in between are compiled into a FWireGateProgram and run by UWireSubsystem once per wire tick
+* (wire.TickRate) instead of each gate being its own actor with Blueprint events.
+*/
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class SHOOTERGAME_API UWireGateBoardComponent : public UWireComponent
+{
+	GENERATED_BODY()
+
+public:
+	UWireGateBoardComponent();
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	/* Gates on this board, in any order. Signal names can be board inputs or other gates' outputs. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Wire|Gates")
+	TArray<FWireGate> Gates;
+
+	/* Replaces the gates and recompiles. */
+	UFUNCTION(BlueprintCallable, Category = "Wire|Gates")
+	void SetGates(const TArray<FWireGate>& NewGates);
+
+	/* Rebuilds the program from Gates, Inputs and Events. Returns false if there is nothing to run. */
+	UFUNCTION(BlueprintCallable, Category = "Wire|Gates")
+	bool CompileGates();
+
+	/* Current value of any signal on the board. */
+	UFUNCTION(BlueprintCallable, Category = "Wire|Gates")
+	float GetSignal(FName Signal) const;
+
+	/* Runs the program if anything changed since the last pass and sends outputs whose value changed. */
+	void ExecuteGates(float DeltaSeconds);
+
+	virtual void ReceiveValue(UWireComponent* Sender, FName InputName, const FWireValue& Value) override;
+
+	virtual float GetDataFloat_Implementation(FName EventName) override;
+	virtual bool GetDataBool_Implementation(FName EventName) override;
+	virtual int32 GetDataInt32_Implementation(FName EventName) override;
+
+private:
+	struct FOutputPort
+	{
+		int32 EventIndex;
+		int32 Register;
+		float LastSent;
+	};
+
+	FWireGateProgram Program;
+
+	TArray<FOutputPort> OutputPorts;
+
+	bool bInputsDirty;
+
+	/* Outputs are always sent after the first pass, so observers start in sync. */
+	bool bHasExecuted;
+};
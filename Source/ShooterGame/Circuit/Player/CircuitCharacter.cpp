@@ -4,6 +4,7 @@
 #include "Player/ShooterCharacterMovement.h"
 #include "Circuit/Player/CircuitCharacterMovement.h"
 #include "Circuit/Components/CustomGravityComponent.h"
+#include "Circuit/Components/LagCompensationComponent.h"
 #include "Public/Weapons/ShooterWeapon.h"
 #include "Circuit/Player/CircuitCharacter.h"
 
@@ -14,6 +15,8 @@ ACircuitCharacter::ACircuitCharacter(const FObjectInitializer& ObjectInitializer
 	GravityComponent->SetupAttachment(GetCapsuleComponent());
 	GravityComponent->EffectedCharacter = this;
 
+	LagCompensation = ObjectInitializer.CreateDefaultSubobject<ULagCompensationComponent>(this, TEXT("LagCompensation"));
+
 	MaxUseDistance = 2500.0f;
 }
 
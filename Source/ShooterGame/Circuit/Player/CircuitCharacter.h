@@ -105,6 +105,10 @@ public:
 
 	class UCustomGravityComponent* GravityComponent;
 
+	/* Capsule history the server rewinds to when validating client hits */
+	UPROPERTY(VisibleAnywhere, Category = "Circuit|LagCompensation")
+	class ULagCompensationComponent* LagCompensation;
+
 	/** player noclip action */
 	UFUNCTION(BlueprintNativeEvent, Category = PlayerAbility)
 	void OnNoclip();
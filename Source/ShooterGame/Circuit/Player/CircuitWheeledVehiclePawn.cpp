@@ -3,6 +3,8 @@
 #include "ShooterGame.h"
 #include "Circuit/Player/CircuitWheeledVehiclePawn.h"
 
+FOnCircuitVehicleDriverChange ACircuitWheeledVehiclePawn::NotifyDriverEnter;
+FOnCircuitVehicleDriverChange ACircuitWheeledVehiclePawn::NotifyDriverExit;
 
 ACircuitWheeledVehiclePawn::ACircuitWheeledVehiclePawn(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -153,6 +155,8 @@ void ACircuitWheeledVehiclePawn::RespondToDriverDeath(class AShooterCharacter* D
 
 	DrivingPawn->OnCharacterDeath.RemoveDynamic(this, &ACircuitWheeledVehiclePawn::RespondToDriverDeath);
 
+	NotifyDriverExit.Broadcast(this, DrivingPawn);
+
 	Controller->Possess(DrivingPawn);
 	DrivingPawn = nullptr;
 }
@@ -196,6 +200,8 @@ void ACircuitWheeledVehiclePawn::OnUse_Implementation(ACircuitCharacter* Instiga
 
 			DrivingPawn->OnCharacterDeath.AddDynamic(this, &ACircuitWheeledVehiclePawn::RespondToDriverDeath);
 
+			NotifyDriverEnter.Broadcast(this, DrivingPawn);
+
 			DrivingPawn->Controller->Possess(this);
 			//OnStartEnter(InstigatingPlayer);
 		}
@@ -211,6 +217,8 @@ void ACircuitWheeledVehiclePawn::OnUse_Implementation(ACircuitCharacter* Instiga
 
 			DrivingPawn->OnCharacterDeath.RemoveDynamic(this, &ACircuitWheeledVehiclePawn::RespondToDriverDeath);
 
+			NotifyDriverExit.Broadcast(this, DrivingPawn);
+
 			Controller->Possess(DrivingPawn);
 			DrivingPawn = nullptr;
 
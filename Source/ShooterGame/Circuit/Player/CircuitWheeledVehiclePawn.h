@@ -10,6 +10,10 @@
 #include "WheeledVehiclePawn.h"
 #include "CircuitWheeledVehiclePawn.generated.h"
 
+class ACircuitWheeledVehiclePawn;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnCircuitVehicleDriverChange, ACircuitWheeledVehiclePawn*, ACircuitCharacter* /* driver */);
+
 /**
  * 
  */
@@ -32,6 +36,12 @@ public:
 	UPROPERTY()
 	ACircuitCharacter* DrivingPawn;
 
+	/** Global notification when a character is seated as the driver (server only). Needed for replication graph. */
+	static FOnCircuitVehicleDriverChange NotifyDriverEnter;
+
+	/** Global notification when the driver leaves the vehicle, including on death (server only). Needed for replication graph. */
+	static FOnCircuitVehicleDriverChange NotifyDriverExit;
+
 	// Returns true if player has space to leave vehicle
 	//UPROPERTY(BlueprintCallable, Category = "Vehicle|Utility")
 	bool CanPlayerExitVehicle(ACircuitCharacter* ExitingPlayer);
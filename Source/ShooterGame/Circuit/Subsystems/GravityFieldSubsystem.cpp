@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Circuit/Subsystems/GravityFieldSubsystem.h"
+#include "Circuit/Components/Gravity/BaseGravityComponent.h"
+#include "Algo/BinarySearch.h"
+
+/* Most a ballistic path turns in one segment, in radians (about 2 degrees). */
+static const float BallisticMaxSegmentBend = 0.035f;
+
+/* Shortest ballistic segment, so strong fields don't burn the segment budget on a few meters. */
+static const float BallisticMinSegmentLength = 100.0f;
+
+static bool IsInsideField(const FGravityFieldQuery::FEntry& Entry, const FVector& Position)
+{
+	return Entry.Box.IsInsideOrOn(Position) && FVector::DistSquared(Entry.SphereCenter, Position) <= Entry.SphereRadiusSquared;
+}
+
+FVector FGravityFieldQuery::GetGravity(const FVector& Position) const
+{
+	for (const FEntry& Entry : Fields)
+	{
+		if (IsInsideField(Entry, Position))
+		{
+			return Entry.Field->CalculateGravity(Position);
+		}
+	}
+
+	FVector Gravity = FVector::ZeroVector;
+	bool bInAdditiveField = false;
+	for (const FEntry& Entry : AdditiveFields)
+	{
+		if (IsInsideField(Entry, Position))
+		{
+			Gravity += Entry.Field->CalculateGravity(Position);
+			bInAdditiveField = true;
+		}
+	}
+
+	return bInAdditiveField ? Gravity : DefaultGravity;
+}
+
+void UGravityFieldSubsystem::Deinitialize()
+{
+	Fields.Empty();
+
+	Super::Deinitialize();
+}
+
+void UGravityFieldSubsystem::RegisterField(UBaseGravityComponent* Field)
+{
+	if (Field == nullptr || Fields.Contains(Field)) {
+		return;
+	}
+
+	// kept sorted by path name rather than registration order, which depends on streaming and spawn timing and differs between machines
+	Fields.RemoveAll([](const TWeakObjectPtr<UBaseGravityComponent>& Existing) { return !Existing.IsValid(); });
+	const FString PathName = Field->GetPathName();
+	const int32 Index = Algo::LowerBoundBy(Fields, PathName, [](const TWeakObjectPtr<UBaseGravityComponent>& Existing) {
+		return Existing->GetPathName();
+	});
+	Fields.Insert(Field, Index);
+}
+
+void UGravityFieldSubsystem::UnregisterField(UBaseGravityComponent* Field)
+{
+	Fields.Remove(Field);
+}
+
+void UGravityFieldSubsystem::GatherFields(const FVector& Center, float Radius, FGravityFieldQuery& OutQuery) const
+{
+	OutQuery.Fields.Reset();
+	OutQuery.AdditiveFields.Reset();
+	OutQuery.DefaultGravity = FVector(0.0f, 0.0f, GetWorld()->GetGravityZ());
+
+	for (const TWeakObjectPtr<UBaseGravityComponent>& FieldPtr : Fields)
+	{
+		UBaseGravityComponent* Field = FieldPtr.Get();
+		if (Field == nullptr || !Field->IsRegistered()) {
+			continue;
+		}
+
+		// bounds are read now rather than at registration, fields can move
+		const FBoxSphereBounds& FieldBounds = Field->Bounds;
+		if (FVector::DistSquared(FieldBounds.Origin, Center) > FMath::Square(FieldBounds.SphereRadius + Radius)) {
+			continue;
+		}
+
+		FGravityFieldQuery::FEntry Entry;
+		Entry.Field = Field;
+		Entry.Box = FieldBounds.GetBox();
+		Entry.SphereCenter = FieldBounds.Origin;
+		Entry.SphereRadiusSquared = FMath::Square(FieldBounds.SphereRadius);
+
+		if (Field->bIsAdditive) {
+			OutQuery.AdditiveFields.Add(Entry);
+		}
+		else {
+			OutQuery.Fields.Add(Entry);
+		}
+	}
+
+	// stable so fields with the same priority stay in path name order, the same on every machine
+	OutQuery.Fields.StableSort([](const FGravityFieldQuery::FEntry& A, const FGravityFieldQuery::FEntry& B) {
+		return A.Field->Priority < B.Field->Priority;
+	});
+}
+
+void UGravityFieldSubsystem::ComputeBallisticPath(const FVector& Start, const FVector& Velocity, float MaxDistance, int32 MaxSegments, TArray<FVector>& OutPoints) const
+{
+	OutPoints.Reset();
+	OutPoints.Add(Start);
+
+	if (MaxSegments <= 0 || MaxDistance <= 0.0f || Velocity.IsNearlyZero()) {
+		return;
+	}
+
+	FGravityFieldQuery Query;
+	GatherFields(Start, MaxDistance, Query);
+
+	FVector Position = Start;
+	FVector CurrentVelocity = Velocity;
+	float Travelled = 0.0f;
+
+	for (int32 Segment = 0; Segment < MaxSegments && Travelled < MaxDistance; Segment++)
+	{
+		const FVector Gravity = Query.GetGravity(Position);
+		const float Speed = CurrentVelocity.Size();
+		if (Speed <= KINDA_SMALL_NUMBER) {
+			break;
+		}
+
+		const float Remaining = MaxDistance - Travelled;
+
+		// only gravity across the path bends it, keep the turn per segment under BallisticMaxSegmentBend
+		const FVector Forward = CurrentVelocity / Speed;
+		const float BendingGravity = (Gravity - Forward * FVector::DotProduct(Gravity, Forward)).Size();
+
+		float SegmentLength = BendingGravity > KINDA_SMALL_NUMBER ? BallisticMaxSegmentBend * Speed * Speed / BendingGravity : Remaining;
+		SegmentLength = FMath::Max3(SegmentLength, BallisticMinSegmentLength, Remaining / (MaxSegments - Segment));
+		SegmentLength = FMath::Min(SegmentLength, Remaining);
+
+		// constant gravity over the segment, so the midpoint velocity gives the exact parabola
+		const float DeltaTime = SegmentLength / Speed;
+		const FVector NextVelocity = CurrentVelocity + Gravity * DeltaTime;
+		const FVector NextPosition = Position + (CurrentVelocity + NextVelocity) * 0.5f * DeltaTime;
+
+		Travelled += FVector::Dist(Position, NextPosition);
+		Position = NextPosition;
+		CurrentVelocity = NextVelocity;
+
+		OutPoints.Add(Position);
+	}
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GravityFieldSubsystem.generated.h"
+
+class UBaseGravityComponent;
+
+/*
+ * The gravity fields near one query, gathered once so a whole trajectory can be sampled without going back to the world.
+ * Sampling follows UCustomGravityComponent::CalculateCurrentGravity: the first non additive field containing the point wins
+ * (lowest Priority first), otherwise every additive field containing it is summed, otherwise world gravity.
+ */
+struct FGravityFieldQuery
+{
+	struct FEntry
+	{
+		UBaseGravityComponent* Field = nullptr;
+		FBox Box;
+		FVector SphereCenter;
+		float SphereRadiusSquared = 0.0f;
+	};
+
+	TArray<FEntry> Fields;
+
+	TArray<FEntry> AdditiveFields;
+
+	FVector DefaultGravity = FVector::ZeroVector;
+
+	FVector GetGravity(const FVector& Position) const;
+};
+
+/*
+ * Index of every UBaseGravityComponent in the world, for code that needs gravity at arbitrary points instead of whatever an
+ * overlapping UCustomGravityComponent has picked up. Also integrates ballistic paths through the fields for weapons.
+ */
+UCLASS()
+class SHOOTERGAME_API UGravityFieldSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void RegisterField(UBaseGravityComponent* Field);
+	void UnregisterField(UBaseGravityComponent* Field);
+
+	/* Every field whose bounds reach within Radius of Center */
+	void GatherFields(const FVector& Center, float Radius, FGravityFieldQuery& OutQuery) const;
+
+	/*
+	 * Points along a shot fired from Start at Velocity, until MaxDistance has been travelled or MaxSegments are used.
+	 * Segments are long where gravity is weak or along the path and shorten where it bends the shot, but never so short that MaxDistance
+	 * can't be covered in the segments left. Only depends on the inputs and the fields, so a client and server get the same points.
+	 */
+	void ComputeBallisticPath(const FVector& Start, const FVector& Velocity, float MaxDistance, int32 MaxSegments, TArray<FVector>& OutPoints) const;
+
+private:
+	/* Sorted by path name, so queries list fields in the same order on every machine */
+	TArray<TWeakObjectPtr<UBaseGravityComponent>> Fields;
+};
@@ -0,0 +1,315 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Circuit/Subsystems/WireGateProgram.h"
+#include "Circuit/Subsystems/WireSubsystem.h"
+
+static bool WireGateUsesInputB(EWireGateOp Op)
+{
+	switch (Op)
+	{
+	case EWireGateOp::Constant:
+	case EWireGateOp::Not:
+	case EWireGateOp::Timer:
+		return false;
+	default:
+		return true;
+	}
+}
+
+static bool WireGateUsesInputA(EWireGateOp Op)
+{
+	return Op != EWireGateOp::Constant;
+}
+
+static bool WireGateHasState(EWireGateOp Op)
+{
+	return Op == EWireGateOp::Timer || Op == EWireGateOp::Latch;
+}
+
+bool FWireGateProgram::Compile(const TArray<FWireGate>& Gates, const TArray<FName>& InputNames, const FString& OwnerName)
+{
+	Reset();
+
+	// Register 0 is the constant zero every unconnected operand reads
+	int32 NumRegisters = 1;
+	for (FName InputName : InputNames)
+	{
+		if (!InputName.IsNone())
+		{
+			SignalRegisters.Add(InputName, NumRegisters);
+		}
+		NumRegisters++;
+	}
+
+	TArray<int32> GateOutputs;
+	GateOutputs.SetNumUninitialized(Gates.Num());
+	for (int32 GateIdx = 0; GateIdx < Gates.Num(); GateIdx++)
+	{
+		const FName Output = Gates[GateIdx].Output;
+		if (Output.IsNone())
+		{
+			// Nothing reads it, but it still needs somewhere to write
+			GateOutputs[GateIdx] = NumRegisters++;
+			continue;
+		}
+
+		if (const int32* Existing = SignalRegisters.Find(Output))
+		{
+			// A gate driving a board input would be overwritten by every wire event, so the board can't be trusted to do what it says
+			if (*Existing <= InputNames.Num())
+			{
+				UE_LOG(LogCircuitWire, Error, TEXT("%s: gate %d writes %s, which is a board input. The board was not compiled"), *OwnerName, GateIdx, *Output.ToString());
+				Reset();
+				return false;
+			}
+
+			UE_LOG(LogCircuitWire, Warning, TEXT("%s: gate %d writes %s, which is already another gate's output"), *OwnerName, GateIdx, *Output.ToString());
+			GateOutputs[GateIdx] = *Existing;
+			continue;
+		}
+
+		SignalRegisters.Add(Output, NumRegisters);
+		GateOutputs[GateIdx] = NumRegisters++;
+	}
+
+	if (NumRegisters > MAX_uint16)
+	{
+		UE_LOG(LogCircuitWire, Warning, TEXT("%s: circuit board needs %d registers, the limit is %d"), *OwnerName, NumRegisters, (int32)MAX_uint16);
+		Reset();
+		return false;
+	}
+
+	auto ResolveOperand = [this, &OwnerName](int32 GateIdx, FName Signal) -> int32
+	{
+		if (Signal.IsNone())
+		{
+			return 0;
+		}
+		if (const int32* Register = SignalRegisters.Find(Signal))
+		{
+			return *Register;
+		}
+		UE_LOG(LogCircuitWire, Warning, TEXT("%s: gate %d reads unknown signal %s, using 0"), *OwnerName, GateIdx, *Signal.ToString());
+		return 0;
+	};
+
+	TArray<int32> OperandA, OperandB;
+	OperandA.SetNumUninitialized(Gates.Num());
+	OperandB.SetNumUninitialized(Gates.Num());
+
+	// Which gates write each register, so dependents can be found without a search
+	TMultiMap<int32, int32> Writers;
+	for (int32 GateIdx = 0; GateIdx < Gates.Num(); GateIdx++)
+	{
+		const FWireGate& Gate = Gates[GateIdx];
+		OperandA[GateIdx] = WireGateUsesInputA(Gate.Op) ? ResolveOperand(GateIdx, Gate.InputA) : 0;
+		OperandB[GateIdx] = WireGateUsesInputB(Gate.Op) ? ResolveOperand(GateIdx, Gate.InputB) : 0;
+		Writers.Add(GateOutputs[GateIdx], GateIdx);
+	}
+
+	// Kahn's algorithm, ties broken by declaration order
+	TArray<int32> InDegree;
+	InDegree.SetNumZeroed(Gates.Num());
+	TArray<TArray<int32>> Dependents;
+	Dependents.SetNum(Gates.Num());
+	TArray<TArray<int32>> Dependencies;
+	Dependencies.SetNum(Gates.Num());
+	TArray<int32, TInlineAllocator<4>> Sources;
+	for (int32 GateIdx = 0; GateIdx < Gates.Num(); GateIdx++)
+	{
+		for (int32 Operand : { OperandA[GateIdx], OperandB[GateIdx] })
+		{
+			if (Operand == 0)
+			{
+				continue;
+			}
+			Sources.Reset();
+			Writers.MultiFind(Operand, Sources);
+			for (int32 Source : Sources)
+			{
+				if (Source != GateIdx)
+				{
+					Dependents[Source].Add(GateIdx);
+					Dependencies[GateIdx].Add(Source);
+					InDegree[GateIdx]++;
+				}
+			}
+		}
+	}
+
+	TArray<int32> Order;
+	Order.Reserve(Gates.Num());
+	TArray<bool> bOrdered;
+	bOrdered.SetNumZeroed(Gates.Num());
+	auto AddToOrder = [&Order, &bOrdered](int32 GateIdx)
+	{
+		bOrdered[GateIdx] = true;
+		Order.Add(GateIdx);
+	};
+
+	for (int32 GateIdx = 0; GateIdx < Gates.Num(); GateIdx++)
+	{
+		if (InDegree[GateIdx] == 0)
+		{
+			AddToOrder(GateIdx);
+		}
+	}
+
+	// When Kahn stalls, everything left is in a loop or downstream of one. Break one loop by running a gate on it early, so it reads
+	// last pass's values, and carry on sorting. Gates after the loop then still run after it and see this pass's results.
+	TArray<bool> bVisited;
+	int32 Head = 0;
+	int32 FirstUnordered = 0;
+	for (;;)
+	{
+		for (; Head < Order.Num(); Head++)
+		{
+			for (int32 Dependent : Dependents[Order[Head]])
+			{
+				if (!bOrdered[Dependent] && --InDegree[Dependent] == 0)
+				{
+					AddToOrder(Dependent);
+				}
+			}
+		}
+
+		if (Order.Num() == Gates.Num())
+		{
+			break;
+		}
+
+		while (bOrdered[FirstUnordered])
+		{
+			FirstUnordered++;
+		}
+
+		// Every unordered gate waits on another unordered gate, so walking back through those must come round to a gate on the loop
+		bVisited.Reset();
+		bVisited.SetNumZeroed(Gates.Num());
+		int32 LoopGate = FirstUnordered;
+		while (!bVisited[LoopGate])
+		{
+			bVisited[LoopGate] = true;
+			for (int32 Dependency : Dependencies[LoopGate])
+			{
+				if (!bOrdered[Dependency])
+				{
+					LoopGate = Dependency;
+					break;
+				}
+			}
+		}
+
+		AddToOrder(LoopGate);
+	}
+
+	Instructions.Reserve(Order.Num());
+	int32 NumState = 0;
+	for (int32 GateIdx : Order)
+	{
+		const FWireGate& Gate = Gates[GateIdx];
+
+		FInstruction& Instruction = Instructions.AddDefaulted_GetRef();
+		Instruction.Op = Gate.Op;
+		Instruction.A = (uint16)OperandA[GateIdx];
+		Instruction.B = (uint16)OperandB[GateIdx];
+		Instruction.Out = (uint16)GateOutputs[GateIdx];
+		Instruction.StateIndex = WireGateHasState(Gate.Op) ? (uint16)NumState++ : 0;
+		Instruction.Param = Gate.Param;
+	}
+
+	Registers.SetNumZeroed(NumRegisters);
+	State.SetNumZeroed(NumState);
+
+	return Instructions.Num() > 0;
+}
+
+void FWireGateProgram::Execute(float DeltaSeconds)
+{
+	float* R = Registers.GetData();
+
+	for (const FInstruction& I : Instructions)
+	{
+		const bool bA = R[I.A] != 0.0f;
+		const bool bB = R[I.B] != 0.0f;
+
+		float Result = 0.0f;
+		switch (I.Op)
+		{
+		case EWireGateOp::Constant:		Result = I.Param; break;
+		case EWireGateOp::And:			Result = (bA && bB) ? 1.0f : 0.0f; break;
+		case EWireGateOp::Or:			Result = (bA || bB) ? 1.0f : 0.0f; break;
+		case EWireGateOp::Not:			Result = bA ? 0.0f : 1.0f; break;
+		case EWireGateOp::Xor:			Result = (bA != bB) ? 1.0f : 0.0f; break;
+		case EWireGateOp::Nand:			Result = (bA && bB) ? 0.0f : 1.0f; break;
+		case EWireGateOp::Nor:			Result = (bA || bB) ? 0.0f : 1.0f; break;
+		case EWireGateOp::Equal:		Result = FMath::IsNearlyEqual(R[I.A], R[I.B]) ? 1.0f : 0.0f; break;
+		case EWireGateOp::NotEqual:		Result = FMath::IsNearlyEqual(R[I.A], R[I.B]) ? 0.0f : 1.0f; break;
+		case EWireGateOp::Greater:		Result = R[I.A] > R[I.B] ? 1.0f : 0.0f; break;
+		case EWireGateOp::GreaterEqual:	Result = R[I.A] >= R[I.B] ? 1.0f : 0.0f; break;
+		case EWireGateOp::Less:			Result = R[I.A] < R[I.B] ? 1.0f : 0.0f; break;
+		case EWireGateOp::LessEqual:	Result = R[I.A] <= R[I.B] ? 1.0f : 0.0f; break;
+		case EWireGateOp::Add:			Result = R[I.A] + R[I.B]; break;
+		case EWireGateOp::Subtract:		Result = R[I.A] - R[I.B]; break;
+		case EWireGateOp::Multiply:		Result = R[I.A] * R[I.B]; break;
+		case EWireGateOp::Timer:
+		{
+			float& Elapsed = State[I.StateIndex];
+			Elapsed = bA ? FMath::Min(Elapsed + DeltaSeconds, I.Param) : 0.0f;
+			Result = (bA && Elapsed >= I.Param) ? 1.0f : 0.0f;
+			break;
+		}
+		case EWireGateOp::Latch:
+		{
+			float& Latched = State[I.StateIndex];
+			if (bA)
+			{
+				Latched = 1.0f;
+			}
+			if (bB)
+			{
+				Latched = 0.0f;
+			}
+			Result = Latched;
+			break;
+		}
+		}
+
+		R[I.Out] = Result;
+	}
+}
+
+void FWireGateProgram::Reset()
+{
+	Instructions.Reset();
+	Registers.Reset();
+	State.Reset();
+	SignalRegisters.Reset();
+}
+
+int32 FWireGateProgram::FindRegister(FName Signal) const
+{
+	const int32* Register = SignalRegisters.Find(Signal);
+	return Register ? *Register : INDEX_NONE;
+}
+
+void FWireGateProgram::SetRegister(int32 Register, float Value)
+{
+	if (Register > 0 && Registers.IsValidIndex(Register))
+	{
+		Registers[Register] = Value;
+	}
+}
+
+bool FWireGateProgram::NeedsContinuousExecution() const
+{
+	for (const FInstruction& I : Instructions)
+	{
+		if (I.Op == EWireGateOp::Timer && Registers[I.A] != 0.0f && State[I.StateIndex] < I.Param)
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WireGateProgram.generated.h"
+
+UENUM(BlueprintType)
+enum class EWireGateOp : uint8
+{
+	/* Output = Param */
+	Constant = 0,
+	And,
+	Or,
+	Not,
+	Xor,
+	Nand,
+	Nor,
+	Equal,
+	NotEqual,
+	Greater,
+	GreaterEqual,
+	Less,
+	LessEqual,
+	Add,
+	Subtract,
+	Multiply,
+	/* Output goes true once A has been true for Param seconds, false as soon as A is false. */
+	Timer,
+	/* Set by A, reset by B. Reset wins. */
+	Latch
+};
+
+/*
+* One gate on a circuit board. Signals are referenced by name: a board input, another gate's output, or None for zero.
+* Any non-zero signal counts as true.
+*/
+USTRUCT(BlueprintType)
+struct SHOOTERGAME_API FWireGate
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire|Gate")
+	EWireGateOp Op;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire|Gate")
+	FName InputA;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire|Gate")
+	FName InputB;
+
+	/* Signal written by this gate. If it matches one of the board's outputs that event is sent whenever the value changes. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire|Gate")
+	FName Output;
+
+	/* Constant value or timer delay in seconds. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Circuit|Wire|Gate")
+	float Param;
+
+	FWireGate()
+		: Op(EWireGateOp::And)
+		, InputA(NAME_None)
+		, InputB(NAME_None)
+		, Output(NAME_None)
+		, Param(0.0f)
+	{
+	}
+};
+
+/*
+* A compiled circuit board: gates flattened into instructions over a float register file.
+*
+* Register 0 is always zero, followed by one register per board input, then one per gate output.
+* Instructions are topologically sorted so a single pass settles the board. Each feedback loop is broken
+* at one of its gates, and that gate reads the previous pass's value. This is how latches built out of
+* plain gates behave in game. Gates downstream of a loop are still sorted after it.
+*/
+class SHOOTERGAME_API FWireGateProgram
+{
+public:
+	/*
+	* Compiles Gates against the board's input names. Returns false if nothing could be compiled, or if a gate writes a board input.
+	* Other problems with individual gates are logged with OwnerName and the gate is still compiled with the bad operand as zero.
+	*/
+	bool Compile(const TArray<FWireGate>& Gates, const TArray<FName>& InputNames, const FString& OwnerName);
+
+	/* Runs every instruction once. DeltaSeconds is only used by timers. */
+	void Execute(float DeltaSeconds);
+
+	void Reset();
+
+	/* Register for a named signal, or INDEX_NONE. */
+	int32 FindRegister(FName Signal) const;
+
+	int32 GetInputRegister(int32 InputIndex) const { return 1 + InputIndex; }
+
+	float GetRegister(int32 Register) const { return Registers.IsValidIndex(Register) ? Registers[Register] : 0.0f; }
+	void SetRegister(int32 Register, float Value);
+
+	/* True if a pass could change outputs without any input changing (running timers). */
+	bool NeedsContinuousExecution() const;
+
+	int32 NumInstructions() const { return Instructions.Num(); }
+
+private:
+	struct FInstruction
+	{
+		EWireGateOp Op;
+		uint16 A;
+		uint16 B;
+		uint16 Out;
+		/* Index into State for timers/latches. */
+		uint16 StateIndex;
+		float Param;
+	};
+
+	TArray<FInstruction> Instructions;
+	TArray<float> Registers;
+	TArray<float> State;
+	TMap<FName, int32> SignalRegisters;
+};
@@ -0,0 +1,273 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Circuit/Subsystems/WireProfiler.h"
+#include "Circuit/Subsystems/WireSubsystem.h"
+#include "Circuit/Components/WireComponent.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "DrawDebugHelpers.h"
+
+DEFINE_STAT(STAT_WireSendValue);
+DEFINE_STAT(STAT_WireBlueprintReceive);
+DEFINE_STAT(STAT_WirePropagations);
+DEFINE_STAT(STAT_WireThrottledSends);
+
+UE_TRACE_CHANNEL_DEFINE(WireChannel);
+
+TRACE_DECLARE_INT_COUNTER(WirePropagationsCounter, TEXT("Wire/Propagations"));
+TRACE_DECLARE_INT_COUNTER(WireMaxDepthCounter, TEXT("Wire/MaxChainDepth"));
+
+static int32 CVar_WireProfile = 0;
+static FAutoConsoleVariableRef CVarWireProfile(
+	TEXT("wire.Profile"),
+	CVar_WireProfile,
+	TEXT("Records per component wire statistics (propagations, fan-out, Blueprint time, chain depth).\n")
+	TEXT("0: off (default)\n")
+	TEXT("1: on"),
+	ECVF_Default);
+
+static int32 CVar_WireDebug = 0;
+static FAutoConsoleVariableRef CVarWireDebug(
+	TEXT("wire.Debug"),
+	CVar_WireDebug,
+	TEXT("Draws wire profiler statistics above each wire component. Turns on wire.Profile recording while set."),
+	ECVF_Cheat);
+
+static int32 CVar_WireMaxPropagationDepth = 128;
+static FAutoConsoleVariableRef CVarWireMaxPropagationDepth(
+	TEXT("wire.MaxPropagationDepth"),
+	CVar_WireMaxPropagationDepth,
+	TEXT("Sends nested deeper than this are dropped and logged, which breaks feedback loops. 0 is unlimited."),
+	ECVF_Default);
+
+static float CVar_WireDebugDrawDistance = 3000.0f;
+static FAutoConsoleVariableRef CVarWireDebugDrawDistance(
+	TEXT("wire.Debug.DrawDistance"),
+	CVar_WireDebugDrawDistance,
+	TEXT("Only wire components within this distance of the local player are drawn by wire.Debug."),
+	ECVF_Default);
+
+FAutoConsoleCommandWithWorldAndArgs WireDumpStatsCmd(TEXT("wire.DumpStats"), TEXT("Logs the busiest wire components. Optional arg: number of components (default 20)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(World))
+		{
+			const int32 TopN = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20;
+			WireSubsystem->GetProfiler().Dump(*GLog, TopN > 0 ? TopN : 20);
+		}
+	})
+);
+
+FAutoConsoleCommandWithWorldAndArgs WireResetStatsCmd(TEXT("wire.ResetStats"), TEXT("Clears wire profiler statistics."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWireSubsystem* WireSubsystem = UWorld::GetSubsystem<UWireSubsystem>(World))
+		{
+			WireSubsystem->GetProfiler().Reset();
+		}
+	})
+);
+
+/* Dropped sends are logged at most this often, with a count of how many were dropped since the last line. */
+static const double WireThrottleLogInterval = 5.0;
+
+static FString GetWireComponentDisplayName(const UWireComponent* Component)
+{
+	if (Component == nullptr)
+	{
+		return TEXT("None");
+	}
+	const AActor* Owner = Component->GetOwner();
+	return Owner ? FString::Printf(TEXT("%s.%s"), *Owner->GetName(), *Component->GetName()) : Component->GetName();
+}
+
+bool FWireProfiler::IsEnabled()
+{
+	return CVar_WireProfile > 0 || CVar_WireDebug > 0;
+}
+
+int32 FWireProfiler::GetMaxPropagationDepth()
+{
+	return CVar_WireMaxPropagationDepth;
+}
+
+FWireComponentStats& FWireProfiler::FindOrAddStats(const UWireComponent* Component)
+{
+	return ComponentStats.FindOrAdd(TWeakObjectPtr<const UWireComponent>(Component));
+}
+
+void FWireProfiler::RecordSend(const UWireComponent* Sender, FName EventName, int32 FanOut, int32 Depth, const UWireComponent* ChainRoot)
+{
+	FWireComponentStats& Stats = FindOrAddStats(Sender);
+	Stats.Propagations++;
+	Stats.PropagationsThisFrame++;
+	Stats.MaxFanOut = FMath::Max(Stats.MaxFanOut, FanOut);
+
+	int32& EventFanOut = Stats.EventFanOut.FindOrAdd(EventName);
+	EventFanOut = FMath::Max(EventFanOut, FanOut);
+
+	FramePropagations++;
+
+	if (ChainRoot)
+	{
+		FWireComponentStats& RootStats = FindOrAddStats(ChainRoot);
+		RootStats.MaxChainDepth = FMath::Max(RootStats.MaxChainDepth, Depth);
+	}
+
+	if (Depth > FrameMaxDepth)
+	{
+		FrameMaxDepth = Depth;
+		FrameLongestChainRoot = ChainRoot;
+	}
+}
+
+void FWireProfiler::RecordReceive(const UWireComponent* Receiver, double BlueprintSeconds)
+{
+	FWireComponentStats& Stats = FindOrAddStats(Receiver);
+	Stats.Receives++;
+	Stats.BlueprintSeconds += BlueprintSeconds;
+}
+
+void FWireProfiler::RecordThrottled(const UWireComponent* Sender, FName EventName, int32 Depth)
+{
+	// A dropped send changes what the circuit does, so it's counted and logged even with profiling off
+	TotalThrottled++;
+	ThrottledSinceLog++;
+
+	const double Now = FPlatformTime::Seconds();
+	if (Now - LastThrottleLogTime >= WireThrottleLogInterval)
+	{
+		UE_LOG(LogCircuitWire, Warning, TEXT("Wire chain from %s (event %s) hit wire.MaxPropagationDepth (%d), %d sends dropped since the last warning"),
+			*GetWireComponentDisplayName(Sender), *EventName.ToString(), Depth, ThrottledSinceLog);
+		LastThrottleLogTime = Now;
+		ThrottledSinceLog = 0;
+	}
+
+	// Per component stats are only pruned by EndFrame, which doesn't run while profiling is off
+	if (IsEnabled())
+	{
+		FindOrAddStats(Sender).Throttled++;
+	}
+}
+
+void FWireProfiler::EndFrame()
+{
+	SET_DWORD_STAT(STAT_WirePropagations, FramePropagations);
+	TRACE_COUNTER_SET(WirePropagationsCounter, FramePropagations);
+	TRACE_COUNTER_SET(WireMaxDepthCounter, FrameMaxDepth);
+
+	if (FrameMaxDepth > PeakDepth)
+	{
+		PeakDepth = FrameMaxDepth;
+		PeakChainRoot = FrameLongestChainRoot;
+	}
+
+	for (auto It = ComponentStats.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		It.Value().PropagationsThisFrame = 0;
+	}
+
+	FramePropagations = 0;
+	FrameMaxDepth = 0;
+	FrameLongestChainRoot = nullptr;
+}
+
+void FWireProfiler::DrawDebug(UWorld* World) const
+{
+#if ENABLE_DRAW_DEBUG
+	if (CVar_WireDebug <= 0 || World == nullptr)
+	{
+		return;
+	}
+
+	FVector ViewLocation = FVector::ZeroVector;
+	APlayerController* PC = World->GetFirstPlayerController();
+	if (PC == nullptr)
+	{
+		return;
+	}
+
+	FRotator ViewRotation;
+	PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	const float MaxDistSq = FMath::Square(CVar_WireDebugDrawDistance);
+
+	for (const TPair<TWeakObjectPtr<const UWireComponent>, FWireComponentStats>& Pair : ComponentStats)
+	{
+		const UWireComponent* Component = Pair.Key.Get();
+		if (Component == nullptr || Component->GetWorld() != World)
+		{
+			continue;
+		}
+
+		const FVector Location = Component->GetComponentLocation();
+		if (FVector::DistSquared(Location, ViewLocation) > MaxDistSq)
+		{
+			continue;
+		}
+
+		const FWireComponentStats& Stats = Pair.Value;
+		const FColor Color = Stats.Throttled > 0 ? FColor::Red : (Stats.PropagationsThisFrame > 0 ? FColor::Yellow : FColor::White);
+		const FString Text = FString::Printf(TEXT("sent %d  recv %d  fan-out %d\nchain %d  bp %.2fms%s"),
+			Stats.Propagations, Stats.Receives, Stats.MaxFanOut, Stats.MaxChainDepth, Stats.BlueprintSeconds * 1000.0,
+			Stats.Throttled > 0 ? *FString::Printf(TEXT("  throttled %d"), Stats.Throttled) : TEXT(""));
+
+		DrawDebugString(World, Location + FVector(0.f, 0.f, 50.f), Text, nullptr, Color, 0.f, true);
+	}
+
+	if (GEngine)
+	{
+		GEngine->AddOnScreenDebugMessage((uint64)((PTRINT)this), 0.f, FColor::Cyan,
+			FString::Printf(TEXT("Wire: %d components, peak chain %d from %s"), ComponentStats.Num(), PeakDepth, *GetWireComponentDisplayName(PeakChainRoot.Get())));
+	}
+#endif
+}
+
+void FWireProfiler::Dump(FOutputDevice& Ar, int32 TopN) const
+{
+	TArray<TPair<const UWireComponent*, const FWireComponentStats*>> Sorted;
+	Sorted.Reserve(ComponentStats.Num());
+	for (const TPair<TWeakObjectPtr<const UWireComponent>, FWireComponentStats>& Pair : ComponentStats)
+	{
+		if (const UWireComponent* Component = Pair.Key.Get())
+		{
+			Sorted.Emplace(Component, &Pair.Value);
+		}
+	}
+
+	Sorted.Sort([](const TPair<const UWireComponent*, const FWireComponentStats*>& A, const TPair<const UWireComponent*, const FWireComponentStats*>& B)
+	{
+		return A.Value->Propagations > B.Value->Propagations;
+	});
+
+	Ar.Logf(TEXT("Wire profiler: %d components, peak chain %d from %s, %d sends dropped%s"), Sorted.Num(), PeakDepth, *GetWireComponentDisplayName(PeakChainRoot.Get()),
+		TotalThrottled, IsEnabled() ? TEXT("") : TEXT(" (wire.Profile is off)"));
+
+	for (int32 Idx = 0; Idx < Sorted.Num() && Idx < TopN; Idx++)
+	{
+		const FWireComponentStats& Stats = *Sorted[Idx].Value;
+		Ar.Logf(TEXT("  %-48s sent %8d  recv %8d  fan-out %4d  chain %4d  bp %8.3fms  throttled %d"),
+			*GetWireComponentDisplayName(Sorted[Idx].Key), Stats.Propagations, Stats.Receives, Stats.MaxFanOut, Stats.MaxChainDepth,
+			Stats.BlueprintSeconds * 1000.0, Stats.Throttled);
+
+		for (const TPair<FName, int32>& Event : Stats.EventFanOut)
+		{
+			Ar.Logf(TEXT("      %s -> %d"), *Event.Key.ToString(), Event.Value);
+		}
+	}
+}
+
+void FWireProfiler::Reset()
+{
+	ComponentStats.Empty();
+	FramePropagations = 0;
+	FrameMaxDepth = 0;
+	FrameLongestChainRoot = nullptr;
+	PeakDepth = 0;
+	PeakChainRoot = nullptr;
+	TotalThrottled = 0;
+}
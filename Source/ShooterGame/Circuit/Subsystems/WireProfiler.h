@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+class UWireComponent;
+class UWorld;
+
+DECLARE_STATS_GROUP(TEXT("Wire"), STATGROUP_Wire, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wire Send Value"), STAT_WireSendValue, STATGROUP_Wire, SHOOTERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wire Blueprint Receive"), STAT_WireBlueprintReceive, STATGROUP_Wire, SHOOTERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Wire Propagations"), STAT_WirePropagations, STATGROUP_Wire, SHOOTERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Wire Throttled Sends"), STAT_WireThrottledSends, STATGROUP_Wire, SHOOTERGAME_API);
+
+/* Insights channel for wire propagation scopes. Enable with -trace=cpu,wire */
+UE_TRACE_CHANNEL_EXTERN(WireChannel, SHOOTERGAME_API);
+
+/* Accumulated numbers for a single wire component since the last reset. */
+struct FWireComponentStats
+{
+	/* Values this component sent. */
+	int32 Propagations = 0;
+
+	/* Values this component received. */
+	int32 Receives = 0;
+
+	/* Sends dropped because the chain was deeper than wire.MaxPropagationDepth. */
+	int32 Throttled = 0;
+
+	/* Widest fan-out seen on any one event. */
+	int32 MaxFanOut = 0;
+
+	/* Longest chain started by this component. */
+	int32 MaxChainDepth = 0;
+
+	/* Time spent in Blueprint ReceiveData* handlers on this component. */
+	double BlueprintSeconds = 0.0;
+
+	/* Sends in the current frame, used to colour the overlay. */
+	int32 PropagationsThisFrame = 0;
+
+	TMap<FName, int32> EventFanOut;
+};
+
+/*
+* Per world wire profiler, owned by UWireSubsystem.
+* Only records while wire.Profile is set so the send path stays cheap in normal play.
+*/
+class SHOOTERGAME_API FWireProfiler
+{
+public:
+	static bool IsEnabled();
+
+	/* 0 means unlimited. */
+	static int32 GetMaxPropagationDepth();
+
+	void RecordSend(const UWireComponent* Sender, FName EventName, int32 FanOut, int32 Depth, const UWireComponent* ChainRoot);
+	void RecordReceive(const UWireComponent* Receiver, double BlueprintSeconds);
+
+	/* Always counted and logged (rate limited), per component stats only while profiling. */
+	void RecordThrottled(const UWireComponent* Sender, FName EventName, int32 Depth);
+
+	/* Publishes per-frame counters and clears them. */
+	void EndFrame();
+
+	void DrawDebug(UWorld* World) const;
+
+	/* Logs the busiest components, sorted by propagation count. */
+	void Dump(FOutputDevice& Ar, int32 TopN) const;
+
+	void Reset();
+
+private:
+	FWireComponentStats& FindOrAddStats(const UWireComponent* Component);
+
+	TMap<TWeakObjectPtr<const UWireComponent>, FWireComponentStats> ComponentStats;
+
+	int32 FramePropagations = 0;
+	int32 FrameMaxDepth = 0;
+	TWeakObjectPtr<const UWireComponent> FrameLongestChainRoot;
+
+	/* Longest chain since the last reset. */
+	int32 PeakDepth = 0;
+	TWeakObjectPtr<const UWireComponent> PeakChainRoot;
+
+	/* Sends dropped by wire.MaxPropagationDepth since the last reset, profiling or not. */
+	int32 TotalThrottled = 0;
+
+	int32 ThrottledSinceLog = 0;
+	double LastThrottleLogTime = -DBL_MAX;
+};
@@ -0,0 +1,594 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Circuit/Subsystems/WireSubsystem.h"
+#include "Circuit/Components/WireGateBoardComponent.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Misc/FileHelper.h"
+
+DEFINE_LOG_CATEGORY(LogCircuitWire);
+
+static int32 CVar_WireTickRate = 20;
+static FAutoConsoleVariableRef CVarWireTickRate(
+	TEXT("wire.TickRate"),
+	CVar_WireTickRate,
+	TEXT("Defines how quickly wire ticks, adjust for quality or performance.\n")
+	TEXT("<=0: off\n")
+	TEXT("  20: normal quality (default)\n"),
+	ECVF_Scalability);
+
+/* At most this many wire ticks run in one frame, so a hitch does not turn into a burst of board evaluations. */
+static const int32 MaxWireTicksPerFrame = 4;
+
+namespace WireSave
+{
+	// 'WIRE'
+	static const uint32 Magic = 0x45524957;
+	// 2: vector values
+	static const uint16 Version = 2;
+
+	/* Interns names and components while the body is being written so each is stored once. */
+	struct FWriteTables
+	{
+		TArray<FName> Names;
+		TMap<FName, uint32> NameIndices;
+
+		TArray<const UWireComponent*> Components;
+		TMap<const UWireComponent*, uint32> ComponentIndices;
+
+		uint32 AddName(FName Name)
+		{
+			if (const uint32* Found = NameIndices.Find(Name))
+			{
+				return *Found;
+			}
+			const uint32 Index = Names.Add(Name);
+			NameIndices.Add(Name, Index);
+			return Index;
+		}
+
+		uint32 AddComponent(const UWireComponent* Component)
+		{
+			if (const uint32* Found = ComponentIndices.Find(Component))
+			{
+				return *Found;
+			}
+			const uint32 Index = Components.Add(Component);
+			ComponentIndices.Add(Component, Index);
+			return Index;
+		}
+	};
+
+	/* Event values received during a load, sent once every connection is back in place. */
+	struct FPendingValue
+	{
+		UWireComponent* Output;
+		FName EventName;
+		FWireValue Value;
+	};
+
+	/* A saved observer whose event and component were both found, hooked up once the whole save has been read. */
+	struct FPendingConnection
+	{
+		UWireComponent* Output;
+		int32 EventSlot;
+		UWireComponent* Observer;
+		FName InputName;
+		uint32 InputSlot;
+	};
+
+	static int32 ResolveSlot(const TArray<FWireEvent>& Slots, uint32 SavedSlot, FName Name)
+	{
+		if (Slots.IsValidIndex(SavedSlot) && Slots[SavedSlot].EventName == Name)
+		{
+			return SavedSlot;
+		}
+		return Slots.IndexOfByPredicate([Name](const FWireEvent& Event) { return Event.EventName == Name; });
+	}
+
+	static int32 ResolveSlot(const TArray<FWireListen>& Slots, uint32 SavedSlot, FName Name)
+	{
+		if (Slots.IsValidIndex(SavedSlot) && Slots[SavedSlot].EventName == Name)
+		{
+			return SavedSlot;
+		}
+		return Slots.IndexOfByPredicate([Name](const FWireListen& Input) { return Input.EventName == Name; });
+	}
+}
+
+void UWireSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UWireSubsystem::OnLevelAddedToWorld);
+}
+
+void UWireSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	ComponentsByGuid.Empty();
+	PendingLevelNetworks.Empty();
+	GateBoards.Empty();
+
+	Super::Deinitialize();
+}
+
+void UWireSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (CVar_WireTickRate > 0 && GateBoards.Num() > 0)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(UWireSubsystem_TickGateBoards);
+
+		const float WireTickInterval = 1.0f / CVar_WireTickRate;
+		GateTickAccumulator += DeltaTime;
+
+		int32 NumWireTicks = 0;
+		while (GateTickAccumulator >= WireTickInterval && NumWireTicks < MaxWireTicksPerFrame)
+		{
+			GateTickAccumulator -= WireTickInterval;
+			NumWireTicks++;
+
+			for (int32 BoardIdx = GateBoards.Num() - 1; BoardIdx >= 0; BoardIdx--)
+			{
+				if (UWireGateBoardComponent* Board = GateBoards[BoardIdx].Get())
+				{
+					Board->ExecuteGates(WireTickInterval);
+				}
+				else
+				{
+					GateBoards.RemoveAtSwap(BoardIdx);
+				}
+			}
+		}
+
+		if (NumWireTicks == MaxWireTicksPerFrame)
+		{
+			GateTickAccumulator = 0.0f;
+		}
+	}
+
+	if (FWireProfiler::IsEnabled())
+	{
+		Profiler.DrawDebug(GetWorld());
+		Profiler.EndFrame();
+	}
+}
+
+TStatId UWireSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UWireSubsystem, STATGROUP_Tickables);
+}
+
+void UWireSubsystem::RegisterWireComponent(UWireComponent* Component)
+{
+	if (Component == nullptr || !Component->WireGuid.IsValid())
+	{
+		return;
+	}
+
+	// Duplicated actors carry their source's GUID, and the first one registered keeps it so saves written before the copy still resolve
+	const TWeakObjectPtr<UWireComponent>* Existing = ComponentsByGuid.Find(Component->WireGuid);
+	if (Existing && Existing->IsValid() && Existing->Get() != Component)
+	{
+		const FGuid NewGuid = FGuid::NewGuid();
+		UE_LOG(LogCircuitWire, Warning, TEXT("UWireSubsystem %s has the same wire GUID as %s, giving it %s"), *Component->GetPathName(), *Existing->Get()->GetPathName(), *NewGuid.ToString());
+		Component->WireGuid = NewGuid;
+	}
+
+	ComponentsByGuid.Add(Component->WireGuid, Component);
+}
+
+void UWireSubsystem::UnregisterWireComponent(UWireComponent* Component)
+{
+	if (Component)
+	{
+		const TWeakObjectPtr<UWireComponent>* Found = ComponentsByGuid.Find(Component->WireGuid);
+		if (Found && Found->Get() == Component)
+		{
+			ComponentsByGuid.Remove(Component->WireGuid);
+		}
+	}
+}
+
+UWireComponent* UWireSubsystem::FindWireComponent(const FGuid& WireGuid) const
+{
+	const TWeakObjectPtr<UWireComponent>* Found = ComponentsByGuid.Find(WireGuid);
+	return Found ? Found->Get() : nullptr;
+}
+
+void UWireSubsystem::RegisterGateBoard(UWireGateBoardComponent* Board)
+{
+	if (Board)
+	{
+		GateBoards.AddUnique(Board);
+	}
+}
+
+void UWireSubsystem::UnregisterGateBoard(UWireGateBoardComponent* Board)
+{
+	GateBoards.RemoveSingleSwap(Board);
+}
+
+bool UWireSubsystem::SaveWireNetwork(TArray<uint8>& OutData, const ULevel* Level) const
+{
+	WireSave::FWriteTables Tables;
+
+	TArray<uint8> Body;
+	FMemoryWriter BodyAr(Body);
+
+	TArray<const UWireComponent*> Outputs;
+	for (const TPair<FGuid, TWeakObjectPtr<UWireComponent>>& Pair : ComponentsByGuid)
+	{
+		const UWireComponent* Component = Pair.Value.Get();
+		if (Component == nullptr || (Level && Component->GetComponentLevel() != Level))
+		{
+			continue;
+		}
+
+		if (Component->Events.ContainsByPredicate([](const FWireEvent& Event) { return Event.Observers.Num() > 0; }))
+		{
+			Outputs.Add(Component);
+		}
+	}
+
+	uint32 NumOutputs = Outputs.Num();
+	BodyAr.SerializeIntPacked(NumOutputs);
+
+	for (const UWireComponent* Output : Outputs)
+	{
+		uint32 OutputIndex = Tables.AddComponent(Output);
+		BodyAr.SerializeIntPacked(OutputIndex);
+
+		uint32 NumEvents = 0;
+		for (const FWireEvent& Event : Output->Events)
+		{
+			NumEvents += Event.Observers.Num() > 0 ? 1 : 0;
+		}
+		BodyAr.SerializeIntPacked(NumEvents);
+
+		// GetValue may fall back to the Blueprint getters, which are not const
+		UWireComponent* MutableOutput = const_cast<UWireComponent*>(Output);
+
+		for (int32 EventIdx = 0; EventIdx < Output->Events.Num(); EventIdx++)
+		{
+			const FWireEvent& Event = Output->Events[EventIdx];
+			if (Event.Observers.Num() == 0)
+			{
+				continue;
+			}
+
+			uint32 Slot = EventIdx;
+			uint32 NameIndex = Tables.AddName(Event.EventName);
+			uint8 Type = (uint8)Event.EnumType;
+			BodyAr.SerializeIntPacked(Slot);
+			BodyAr.SerializeIntPacked(NameIndex);
+			BodyAr << Type;
+
+			const FWireValue Value = MutableOutput->GetValue(Event.EventName);
+			switch (Event.EnumType)
+			{
+			case EWireDataType::Bool:
+			{
+				uint8 BoolValue = Value.BoolValue ? 1 : 0;
+				BodyAr << BoolValue;
+				break;
+			}
+			case EWireDataType::Int32:
+			{
+				int32 IntValue = Value.IntValue;
+				BodyAr << IntValue;
+				break;
+			}
+			case EWireDataType::Float:
+			{
+				float FloatValue = Value.FloatValue;
+				BodyAr << FloatValue;
+				break;
+			}
+			case EWireDataType::String:
+			{
+				uint32 ValueIndex = Tables.AddName(Value.NameValue);
+				BodyAr.SerializeIntPacked(ValueIndex);
+				break;
+			}
+			case EWireDataType::Vector:
+			{
+				FVector VectorValue = Value.VectorValue;
+				BodyAr << VectorValue;
+				break;
+			}
+			}
+
+			TArray<TPair<const UWireComponent*, FName>, TInlineAllocator<16>> LiveObservers;
+			for (const FWireConnectedInputInfo& Observer : Event.Observers)
+			{
+				if (const UWireComponent* InputComponent = Observer.InputComponent.Get())
+				{
+					LiveObservers.Emplace(InputComponent, Observer.InputName);
+				}
+			}
+
+			uint32 NumObservers = LiveObservers.Num();
+			BodyAr.SerializeIntPacked(NumObservers);
+
+			for (const TPair<const UWireComponent*, FName>& Observer : LiveObservers)
+			{
+				uint32 ObserverIndex = Tables.AddComponent(Observer.Key);
+				uint32 InputSlot = FMath::Max(Observer.Key->FindInputIndex(Observer.Value), 0);
+				uint32 InputNameIndex = Tables.AddName(Observer.Value);
+				BodyAr.SerializeIntPacked(ObserverIndex);
+				BodyAr.SerializeIntPacked(InputSlot);
+				BodyAr.SerializeIntPacked(InputNameIndex);
+			}
+		}
+	}
+
+	OutData.Reset();
+	FMemoryWriter Ar(OutData);
+
+	uint32 Magic = WireSave::Magic;
+	uint16 Version = WireSave::Version;
+	Ar << Magic << Version;
+
+	uint32 NumNames = Tables.Names.Num();
+	Ar.SerializeIntPacked(NumNames);
+	for (const FName& Name : Tables.Names)
+	{
+		FString NameString = Name.ToString();
+		Ar << NameString;
+	}
+
+	uint32 NumComponents = Tables.Components.Num();
+	Ar.SerializeIntPacked(NumComponents);
+	for (const UWireComponent* Component : Tables.Components)
+	{
+		FGuid Guid = Component->WireGuid;
+		Ar << Guid;
+	}
+
+	Ar.Serialize(Body.GetData(), Body.Num());
+
+	return !Ar.IsError();
+}
+
+bool UWireSubsystem::LoadWireNetwork(const TArray<uint8>& Data)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(UWireSubsystem_LoadWireNetwork);
+
+	FMemoryReader Ar(Data);
+
+	uint32 Magic = 0;
+	uint16 Version = 0;
+	Ar << Magic << Version;
+
+	if (Magic != WireSave::Magic || Version > WireSave::Version)
+	{
+		UE_LOG(LogCircuitWire, Warning, TEXT("UWireSubsystem::LoadWireNetwork unrecognized data (magic %08x, version %d)"), Magic, Version);
+		return false;
+	}
+
+	uint32 NumNames = 0;
+	Ar.SerializeIntPacked(NumNames);
+	if (Ar.IsError() || NumNames > (uint32)Data.Num())
+	{
+		return false;
+	}
+
+	TArray<FName> Names;
+	Names.Reserve(NumNames);
+	for (uint32 i = 0; i < NumNames; i++)
+	{
+		FString NameString;
+		Ar << NameString;
+		Names.Add(FName(*NameString));
+	}
+
+	uint32 NumComponents = 0;
+	Ar.SerializeIntPacked(NumComponents);
+	if (Ar.IsError() || NumComponents > (uint32)Data.Num())
+	{
+		return false;
+	}
+
+	TArray<UWireComponent*> Components;
+	Components.Reserve(NumComponents);
+	int32 NumMissing = 0;
+	for (uint32 i = 0; i < NumComponents; i++)
+	{
+		FGuid Guid;
+		Ar << Guid;
+		UWireComponent* Component = FindWireComponent(Guid);
+		NumMissing += Component ? 0 : 1;
+		Components.Add(Component);
+	}
+
+	auto GetName = [&Names](uint32 Index) { return Names.IsValidIndex(Index) ? Names[Index] : NAME_None; };
+	auto GetComponent = [&Components](uint32 Index) { return Components.IsValidIndex(Index) ? Components[Index] : nullptr; };
+
+	// Nothing is hooked up until the whole save has been read, so bad data leaves the network as it was rather than half restored
+	TArray<WireSave::FPendingValue> PendingValues;
+	TArray<WireSave::FPendingConnection> PendingConnections;
+
+	uint32 NumOutputs = 0;
+	Ar.SerializeIntPacked(NumOutputs);
+
+	for (uint32 OutputIdx = 0; OutputIdx < NumOutputs && !Ar.IsError(); OutputIdx++)
+	{
+		uint32 OutputIndex = 0;
+		uint32 NumEvents = 0;
+		Ar.SerializeIntPacked(OutputIndex);
+		Ar.SerializeIntPacked(NumEvents);
+
+		UWireComponent* Output = GetComponent(OutputIndex);
+
+		for (uint32 EventIdx = 0; EventIdx < NumEvents && !Ar.IsError(); EventIdx++)
+		{
+			uint32 Slot = 0;
+			uint32 NameIndex = 0;
+			uint8 Type = 0;
+			Ar.SerializeIntPacked(Slot);
+			Ar.SerializeIntPacked(NameIndex);
+			Ar << Type;
+
+			WireSave::FPendingValue Pending = { Output, GetName(NameIndex), FWireValue() };
+			FWireValue& Value = Pending.Value;
+			Value.Type = (EWireDataType)Type;
+
+			switch (Value.Type)
+			{
+			case EWireDataType::Bool:
+			{
+				uint8 BoolValue = 0;
+				Ar << BoolValue;
+				Value.BoolValue = BoolValue != 0;
+				break;
+			}
+			case EWireDataType::Int32:
+				Ar << Value.IntValue;
+				break;
+			case EWireDataType::Float:
+				Ar << Value.FloatValue;
+				break;
+			case EWireDataType::String:
+			{
+				uint32 ValueIndex = 0;
+				Ar.SerializeIntPacked(ValueIndex);
+				Value.NameValue = GetName(ValueIndex);
+				break;
+			}
+			case EWireDataType::Vector:
+				Ar << Value.VectorValue;
+				break;
+			default:
+				// The size of the value is unknown, so nothing after it can be read either
+				UE_LOG(LogCircuitWire, Warning, TEXT("UWireSubsystem::LoadWireNetwork unknown data type %d, nothing was restored"), Type);
+				return false;
+			}
+
+			const int32 EventSlot = Output ? WireSave::ResolveSlot(Output->Events, Slot, Pending.EventName) : INDEX_NONE;
+
+			uint32 NumObservers = 0;
+			Ar.SerializeIntPacked(NumObservers);
+
+			bool bHasObservers = false;
+			for (uint32 ObserverIdx = 0; ObserverIdx < NumObservers && !Ar.IsError(); ObserverIdx++)
+			{
+				uint32 ObserverIndex = 0;
+				uint32 InputSlot = 0;
+				uint32 InputNameIndex = 0;
+				Ar.SerializeIntPacked(ObserverIndex);
+				Ar.SerializeIntPacked(InputSlot);
+				Ar.SerializeIntPacked(InputNameIndex);
+
+				UWireComponent* Observer = GetComponent(ObserverIndex);
+				if (EventSlot == INDEX_NONE || Observer == nullptr)
+				{
+					continue;
+				}
+
+				PendingConnections.Add({ Output, EventSlot, Observer, GetName(InputNameIndex), InputSlot });
+				bHasObservers = true;
+			}
+
+			if (bHasObservers || (EventSlot != INDEX_NONE && Output->Events[EventSlot].Observers.Num() > 0))
+			{
+				PendingValues.Add(Pending);
+			}
+		}
+	}
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogCircuitWire, Warning, TEXT("UWireSubsystem::LoadWireNetwork data was truncated, nothing was restored"));
+		return false;
+	}
+
+	for (const WireSave::FPendingConnection& Connection : PendingConnections)
+	{
+		FWireEvent& Event = Connection.Output->Events[Connection.EventSlot];
+		UWireComponent* Observer = Connection.Observer;
+		if (Event.Observers.ContainsByPredicate([Observer](const FWireConnectedInputInfo& Info) { return Info.InputComponent.Get() == Observer; }))
+		{
+			continue;
+		}
+
+		FWireConnectedInputInfo NewObserver;
+		NewObserver.InputComponent = Observer;
+		NewObserver.InputName = Connection.InputName;
+		Event.Observers.Add(NewObserver);
+
+		const int32 ResolvedInputSlot = WireSave::ResolveSlot(Observer->Inputs, Connection.InputSlot, Connection.InputName);
+		if (ResolvedInputSlot != INDEX_NONE)
+		{
+			FWireConnectedOutputInfo OutputInfo;
+			OutputInfo.OutputComponent = Connection.Output;
+			OutputInfo.EventName = Event.EventName;
+			Observer->Inputs[ResolvedInputSlot].Connections.Add(OutputInfo);
+		}
+	}
+
+	// Every connection is in place, now bring observers up to date with the saved values
+	for (const WireSave::FPendingValue& Pending : PendingValues)
+	{
+		Pending.Output->SendValue(Pending.EventName, Pending.Value);
+	}
+
+	UE_CLOG(NumMissing > 0, LogCircuitWire, Log, TEXT("UWireSubsystem::LoadWireNetwork %d of %d components were not found"), NumMissing, NumComponents);
+
+	return true;
+}
+
+void UWireSubsystem::QueueWireNetworkForLevel(FName LevelPackageName, TArray<uint8>&& Data)
+{
+	PendingLevelNetworks.Add(LevelPackageName, MoveTemp(Data));
+}
+
+void UWireSubsystem::OnLevelAddedToWorld(ULevel* InLevel, UWorld* InWorld)
+{
+	if (InWorld != GetWorld() || InLevel == nullptr)
+	{
+		return;
+	}
+
+	TArray<uint8> Data;
+	if (!PendingLevelNetworks.RemoveAndCopyValue(InLevel->GetOutermost()->GetFName(), Data))
+	{
+		return;
+	}
+
+	// Make sure everything in the new level can be found even if it hasn't begun play yet
+	for (AActor* Actor : InLevel->Actors)
+	{
+		if (Actor)
+		{
+			TInlineComponentArray<UWireComponent*> WireComponents(Actor);
+			for (UWireComponent* WireComponent : WireComponents)
+			{
+				RegisterWireComponent(WireComponent);
+			}
+		}
+	}
+
+	LoadWireNetwork(Data);
+}
+
+FString UWireSubsystem::GetWireSlotPath(const FString& SlotName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Circuit") / TEXT("Wires") / (SlotName + TEXT(".wire"));
+}
+
+bool UWireSubsystem::SaveWireNetworkToSlot(const FString& SlotName)
+{
+	TArray<uint8> Data;
+	return SaveWireNetwork(Data) && FFileHelper::SaveArrayToFile(Data, *GetWireSlotPath(SlotName));
+}
+
+bool UWireSubsystem::LoadWireNetworkFromSlot(const FString& SlotName)
+{
+	TArray<uint8> Data;
+	return FFileHelper::LoadFileToArray(Data, *GetWireSlotPath(SlotName)) && LoadWireNetwork(Data);
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Circuit/Components/WireComponent.h"
+#include "Circuit/Subsystems/WireProfiler.h"
+#include "WireSubsystem.generated.h"
+
+class UWireGateBoardComponent;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogCircuitWire, Log, All);
+
+/**
+ * Keeps track of every UWireComponent in a world and owns the wire network save format.
+ *
+ * The saved network is a compact binary blob: a name table, a table of component GUIDs, then for every
+ * connected event its slot index, current value and the (component, input slot) pairs observing it.
+ * Loading writes the Observers/Connections arrays directly instead of going through AddObserverToActorEvent.
+ *
+ * Also runs every UWireGateBoardComponent at wire.TickRate and owns the wire profiler (wire.Profile, wire.Debug, wire.DumpStats).
+ */
+UCLASS()
+class SHOOTERGAME_API UWireSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	FWireProfiler& GetProfiler() { return Profiler; }
+
+	void RegisterWireComponent(UWireComponent* Component);
+	void UnregisterWireComponent(UWireComponent* Component);
+
+	UWireComponent* FindWireComponent(const FGuid& WireGuid) const;
+
+	void RegisterGateBoard(UWireGateBoardComponent* Board);
+	void UnregisterGateBoard(UWireGateBoardComponent* Board);
+
+	/* Serializes every connection whose output lives in Level (or the whole world if Level is null). */
+	bool SaveWireNetwork(TArray<uint8>& OutData, const ULevel* Level = nullptr) const;
+
+	/* Restores connections from SaveWireNetwork data. Components that can't be found are skipped. */
+	bool LoadWireNetwork(const TArray<uint8>& Data);
+
+	/* Holds data until the streaming level with this package name is added to the world, then loads it. */
+	void QueueWireNetworkForLevel(FName LevelPackageName, TArray<uint8>&& Data);
+
+	UFUNCTION(BlueprintCallable, Category = "Circuit|Wire|Save")
+	bool SaveWireNetworkToSlot(const FString& SlotName);
+
+	UFUNCTION(BlueprintCallable, Category = "Circuit|Wire|Save")
+	bool LoadWireNetworkFromSlot(const FString& SlotName);
+
+	static FString GetWireSlotPath(const FString& SlotName);
+
+private:
+	void OnLevelAddedToWorld(ULevel* InLevel, UWorld* InWorld);
+
+	TMap<FGuid, TWeakObjectPtr<UWireComponent>> ComponentsByGuid;
+
+	TMap<FName, TArray<uint8>> PendingLevelNetworks;
+
+	FDelegateHandle LevelAddedHandle;
+
+	FWireProfiler Profiler;
+
+	TArray<TWeakObjectPtr<UWireGateBoardComponent>> GateBoards;
+
+	/* Time not yet consumed by a wire tick. */
+	float GateTickAccumulator = 0.0f;
+};
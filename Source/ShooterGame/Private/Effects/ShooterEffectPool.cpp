@@ -0,0 +1,328 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Effects/ShooterEffectPool.h"
+#include "Effects/ShooterImpactEffect.h"
+#include "Effects/ShooterExplosionEffect.h"
+#include "Components/DecalComponent.h"
+
+int32 CVar_ShooterEffectPool_Enable = 1;
+static FAutoConsoleVariableRef CVarShooterEffectPoolEnable(TEXT("ShooterEffectPool.Enable"), CVar_ShooterEffectPool_Enable, TEXT("Reuse impact and explosion effects and decals instead of spawning new ones."), ECVF_Default);
+
+int32 CVar_ShooterEffectPool_MaxActorsPerClass = 32;
+static FAutoConsoleVariableRef CVarShooterEffectPoolMaxActorsPerClass(TEXT("ShooterEffectPool.MaxActorsPerClass"), CVar_ShooterEffectPool_MaxActorsPerClass, TEXT("Most effect actors of one class alive at once, past that the oldest is reused."), ECVF_Default);
+
+int32 CVar_ShooterEffectPool_MaxDecals = 64;
+static FAutoConsoleVariableRef CVarShooterEffectPoolMaxDecals(TEXT("ShooterEffectPool.MaxDecals"), CVar_ShooterEffectPool_MaxDecals, TEXT("Most pooled decals visible at once, past that the oldest is reused."), ECVF_Default);
+
+int32 CVar_ShooterEffectPool_PrewarmCount = 8;
+static FAutoConsoleVariableRef CVarShooterEffectPoolPrewarmCount(TEXT("ShooterEffectPool.PrewarmCount"), CVar_ShooterEffectPool_PrewarmCount, TEXT("Effect actors spawned hidden up front for each weapon's impact effect."), ECVF_Default);
+
+float CVar_ShooterEffectPool_ImpactLifeSpan = 2.0f;
+static FAutoConsoleVariableRef CVarShooterEffectPoolImpactLifeSpan(TEXT("ShooterEffectPool.ImpactLifeSpan"), CVar_ShooterEffectPool_ImpactLifeSpan, TEXT("Seconds an impact effect actor stays active before it goes back to the pool."), ECVF_Default);
+
+void UShooterEffectPoolSubsystem::Deinitialize()
+{
+	for (UDecalComponent* Decal : PooledDecals)
+	{
+		if (Decal)
+		{
+			Decal->DestroyComponent();
+		}
+	}
+
+	ClassPools.Empty();
+	PooledDecals.Empty();
+	FreeDecals.Empty();
+	ActiveDecals.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShooterEffectPoolSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	for (auto It = ClassPools.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		FShooterEffectClassPool& ClassPool = It.Value();
+		for (int32 Idx = ClassPool.Active.Num() - 1; Idx >= 0; --Idx)
+		{
+			const FShooterPooledEffect& Entry = ClassPool.Active[Idx];
+			AActor* Effect = Entry.Effect.Get();
+			if (Effect == nullptr)
+			{
+				ClassPool.Active.RemoveAt(Idx, 1, false);
+			}
+			else if (Entry.ReleaseTime > 0.0 && Now >= Entry.ReleaseTime)
+			{
+				ClassPool.Active.RemoveAt(Idx, 1, false);
+				DeactivateEffect(Effect);
+				ClassPool.Free.Add(Effect);
+			}
+		}
+	}
+
+	for (int32 Idx = ActiveDecals.Num() - 1; Idx >= 0; --Idx)
+	{
+		const FShooterPooledDecal& Entry = ActiveDecals[Idx];
+		UDecalComponent* Decal = Entry.Decal.Get();
+		if (Decal == nullptr)
+		{
+			ActiveDecals.RemoveAt(Idx, 1, false);
+		}
+		else if (Entry.ReleaseTime > 0.0 && Now >= Entry.ReleaseTime)
+		{
+			ActiveDecals.RemoveAt(Idx, 1, false);
+			ReleaseDecal(Decal);
+		}
+	}
+}
+
+TStatId UShooterEffectPoolSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterEffectPoolSubsystem, STATGROUP_Tickables);
+}
+
+AShooterImpactEffect* UShooterEffectPoolSubsystem::SpawnImpactEffect(TSubclassOf<AShooterImpactEffect> Template, const FTransform& SpawnTransform, const FHitResult& SurfaceHit)
+{
+	if (!Template)
+	{
+		return nullptr;
+	}
+
+	if (CVar_ShooterEffectPool_Enable == 0)
+	{
+		AShooterImpactEffect* EffectActor = GetWorld()->SpawnActorDeferred<AShooterImpactEffect>(Template, SpawnTransform);
+		if (EffectActor)
+		{
+			EffectActor->SurfaceHit = SurfaceHit;
+			UGameplayStatics::FinishSpawningActor(EffectActor, SpawnTransform);
+		}
+		return EffectActor;
+	}
+
+	const double ReleaseTime = GetWorld()->GetTimeSeconds() + FMath::Max(CVar_ShooterEffectPool_ImpactLifeSpan, 0.1f);
+	AShooterImpactEffect* EffectActor = Cast<AShooterImpactEffect>(AcquireEffect(Template, SpawnTransform, ReleaseTime));
+	if (EffectActor)
+	{
+		EffectActor->SurfaceHit = SurfaceHit;
+		EffectActor->PlayImpact();
+	}
+
+	return EffectActor;
+}
+
+AShooterExplosionEffect* UShooterEffectPoolSubsystem::SpawnExplosionEffect(TSubclassOf<AShooterExplosionEffect> Template, const FTransform& SpawnTransform, const FHitResult& SurfaceHit)
+{
+	if (!Template)
+	{
+		return nullptr;
+	}
+
+	if (CVar_ShooterEffectPool_Enable == 0)
+	{
+		AShooterExplosionEffect* EffectActor = GetWorld()->SpawnActorDeferred<AShooterExplosionEffect>(Template, SpawnTransform);
+		if (EffectActor)
+		{
+			EffectActor->SurfaceHit = SurfaceHit;
+			UGameplayStatics::FinishSpawningActor(EffectActor, SpawnTransform);
+		}
+		return EffectActor;
+	}
+
+	AShooterExplosionEffect* EffectActor = Cast<AShooterExplosionEffect>(AcquireEffect(Template, SpawnTransform, 0.0));
+	if (EffectActor)
+	{
+		EffectActor->SurfaceHit = SurfaceHit;
+		EffectActor->PlayExplosion();
+	}
+
+	return EffectActor;
+}
+
+UDecalComponent* UShooterEffectPoolSubsystem::SpawnDecal(const FDecalData& DecalData, const FVector& DecalSize, const FHitResult& SurfaceHit, const FRotator& Rotation)
+{
+	if (DecalData.DecalMaterial == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (CVar_ShooterEffectPool_Enable == 0)
+	{
+		return UGameplayStatics::SpawnDecalAttached(DecalData.DecalMaterial, DecalSize, SurfaceHit.Component.Get(), SurfaceHit.BoneName,
+			SurfaceHit.ImpactPoint, Rotation, EAttachLocation::KeepWorldPosition, DecalData.LifeSpan);
+	}
+
+	UDecalComponent* Decal = nullptr;
+	while (Decal == nullptr && FreeDecals.Num() > 0)
+	{
+		Decal = FreeDecals.Pop(false).Get();
+	}
+
+	// at the cap, take over the oldest one still showing
+	while (Decal == nullptr && ActiveDecals.Num() > 0 && ActiveDecals.Num() >= CVar_ShooterEffectPool_MaxDecals)
+	{
+		Decal = ActiveDecals[0].Decal.Get();
+		ActiveDecals.RemoveAt(0, 1, false);
+	}
+
+	if (Decal == nullptr)
+	{
+		Decal = NewObject<UDecalComponent>(GetWorld());
+		Decal->bAllowAnyoneToDestroyMe = true;
+		Decal->RegisterComponentWithWorld(GetWorld());
+		PooledDecals.Add(Decal);
+	}
+
+	Decal->SetDecalMaterial(DecalData.DecalMaterial);
+	Decal->DecalSize = DecalSize;
+	Decal->SetWorldLocationAndRotation(SurfaceHit.ImpactPoint, Rotation);
+
+	UPrimitiveComponent* SurfaceComponent = SurfaceHit.Component.Get();
+	if (SurfaceComponent && SurfaceComponent->Mobility != EComponentMobility::Static)
+	{
+		Decal->AttachToComponent(SurfaceComponent, FAttachmentTransformRules::KeepWorldTransform, SurfaceHit.BoneName);
+	}
+	else
+	{
+		Decal->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	}
+
+	Decal->SetVisibility(true);
+	Decal->MarkRenderStateDirty();
+
+	FShooterPooledDecal& Entry = ActiveDecals.AddDefaulted_GetRef();
+	Entry.Decal = Decal;
+	Entry.ReleaseTime = DecalData.LifeSpan > 0.0f ? GetWorld()->GetTimeSeconds() + DecalData.LifeSpan : 0.0;
+
+	return Decal;
+}
+
+void UShooterEffectPoolSubsystem::Prewarm(TSubclassOf<AActor> Template)
+{
+	if (!Template || CVar_ShooterEffectPool_Enable == 0)
+	{
+		return;
+	}
+
+	FShooterEffectClassPool& ClassPool = ClassPools.FindOrAdd(Template.Get());
+	const int32 Count = FMath::Min(CVar_ShooterEffectPool_PrewarmCount, CVar_ShooterEffectPool_MaxActorsPerClass);
+
+	while (ClassPool.Free.Num() + ClassPool.Active.Num() < Count)
+	{
+		AActor* Effect = SpawnPooledEffect(Template, FTransform::Identity);
+		if (Effect == nullptr)
+		{
+			break;
+		}
+
+		DeactivateEffect(Effect);
+		ClassPool.Free.Add(Effect);
+	}
+}
+
+bool UShooterEffectPoolSubsystem::ReleaseEffect(AActor* Effect)
+{
+	FShooterEffectClassPool* ClassPool = Effect ? ClassPools.Find(Effect->GetClass()) : nullptr;
+	if (ClassPool == nullptr)
+	{
+		return false;
+	}
+
+	const int32 ActiveIdx = ClassPool->Active.IndexOfByPredicate([Effect](const FShooterPooledEffect& Entry) { return Entry.Effect.Get() == Effect; });
+	if (ActiveIdx == INDEX_NONE)
+	{
+		return ClassPool->Free.Contains(Effect);
+	}
+
+	ClassPool->Active.RemoveAt(ActiveIdx, 1, false);
+	DeactivateEffect(Effect);
+	ClassPool->Free.Add(Effect);
+
+	return true;
+}
+
+AActor* UShooterEffectPoolSubsystem::AcquireEffect(UClass* Template, const FTransform& SpawnTransform, double ReleaseTime)
+{
+	FShooterEffectClassPool& ClassPool = ClassPools.FindOrAdd(Template);
+
+	AActor* Effect = nullptr;
+	while (Effect == nullptr && ClassPool.Free.Num() > 0)
+	{
+		Effect = ClassPool.Free.Pop(false).Get();
+	}
+
+	// at the cap, take over the least recently used one
+	while (Effect == nullptr && ClassPool.Active.Num() > 0 && ClassPool.Active.Num() >= CVar_ShooterEffectPool_MaxActorsPerClass)
+	{
+		Effect = ClassPool.Active[0].Effect.Get();
+		ClassPool.Active.RemoveAt(0, 1, false);
+	}
+
+	if (Effect)
+	{
+		Effect->SetActorTransform(SpawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+		Effect->SetActorHiddenInGame(false);
+		Effect->SetActorTickEnabled(true);
+	}
+	else
+	{
+		Effect = SpawnPooledEffect(Template, SpawnTransform);
+		if (Effect == nullptr)
+		{
+			return nullptr;
+		}
+	}
+
+	FShooterPooledEffect& Entry = ClassPool.Active.AddDefaulted_GetRef();
+	Entry.Effect = Effect;
+	Entry.ReleaseTime = ReleaseTime;
+
+	return Effect;
+}
+
+AActor* UShooterEffectPoolSubsystem::SpawnPooledEffect(UClass* Template, const FTransform& SpawnTransform)
+{
+	AActor* Effect = GetWorld()->SpawnActorDeferred<AActor>(Template, SpawnTransform);
+	if (Effect == nullptr)
+	{
+		return nullptr;
+	}
+
+	// pooled effects are played by the pool, not when they're spawned, and are never destroyed
+	if (AShooterImpactEffect* ImpactEffect = Cast<AShooterImpactEffect>(Effect))
+	{
+		ImpactEffect->bPooledEffect = true;
+	}
+	else if (AShooterExplosionEffect* ExplosionEffect = Cast<AShooterExplosionEffect>(Effect))
+	{
+		ExplosionEffect->bPooledEffect = true;
+	}
+	Effect->SetAutoDestroyWhenFinished(false);
+
+	UGameplayStatics::FinishSpawningActor(Effect, SpawnTransform);
+
+	return Effect;
+}
+
+void UShooterEffectPoolSubsystem::DeactivateEffect(AActor* Effect)
+{
+	Effect->SetActorHiddenInGame(true);
+	Effect->SetActorTickEnabled(false);
+}
+
+void UShooterEffectPoolSubsystem::ReleaseDecal(UDecalComponent* Decal)
+{
+	Decal->SetVisibility(false);
+	Decal->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	FreeDecals.Add(Decal);
+}
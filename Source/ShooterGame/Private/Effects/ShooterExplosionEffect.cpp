@@ -2,6 +2,7 @@
 
 #include "ShooterGame.h"
 #include "ShooterExplosionEffect.h"
+#include "Effects/ShooterEffectPool.h"
 
 AShooterExplosionEffect::AShooterExplosionEffect(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -19,15 +20,30 @@ AShooterExplosionEffect::AShooterExplosionEffect(const FObjectInitializer& Objec
 	ExplosionLight->SetVisibleFlag(true);
 
 	ExplosionLightFadeOut = 0.2f;
+	ExplosionStartTime = 0.0f;
+	bPooledEffect = false;
 }
 
 void AShooterExplosionEffect::BeginPlay()
 {
 	Super::BeginPlay();
 
+	if (!bPooledEffect)
+	{
+		PlayExplosion();
+	}
+}
+
+void AShooterExplosionEffect::PlayExplosion()
+{
+	ExplosionStartTime = GetWorld()->GetTimeSeconds();
+
+	UPointLightComponent* DefLight = Cast<UPointLightComponent>(GetClass()->GetDefaultSubobjectByName(ExplosionLightComponentName));
+	ExplosionLight->SetIntensity(DefLight->Intensity);
+
 	if (ExplosionFX)
 	{
-		UGameplayStatics::SpawnEmitterAtLocation(this, ExplosionFX, GetActorLocation(), GetActorRotation());
+		UGameplayStatics::SpawnEmitterAtLocation(this, ExplosionFX, GetActorLocation(), GetActorRotation(), FVector(1.0f), true, EPSCPoolMethod::AutoRelease);
 	}
 
 	if (ExplosionSound)
@@ -40,10 +56,20 @@ void AShooterExplosionEffect::BeginPlay()
 		FRotator RandomDecalRotation = SurfaceHit.ImpactNormal.Rotation();
 		RandomDecalRotation.Roll = FMath::FRandRange(-180.0f, 180.0f);
 
-		UGameplayStatics::SpawnDecalAttached(Decal.DecalMaterial, FVector(Decal.DecalSize, Decal.DecalSize, 1.0f),
-			SurfaceHit.Component.Get(), SurfaceHit.BoneName,
-			SurfaceHit.ImpactPoint, RandomDecalRotation, EAttachLocation::KeepWorldPosition,
-			Decal.LifeSpan);
+		const FVector DecalSize(Decal.DecalSize, Decal.DecalSize, 1.0f);
+
+		UShooterEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UShooterEffectPoolSubsystem>();
+		if (EffectPool)
+		{
+			EffectPool->SpawnDecal(Decal, DecalSize, SurfaceHit, RandomDecalRotation);
+		}
+		else
+		{
+			UGameplayStatics::SpawnDecalAttached(Decal.DecalMaterial, DecalSize,
+				SurfaceHit.Component.Get(), SurfaceHit.BoneName,
+				SurfaceHit.ImpactPoint, RandomDecalRotation, EAttachLocation::KeepWorldPosition,
+				Decal.LifeSpan);
+		}
 	}
 }
 
@@ -51,7 +77,7 @@ void AShooterExplosionEffect::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
 
-	const float TimeAlive = GetWorld()->GetTimeSeconds() - CreationTime;
+	const float TimeAlive = GetWorld()->GetTimeSeconds() - ExplosionStartTime;
 	const float TimeRemaining = FMath::Max(0.0f, ExplosionLightFadeOut - TimeAlive);
 
 	if (TimeRemaining > 0)
@@ -61,6 +87,14 @@ void AShooterExplosionEffect::Tick(float DeltaSeconds)
 		UPointLightComponent* DefLight = Cast<UPointLightComponent>(GetClass()->GetDefaultSubobjectByName(ExplosionLightComponentName));
 		ExplosionLight->SetIntensity(DefLight->Intensity * FadeAlpha);
 	}
+	else if (bPooledEffect)
+	{
+		UShooterEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UShooterEffectPoolSubsystem>();
+		if (EffectPool == nullptr || !EffectPool->ReleaseEffect(this))
+		{
+			Destroy();
+		}
+	}
 	else
 	{
 		Destroy();
@@ -2,16 +2,26 @@
 
 #include "ShooterGame.h"
 #include "ShooterImpactEffect.h"
+#include "Effects/ShooterEffectPool.h"
 
 AShooterImpactEffect::AShooterImpactEffect(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
 	SetAutoDestroyWhenFinished(true);
+	bPooledEffect = false;
 }
 
 void AShooterImpactEffect::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
+	if (!bPooledEffect)
+	{
+		PlayImpact();
+	}
+}
+
+void AShooterImpactEffect::PlayImpact()
+{
 	UPhysicalMaterial* HitPhysMat = SurfaceHit.PhysMaterial.Get();
 	EPhysicalSurface HitSurfaceType = UPhysicalMaterial::DetermineSurfaceType(HitPhysMat);
 
@@ -19,7 +29,7 @@ void AShooterImpactEffect::PostInitializeComponents()
 	UParticleSystem* ImpactFX = GetImpactFX(HitSurfaceType);
 	if (ImpactFX)
 	{
-		UGameplayStatics::SpawnEmitterAtLocation(this, ImpactFX, GetActorLocation(), GetActorRotation());
+		UGameplayStatics::SpawnEmitterAtLocation(this, ImpactFX, GetActorLocation(), GetActorRotation(), FVector(1.0f), true, EPSCPoolMethod::AutoRelease);
 	}
 
 	// play sound
@@ -34,10 +44,20 @@ void AShooterImpactEffect::PostInitializeComponents()
 		FRotator RandomDecalRotation = SurfaceHit.ImpactNormal.Rotation();
 		RandomDecalRotation.Roll = FMath::FRandRange(-180.0f, 180.0f);
 
-		UGameplayStatics::SpawnDecalAttached(DefaultDecal.DecalMaterial, FVector(1.0f, DefaultDecal.DecalSize, DefaultDecal.DecalSize),
-			SurfaceHit.Component.Get(), SurfaceHit.BoneName,
-			SurfaceHit.ImpactPoint, RandomDecalRotation, EAttachLocation::KeepWorldPosition,
-			DefaultDecal.LifeSpan);
+		const FVector DecalSize(1.0f, DefaultDecal.DecalSize, DefaultDecal.DecalSize);
+
+		UShooterEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UShooterEffectPoolSubsystem>();
+		if (EffectPool)
+		{
+			EffectPool->SpawnDecal(DefaultDecal, DecalSize, SurfaceHit, RandomDecalRotation);
+		}
+		else
+		{
+			UGameplayStatics::SpawnDecalAttached(DefaultDecal.DecalMaterial, DecalSize,
+				SurfaceHit.Component.Get(), SurfaceHit.BoneName,
+				SurfaceHit.ImpactPoint, RandomDecalRotation, EAttachLocation::KeepWorldPosition,
+				DefaultDecal.LifeSpan);
+		}
 	}
 }
 
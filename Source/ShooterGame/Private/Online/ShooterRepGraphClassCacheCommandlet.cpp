@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "ShooterRepGraphClassCacheCommandlet.h"
+#include "ShooterReplicationGraph.h"
+#include "ShooterReplicationGraphClassCache.h"
+#include "AssetRegistryModule.h"
+#include "IAssetRegistry.h"
+#include "Engine/Engine.h"
+#include "Engine/NetDriver.h"
+
+UShooterRepGraphClassCacheCommandlet::UShooterRepGraphClassCacheCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UShooterRepGraphClassCacheCommandlet::Main(const FString& Params)
+{
+	// The tick rate comes from the net driver class the game actually runs with, its config can differ from the base UNetDriver's
+	const UNetDriver* GameNetDriver = GetDefault<UNetDriver>();
+	for (const FNetDriverDefinition& Definition : GEngine->NetDriverDefinitions)
+	{
+		if (Definition.DefName == NAME_GameNetDriver)
+		{
+			if (UClass* DriverClass = LoadClass<UNetDriver>(nullptr, *Definition.DriverClassName.ToString()))
+			{
+				GameNetDriver = DriverClass->GetDefaultObject<UNetDriver>();
+			}
+			else
+			{
+				UE_LOG(LogShooterReplicationGraph, Warning, TEXT("Couldn't load game net driver %s, using the UNetDriver tick rate"), *Definition.DriverClassName.ToString());
+			}
+			break;
+		}
+	}
+
+	float TickRate = GameNetDriver->NetServerMaxTickRate;
+	FParse::Value(*Params, TEXT("TickRate="), TickRate);
+
+	// The servers only ever see a subset of these per map, but a cache built from all of them covers every map in the rotation
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FString> ClassPaths;
+	FShooterRepGraphClassCache::GetActorBlueprintClassPaths(ClassPaths);
+
+	int32 NumLoaded = 0;
+	for (const FString& ClassPath : ClassPaths)
+	{
+		if (LoadObject<UClass>(nullptr, *ClassPath))
+		{
+			NumLoaded++;
+		}
+	}
+
+	UShooterReplicationGraph* Graph = NewObject<UShooterReplicationGraph>();
+	Graph->BuildClassSettings(TickRate);
+
+	FShooterRepGraphClassCache Cache;
+	Graph->ExportClassSettings(Cache, TickRate);
+
+	const FString Filename = FShooterRepGraphClassCache::GetFilename();
+	if (!Cache.Save(Filename))
+	{
+		UE_LOG(LogShooterReplicationGraph, Error, TEXT("Failed to write %s"), *Filename);
+		return 1;
+	}
+
+	UE_LOG(LogShooterReplicationGraph, Display, TEXT("Wrote %d classes (%d actor blueprints loaded, tick rate %.0f) to %s"), Cache.Entries.Num(), NumLoaded, TickRate, *Filename);
+	return 0;
+}
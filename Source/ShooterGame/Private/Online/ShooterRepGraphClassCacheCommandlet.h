@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ShooterRepGraphClassCacheCommandlet.generated.h"
+
+/**
+ * Writes the replication graph class cache (see FShooterRepGraphClassCache) with every actor blueprint loaded. Run as part of cooking, before staging:
+ *
+ *		UnrealEditor-Cmd ShooterGame.uproject -run=ShooterRepGraphClassCache [-TickRate=30]
+ *
+ * TickRate has to match the server's NetServerMaxTickRate or the cache is rejected at load.
+ */
+UCLASS()
+class UShooterRepGraphClassCacheCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterRepGraphClassCacheCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -27,6 +27,15 @@
 *		This is the spatialization node. All "distance based relevant" actors will be routed here. This node divides the map into a 2D grid. Each cell in the grid contains 
 *		children nodes that hold lists of actors based on how they update/go dormant. Actors are put in multiple cells. Connections pull from the single cell they are in.
 *		
+*		UShooterReplicationGraphNode_GridSpatialization3D
+*		Optional replacement for the 2D grid on planet maps (ShooterRepGraph.Use3DSpatialization). Actors are hashed into sparse cubic cells and connections pull
+*		from the cells around them, so players on opposite sides of a planet no longer share a cell.
+*		
+*		UShooterReplicationGraphNode_GravityField
+*		Optional (ShooterRepGraph.UseGravityFieldNode). Dynamic and dormancy actors that receive custom gravity (characters, gravity props) are routed here first. Actors inside
+*		a gravity field are grouped by that field, so a connection only pulls a field's actors when one of its viewers is in the field or close to its bounds.
+*		Actors in no field are handed back to the grid. Per class cull distance still applies on top of this.
+*		
 *		UReplicationGraphNode_ActorList
 *		This is an actor list node that contains the always relevant actors. These actors are always relevant to every connection.
 *		
@@ -36,28 +45,47 @@
 *		but currently not necessary.
 *		
 *		UShooterReplicationGraphNode_PlayerStateFrequencyLimiter
-*		A custom node for handling player state replication. This replicates a small rolling set of player states (currently 2/frame). This is so player states replicate
+*		A custom node for handling player state replication. This replicates a small rolling set of player states (2/frame or more on big servers, see ShooterRepGraph.PlayerState.*),
+*		plus any whose score/kills/deaths just changed. This is so player states replicate
 *		to simulated connections at a low, steady frequency, and to take advantage of serialization sharing. Auto proxy player states are replicated at higher frequency (to the
 *		owning connection only) via UShooterReplicationGraphNode_AlwaysRelevant_ForConnection.
 *		
+*		UShooterReplicationGraphNode_Replay
+*		Connection specific node for demo recording connections (ShooterRepGraph.Replay.*). A recording has no real viewer to cull around, so it gets every
+*		spatialized actor, but only actors that are moving near a player's pawn record at their class rate. The rest record ShooterRepGraph.Replay.ReducedRateDivisor
+*		times slower, which keeps demo files and the cost of recording down.
+*		
 *		UReplicationGraphNode_TearOff_ForConnection
 *		Connection specific node for handling tear off actors. This is created and managed in the base implementation of Replication Graph.
 *		
-*	Dependent Actors (AShooterWeapon)
+*	Dependent Actors (AShooterWeapon, seated drivers)
 *		
 *		Replication Graph introduces a concept of dependent actor replication. This is an actor (AShooterWeapon) that only replicates when another actor replicates (Pawn). I.e, the weapon
 *		actor itself never goes into the Replication Graph. It is never gathered on its own and never prioritized. It just has a chance to replicate when the Pawn replicates. This keeps
 *		the graph leaner since no extra work has to be done for the weapon actors.
 *		
 *		See UShooterReplicationGraph::OnCharacterWeaponChange: this is how actors are added/removed from the dependent actor list. 
+*		
+*		The driver of an ACircuitWheeledVehiclePawn is handled the same way while seated: it is hidden and attached to the vehicle, so it is pulled out of the
+*		spatial nodes and only replicates with the vehicle. See UShooterReplicationGraph::OnVehicleDriverEnter/OnVehicleDriverExit.
 *	
 *	How To Use
 *	
 *		Making something always relevant: Please avoid if you can :) If you must, just setting AActor::bAlwaysRelevant = true in the class defaults will do it.
 *		
+*		Making something cheap while idle: set NetDormancy to DORM_DormantAll (or DORM_Initial for placed actors) in the class defaults (AGravityPropActor already does). The class is routed as
+*		Spatialize_Dormancy and costs nothing to gather while dormant. UCustomGravityComponent wakes its owner when physics wakes and puts it back to sleep with
+*		the rigid bodies, UWireComponent flushes dormancy whenever a wire value arrives. Anything else that changes replicated state must call FlushNetDormancy.
+*		
 *		Making something always relevant to connection: You will need to modify UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection. You will also want 
 *		to make sure the actor does not get put in one of the other nodes. The safest way to do this is by setting its EClassRepNodeMapping to NotRouted in UShooterReplicationGraph::InitGlobalActorClassSettings.
 *
+*	Adaptive Bandwidth
+*	
+*		Each connection's saturation (not net ready, or close to CurrentNetSpeed) is smoothed every frame. Past ShooterRepGraph.Adaptive.HighWater the connection
+*		is backed off a level: every actor it doesn't own updates less often and is culled closer, within the ShooterRepGraph.Adaptive.* bounds. It recovers a
+*		level at a time once below LowWater. Class settings in InitGlobalActorClassSettings stay the baseline for level 0.
+*	
 *	How To Debug
 *	
 *		Its a good idea to just disable rep graph to see if your problem is specific to this system or just general replication/game play problem.
@@ -72,15 +100,25 @@
 *		
 *		Net.RepGraph.PrintAllActorInfo <ActorMatchString> - will print the class, global, and connection replication info associated with an actor/class. If MatchString is empty will print everything. Call directly from client.
 *		
+*		Class routing and settings are only logged at Verbose (Log LogShooterReplicationGraph Verbose). Dedicated servers normally load them from the class cache
+*		written at cook time, see ShooterReplicationGraphClassCache.h. Set ShooterRepGraph.ClassCache 0 to rule the cache out.
+*		
 *		ShooterRepGraph.PrintRouting - will print the EClassRepNodeMapping for each class. That is, how a given actor class is routed (or not) in the Replication Graph.
+*		
+*		ShooterRepGraph.Metrics - dedicated servers continuously write per frame and per class numbers to Saved/Profiling/RepGraphMetrics (see ShooterReplicationGraphMetrics.h).
+*		Per class bandwidth is in csvprofile captures, under the classes tracked in InitGlobalActorClassSettings.
 *	
 */
 
 #include "ShooterGame.h"
 #include "ShooterReplicationGraph.h"
+#include "ShooterReplicationGraphClassCache.h"
 
 #include "Net/UnrealNetwork.h"
+#include "Misc/EngineVersion.h"
 #include "Engine/LevelStreaming.h"
+#include "Engine/DemoNetDriver.h"
+#include "Engine/DemoNetConnection.h"
 #include "EngineUtils.h"
 #include "CoreGlobals.h"
 
@@ -97,6 +135,10 @@
 #include "Online/ShooterPlayerState.h"
 #include "Weapons/ShooterWeapon.h"
 #include "Pickups/ShooterPickup.h"
+#include "Circuit/Player/CircuitCharacter.h"
+#include "Circuit/Player/CircuitWheeledVehiclePawn.h"
+#include "Circuit/Components/CustomGravityComponent.h"
+#include "Circuit/Components/Gravity/BaseGravityComponent.h"
 
 DEFINE_LOG_CATEGORY( LogShooterReplicationGraph );
 
@@ -121,9 +163,96 @@ static FAutoConsoleVariableRef CVarShooterRepSpatialBiasY(TEXT("ShooterRepGraph.
 int32 CVar_ShooterRepGraph_DynamicActorFrequencyBuckets = 3;
 static FAutoConsoleVariableRef CVarShooterRepDynamicActorFrequencyBuckets(TEXT("ShooterRepGraph.DynamicActorFrequencyBuckets"), CVar_ShooterRepGraph_DynamicActorFrequencyBuckets, TEXT(""), ECVF_Default );
 
+// Player states cycle through the frequency limiter roughly once per this many frames, however many players there are
+int32 CVar_ShooterRepGraph_PlayerStateCycleFrames = 30;
+static FAutoConsoleVariableRef CVarShooterRepGraphPlayerStateCycleFrames(TEXT("ShooterRepGraph.PlayerState.CycleFrames"), CVar_ShooterRepGraph_PlayerStateCycleFrames, TEXT("Target number of frames for every player state to be replicated once"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_PlayerStateMinPerFrame = 2;
+static FAutoConsoleVariableRef CVarShooterRepGraphPlayerStateMinPerFrame(TEXT("ShooterRepGraph.PlayerState.MinPerFrame"), CVar_ShooterRepGraph_PlayerStateMinPerFrame, TEXT("Lower bound on player states returned per frame"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_PlayerStateMaxPerFrame = 16;
+static FAutoConsoleVariableRef CVarShooterRepGraphPlayerStateMaxPerFrame(TEXT("ShooterRepGraph.PlayerState.MaxPerFrame"), CVar_ShooterRepGraph_PlayerStateMaxPerFrame, TEXT("Upper bound on player states returned per frame"), ECVF_Default );
+
+// Every connection gets the same bucket, so the per frame count is also held to this total divided by the connection count
+int32 CVar_ShooterRepGraph_PlayerStateMaxTotalPerFrame = 512;
+static FAutoConsoleVariableRef CVarShooterRepGraphPlayerStateMaxTotalPerFrame(TEXT("ShooterRepGraph.PlayerState.MaxTotalPerFrame"), CVar_ShooterRepGraph_PlayerStateMaxTotalPerFrame, TEXT("Upper bound on player states returned per frame summed over all connections. Takes priority over MinPerFrame, never below 1 per connection."), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_PlayerStateMaxPriorityPerFrame = 8;
+static FAutoConsoleVariableRef CVarShooterRepGraphPlayerStateMaxPriorityPerFrame(TEXT("ShooterRepGraph.PlayerState.MaxPriorityPerFrame"), CVar_ShooterRepGraph_PlayerStateMaxPriorityPerFrame, TEXT("Changed player states sent ahead of the rotation per frame. The rest wait for the next frame"), ECVF_Default );
+
 int32 CVar_ShooterRepGraph_DisableSpatialRebuilds = 1;
 static FAutoConsoleVariableRef CVarShooterRepDisableSpatialRebuilds(TEXT("ShooterRepGraph.DisableSpatialRebuilds"), CVar_ShooterRepGraph_DisableSpatialRebuilds, TEXT(""), ECVF_Default );
 
+// Planet maps need real 3D cells. Read when the graph is created, so set it in config or on the command line.
+int32 CVar_ShooterRepGraph_Use3DSpatialization = 0;
+static FAutoConsoleVariableRef CVarShooterRepUse3DSpatialization(TEXT("ShooterRepGraph.Use3DSpatialization"), CVar_ShooterRepGraph_Use3DSpatialization, TEXT("Use UShooterReplicationGraphNode_GridSpatialization3D instead of the 2D grid. Takes effect for newly created replication graphs."), ECVF_Default );
+
+// Matches the pawn cull distance so a 3x3x3 neighbourhood covers it. The gather radius grows past GatherRadius3D if a class culls further out.
+float CVar_ShooterRepGraph_CellSize3D = 15000.f;
+static FAutoConsoleVariableRef CVarShooterRepGraphCellSize3D(TEXT("ShooterRepGraph.CellSize3D"), CVar_ShooterRepGraph_CellSize3D, TEXT("Cell edge length for the 3D grid"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_GatherRadius3D = 1;
+static FAutoConsoleVariableRef CVarShooterRepGraphGatherRadius3D(TEXT("ShooterRepGraph.GatherRadius3D"), CVar_ShooterRepGraph_GatherRadius3D, TEXT("Cells gathered on each axis around a viewer in the 3D grid"), ECVF_Default );
+
+// Read when the graph is created, like Use3DSpatialization.
+int32 CVar_ShooterRepGraph_UseGravityFieldNode = 0;
+static FAutoConsoleVariableRef CVarShooterRepUseGravityFieldNode(TEXT("ShooterRepGraph.UseGravityFieldNode"), CVar_ShooterRepGraph_UseGravityFieldNode, TEXT("Move dynamic actors that are inside a gravity field from the grid to UShooterReplicationGraphNode_GravityField. Actors in no field stay on the grid. Takes effect for newly created replication graphs."), ECVF_Default );
+
+float CVar_ShooterRepGraph_GravityFieldCrossFieldDistance = 5000.f;
+static FAutoConsoleVariableRef CVarShooterRepGraphGravityFieldCrossFieldDistance(TEXT("ShooterRepGraph.GravityField.CrossFieldDistance"), CVar_ShooterRepGraph_GravityFieldCrossFieldDistance, TEXT("Viewers inside one gravity field still see actors in another field when this close to its bounds"), ECVF_Default );
+
+// Vehicles cover ground fast, so they are seen from further away than people and update every frame
+float CVar_ShooterRepGraph_VehicleCullDistance = 25000.f;
+static FAutoConsoleVariableRef CVarShooterRepGraphVehicleCullDistance(TEXT("ShooterRepGraph.Vehicle.CullDistance"), CVar_ShooterRepGraph_VehicleCullDistance, TEXT("Cull distance (not squared) for ACircuitWheeledVehiclePawn. Read when the replication graph is created."), ECVF_Default );
+
+// Read when the graph is created. The cache itself is written by UShooterRepGraphClassCacheCommandlet when cooking.
+int32 CVar_ShooterRepGraph_ClassCache = 1;
+static FAutoConsoleVariableRef CVarShooterRepGraphClassCache(TEXT("ShooterRepGraph.ClassCache"), CVar_ShooterRepGraph_ClassCache, TEXT("Dedicated servers load class routing and settings from the cooked class cache instead of scanning every class"), ECVF_Default );
+
+// Adaptive per connection bandwidth. Saturated connections are backed off one level at a time: actors update less often and are culled closer.
+int32 CVar_ShooterRepGraph_AdaptiveEnable = 1;
+static FAutoConsoleVariableRef CVarShooterRepGraphAdaptiveEnable(TEXT("ShooterRepGraph.Adaptive.Enable"), CVar_ShooterRepGraph_AdaptiveEnable, TEXT("Scale per connection update rates and cull distances by how saturated each connection is"), ECVF_Default );
+
+float CVar_ShooterRepGraph_AdaptiveSmoothing = 0.05f;
+static FAutoConsoleVariableRef CVarShooterRepGraphAdaptiveSmoothing(TEXT("ShooterRepGraph.Adaptive.Smoothing"), CVar_ShooterRepGraph_AdaptiveSmoothing, TEXT("Weight of each frame in the saturation moving average"), ECVF_Default );
+
+float CVar_ShooterRepGraph_AdaptiveHighWater = 0.6f;
+static FAutoConsoleVariableRef CVarShooterRepGraphAdaptiveHighWater(TEXT("ShooterRepGraph.Adaptive.HighWater"), CVar_ShooterRepGraph_AdaptiveHighWater, TEXT("Back off a level when smoothed saturation is above this"), ECVF_Default );
+
+float CVar_ShooterRepGraph_AdaptiveLowWater = 0.3f;
+static FAutoConsoleVariableRef CVarShooterRepGraphAdaptiveLowWater(TEXT("ShooterRepGraph.Adaptive.LowWater"), CVar_ShooterRepGraph_AdaptiveLowWater, TEXT("Recover a level when smoothed saturation is below this"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_AdaptiveAdjustFrames = 30;
+static FAutoConsoleVariableRef CVarShooterRepGraphAdaptiveAdjustFrames(TEXT("ShooterRepGraph.Adaptive.AdjustFrames"), CVar_ShooterRepGraph_AdaptiveAdjustFrames, TEXT("Replication frames between level changes"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_AdaptiveMaxLevel = 3;
+static FAutoConsoleVariableRef CVarShooterRepGraphAdaptiveMaxLevel(TEXT("ShooterRepGraph.Adaptive.MaxLevel"), CVar_ShooterRepGraph_AdaptiveMaxLevel, TEXT("Most levels a connection can be backed off"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_AdaptivePeriodStep = 1;
+static FAutoConsoleVariableRef CVarShooterRepGraphAdaptivePeriodStep(TEXT("ShooterRepGraph.Adaptive.PeriodStep"), CVar_ShooterRepGraph_AdaptivePeriodStep, TEXT("Update period is multiplied by (1 + Level * PeriodStep)"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_AdaptiveMaxPeriodFrames = 12;
+static FAutoConsoleVariableRef CVarShooterRepGraphAdaptiveMaxPeriodFrames(TEXT("ShooterRepGraph.Adaptive.MaxPeriodFrames"), CVar_ShooterRepGraph_AdaptiveMaxPeriodFrames, TEXT("Backed off update periods never go past this (classes already slower keep their own period)"), ECVF_Default );
+
+float CVar_ShooterRepGraph_AdaptiveMinCullScale = 0.6f;
+static FAutoConsoleVariableRef CVarShooterRepGraphAdaptiveMinCullScale(TEXT("ShooterRepGraph.Adaptive.MinCullScale"), CVar_ShooterRepGraph_AdaptiveMinCullScale, TEXT("Cull distance scale at MaxLevel"), ECVF_Default );
+
+// Demo recording. Actors away from every player, or not moving, record at a fraction of their class rate.
+int32 CVar_ShooterRepGraph_ReplayEnable = 1;
+static FAutoConsoleVariableRef CVarShooterRepGraphReplayEnable(TEXT("ShooterRepGraph.Replay.Enable"), CVar_ShooterRepGraph_ReplayEnable, TEXT("Give demo recording connections UShooterReplicationGraphNode_Replay. Takes effect for new connections."), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_ReplayRefreshFrames = 15;
+static FAutoConsoleVariableRef CVarShooterRepGraphReplayRefreshFrames(TEXT("ShooterRepGraph.Replay.RefreshFrames"), CVar_ShooterRepGraph_ReplayRefreshFrames, TEXT("Replication frames between rebuilds of the recorded actor list and its rates"), ECVF_Default );
+
+float CVar_ShooterRepGraph_ReplayFullRateRadius = 8000.f;
+static FAutoConsoleVariableRef CVarShooterRepGraphReplayFullRateRadius(TEXT("ShooterRepGraph.Replay.FullRateRadius"), CVar_ShooterRepGraph_ReplayFullRateRadius, TEXT("Moving actors within this distance (not squared) of a player's pawn record at full rate"), ECVF_Default );
+
+float CVar_ShooterRepGraph_ReplayStaticDistance = 10.f;
+static FAutoConsoleVariableRef CVarShooterRepGraphReplayStaticDistance(TEXT("ShooterRepGraph.Replay.StaticDistance"), CVar_ShooterRepGraph_ReplayStaticDistance, TEXT("Actors that moved less than this between rebuilds count as static"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_ReplayReducedRateDivisor = 4;
+static FAutoConsoleVariableRef CVarShooterRepGraphReplayReducedRateDivisor(TEXT("ShooterRepGraph.Replay.ReducedRateDivisor"), CVar_ShooterRepGraph_ReplayReducedRateDivisor, TEXT("Distant and static actors record this many times less often than their class rate"), ECVF_Default );
+
 // ----------------------------------------------------------------------------------------------------------
 
 
@@ -137,7 +266,7 @@ void InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool b
 	if (bSpatialize)
 	{
 		Info.SetCullDistanceSquared(CDO->NetCullDistanceSquared);
-		UE_LOG(LogShooterReplicationGraph, Log, TEXT("Setting cull distance for %s to %f (%f)"), *Class->GetName(), Info.GetCullDistanceSquared(), Info.GetCullDistance());
+		UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("Setting cull distance for %s to %f (%f)"), *Class->GetName(), Info.GetCullDistanceSquared(), Info.GetCullDistance());
 	}
 
 	Info.ReplicationPeriodFrame = FMath::Max<uint32>( (uint32)FMath::RoundToFloat(ServerMaxTickRate / CDO->NetUpdateFrequency), 1);
@@ -148,7 +277,7 @@ void InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool b
 		NativeClass = NativeClass->GetSuperClass();
 	}
 
-	UE_LOG(LogShooterReplicationGraph, Log, TEXT("Setting replication period for %s (%s) to %d frames (%.2f)"), *Class->GetName(), *NativeClass->GetName(), Info.ReplicationPeriodFrame, CDO->NetUpdateFrequency);
+	UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("Setting replication period for %s (%s) to %d frames (%.2f)"), *Class->GetName(), *NativeClass->GetName(), Info.ReplicationPeriodFrame, CDO->NetUpdateFrequency);
 }
 
 void UShooterReplicationGraph::ResetGameWorldState()
@@ -156,6 +285,7 @@ void UShooterReplicationGraph::ResetGameWorldState()
 	Super::ResetGameWorldState();
 
 	AlwaysRelevantStreamingLevelActors.Empty();
+	SeatedDrivers.Empty();
 
 	for (UNetReplicationGraphConnection* ConnManager : Connections)
 	{
@@ -165,6 +295,10 @@ void UShooterReplicationGraph::ResetGameWorldState()
 			{
 				AlwaysRelevantConnectionNode->ResetGameWorldState();
 			}
+			else if (UShooterReplicationGraphNode_Replay* ReplayNode = Cast<UShooterReplicationGraphNode_Replay>(ConnectionNode))
+			{
+				ReplayNode->ResetGameWorldState();
+			}
 		}
 	}
 
@@ -176,6 +310,10 @@ void UShooterReplicationGraph::ResetGameWorldState()
 			{
 				AlwaysRelevantConnectionNode->ResetGameWorldState();
 			}
+			else if (UShooterReplicationGraphNode_Replay* ReplayNode = Cast<UShooterReplicationGraphNode_Replay>(ConnectionNode))
+			{
+				ReplayNode->ResetGameWorldState();
+			}
 		}
 	}
 }
@@ -184,6 +322,87 @@ void UShooterReplicationGraph::InitGlobalActorClassSettings()
 {
 	Super::InitGlobalActorClassSettings();
 
+	// Dedicated servers load the table written at cook time (UShooterRepGraphClassCacheCommandlet) instead of walking every class on each map load
+	bool bLoadedFromCache = false;
+	if (CVar_ShooterRepGraph_ClassCache && IsRunningDedicatedServer())
+	{
+		if (const FShooterRepGraphClassCache* Cache = FShooterRepGraphClassCache::GetLoaded())
+		{
+			bLoadedFromCache = ApplyClassSettings(*Cache);
+		}
+	}
+
+	if (!bLoadedFromCache)
+	{
+		BuildClassSettings(NetDriver->NetServerMaxTickRate);
+	}
+
+#if CSV_PROFILER
+	// Per class replication time and bits in csvprofile captures. Everything else shows up as "Other".
+	CSVTracker.SetExplicitClassTracking( ACircuitWheeledVehiclePawn::StaticClass(), TEXT("Vehicle") );
+	CSVTracker.SetExplicitClassTracking( AShooterCharacter::StaticClass(), TEXT("Character") );
+	CSVTracker.SetExplicitClassTracking( APlayerState::StaticClass(), TEXT("PlayerState") );
+	CSVTracker.SetExplicitClassTracking( AShooterPickup::StaticClass(), TEXT("Pickup") );
+	CSVTracker.SetImplicitClassTracking( APawn::StaticClass(), TEXT("OtherPawn") );
+#endif
+
+	UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.ListSize = 12;
+
+	// Print out what we came up with. Thousands of lines with blueprints loaded, so only when asked for
+	if (UE_LOG_ACTIVE(LogShooterReplicationGraph, Verbose))
+	{
+		UE_LOG(LogShooterReplicationGraph, Verbose, TEXT(""));
+		UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("Class Routing Map: "));
+		UEnum* Enum = StaticEnum<EClassRepNodeMapping>();
+		for (auto ClassMapIt = ClassRepNodePolicies.CreateIterator(); ClassMapIt; ++ClassMapIt)
+		{		
+			UClass* Class = CastChecked<UClass>(ClassMapIt.Key().ResolveObjectPtr());
+			const EClassRepNodeMapping Mapping = ClassMapIt.Value();
+
+			// Only print if different than native class
+			UClass* ParentNativeClass = GetParentNativeClass(Class);
+			const EClassRepNodeMapping* ParentMapping = ClassRepNodePolicies.Get(ParentNativeClass);
+			if (ParentMapping && Class != ParentNativeClass && Mapping == *ParentMapping)
+			{
+				continue;
+			}
+
+			UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("  %s (%s) -> %s"), *Class->GetName(), *GetNameSafe(ParentNativeClass), *Enum->GetNameStringByValue(static_cast<uint32>(Mapping)));
+		}
+
+		UE_LOG(LogShooterReplicationGraph, Verbose, TEXT(""));
+		UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("Class Settings Map: "));
+		for (auto ClassRepInfoIt = GlobalActorReplicationInfoMap.CreateClassMapIterator(); ClassRepInfoIt; ++ClassRepInfoIt)
+		{
+			UClass* Class = CastChecked<UClass>(ClassRepInfoIt.Key().ResolveObjectPtr());
+			const FClassReplicationInfo& ClassInfo = ClassRepInfoIt.Value();
+			UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("  %s (%s) -> %s"), *Class->GetName(), *GetNameSafe(GetParentNativeClass(Class)), *ClassInfo.BuildDebugStringDelta());
+		}
+	}
+
+	// Rep destruct infos based on CVar value
+	DestructInfoMaxDistanceSquared = CVar_ShooterRepGraph_DestructionInfoMaxDist * CVar_ShooterRepGraph_DestructionInfoMaxDist;
+
+	// -------------------------------------------------------
+	//	Register for game code callbacks.
+	//	This could have been done the other way: E.g, AMyGameActor could do GetNetDriver()->GetReplicationDriver<UShooterReplicationGraph>()->OnMyGameEvent etc.
+	//	This way at least keeps the rep graph out of game code directly and allows rep graph to exist in its own module
+	//	So for now, erring on the side of a cleaning dependencies between classes.
+	// -------------------------------------------------------
+	
+	AShooterCharacter::NotifyEquipWeapon.AddUObject(this, &UShooterReplicationGraph::OnCharacterEquipWeapon);
+	AShooterCharacter::NotifyUnEquipWeapon.AddUObject(this, &UShooterReplicationGraph::OnCharacterUnEquipWeapon);
+
+	ACircuitWheeledVehiclePawn::NotifyDriverEnter.AddUObject(this, &UShooterReplicationGraph::OnVehicleDriverEnter);
+	ACircuitWheeledVehiclePawn::NotifyDriverExit.AddUObject(this, &UShooterReplicationGraph::OnVehicleDriverExit);
+
+#if WITH_GAMEPLAY_DEBUGGER
+	AGameplayDebuggerCategoryReplicator::NotifyDebuggerOwnerChange.AddUObject(this, &UShooterReplicationGraph::OnGameplayDebuggerOwnerChange);
+#endif
+}
+
+void UShooterReplicationGraph::BuildClassSettings(float ServerMaxTickRate)
+{
 	// ---------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	// Programatically build the rules.
 	// ---------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -192,37 +411,23 @@ void UShooterReplicationGraph::InitGlobalActorClassSettings()
 
 	AddInfo( AShooterWeapon::StaticClass(),							EClassRepNodeMapping::NotRouted);				// Handled via DependantActor replication (Pawn)
 	AddInfo( ALevelScriptActor::StaticClass(),						EClassRepNodeMapping::NotRouted);				// Not needed
-	AddInfo( APlayerState::StaticClass(),							EClassRepNodeMapping::NotRouted);				// Special cased via UShooterReplicationGraphNode_PlayerStateFrequencyLimiter
+	AddInfo( APlayerState::StaticClass(),							EClassRepNodeMapping::FrequencyLimited_PlayerState);	// Special cased via UShooterReplicationGraphNode_PlayerStateFrequencyLimiter
 	AddInfo( AReplicationGraphDebugActor::StaticClass(),			EClassRepNodeMapping::NotRouted);				// Not needed. Replicated special case inside RepGraph
 	AddInfo( AInfo::StaticClass(),									EClassRepNodeMapping::RelevantAllConnections);	// Non spatialized, relevant to all
 	AddInfo( AShooterPickup::StaticClass(),							EClassRepNodeMapping::Spatialize_Static);		// Spatialized and never moves. Routes to GridNode.
+	AddInfo( ACircuitWheeledVehiclePawn::StaticClass(),				EClassRepNodeMapping::Spatialize_Dynamic);		// Always moving when used. Drivers ride along as dependent actors.
 
 #if WITH_GAMEPLAY_DEBUGGER
 	AddInfo( AGameplayDebuggerCategoryReplicator::StaticClass(),	EClassRepNodeMapping::NotRouted);				// Replicated via UShooterReplicationGraphNode_AlwaysRelevant_ForConnection
 #endif
 
+	// Saved off for the second pass below
 	TArray<UClass*> AllReplicatedClasses;
+	GetReplicatedClasses(AllReplicatedClasses);
 
-	for (TObjectIterator<UClass> It; It; ++It)
+	for (UClass* Class : AllReplicatedClasses)
 	{
-		UClass* Class = *It;
-		AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
-		if (!ActorCDO || !ActorCDO->GetIsReplicated())
-		{
-			continue;
-		}
-
-		// Skip SKEL and REINST classes.
-		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
-		{
-			continue;
-		}
-
-		// --------------------------------------------------------------------
-		// This is a replicated class. Save this off for the second pass below
-		// --------------------------------------------------------------------
-		
-		AllReplicatedClasses.Add(Class);
+		AActor* ActorCDO = Class->GetDefaultObject<AActor>();
 
 		// Skip if already in the map (added explicitly)
 		if (ClassRepNodePolicies.Contains(Class, false))
@@ -235,6 +440,12 @@ void UShooterReplicationGraph::InitGlobalActorClassSettings()
 			return CDO->GetIsReplicated() && (!(CDO->bAlwaysRelevant || CDO->bOnlyRelevantToOwner || CDO->bNetUseOwnerRelevancy));
 		};
 
+		// Classes opt into dormancy by starting dormant in their defaults (AGravityPropActor, wire devices). UCustomGravityComponent and UWireComponent wake them.
+		auto WantsDormancy = [](const AActor* CDO)
+		{
+			return CDO->NetDormancy > DORM_Awake;
+		};
+
 		auto GetLegacyDebugStr = [](const AActor* CDO)
 		{
 			return FString::Printf(TEXT("%s [%d/%d/%d]"), *CDO->GetClass()->GetName(), CDO->bAlwaysRelevant, CDO->bOnlyRelevantToOwner, CDO->bNetUseOwnerRelevancy);
@@ -248,6 +459,7 @@ void UShooterReplicationGraph::InitGlobalActorClassSettings()
 				&&	SuperCDO->bAlwaysRelevant == ActorCDO->bAlwaysRelevant
 				&&	SuperCDO->bOnlyRelevantToOwner == ActorCDO->bOnlyRelevantToOwner
 				&&	SuperCDO->bNetUseOwnerRelevancy == ActorCDO->bNetUseOwnerRelevancy
+				&&	WantsDormancy(SuperCDO) == WantsDormancy(ActorCDO)
 				)
 			{
 				continue;
@@ -255,14 +467,14 @@ void UShooterReplicationGraph::InitGlobalActorClassSettings()
 
 			if (ShouldSpatialize(ActorCDO) == false && ShouldSpatialize(SuperCDO) == true)
 			{
-				UE_LOG(LogShooterReplicationGraph, Log, TEXT("Adding %s to NonSpatializedChildClasses. (Parent: %s)"), *GetLegacyDebugStr(ActorCDO), *GetLegacyDebugStr(SuperCDO));
+				UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("Adding %s to NonSpatializedChildClasses. (Parent: %s)"), *GetLegacyDebugStr(ActorCDO), *GetLegacyDebugStr(SuperCDO));
 				NonSpatializedChildClasses.Add(Class);
 			}
 		}
 			
 		if (ShouldSpatialize(ActorCDO))
 		{
-			AddInfo(Class, EClassRepNodeMapping::Spatialize_Dynamic);
+			AddInfo(Class, WantsDormancy(ActorCDO) ? EClassRepNodeMapping::Spatialize_Dormancy : EClassRepNodeMapping::Spatialize_Dynamic);
 		}
 		else if (ActorCDO->bAlwaysRelevant && !ActorCDO->bOnlyRelevantToOwner)
 		{
@@ -284,12 +496,18 @@ void UShooterReplicationGraph::InitGlobalActorClassSettings()
 	PawnClassRepInfo.SetCullDistanceSquared(15000.f * 15000.f); // Yuck
 	SetClassInfo( APawn::StaticClass(), PawnClassRepInfo );
 
+	FClassReplicationInfo VehicleClassRepInfo;
+	VehicleClassRepInfo.DistancePriorityScale = 1.f;
+	VehicleClassRepInfo.StarvationPriorityScale = 1.f;
+	VehicleClassRepInfo.ActorChannelFrameTimeout = 4;
+	VehicleClassRepInfo.ReplicationPeriodFrame = 1;
+	VehicleClassRepInfo.SetCullDistanceSquared(FMath::Square(CVar_ShooterRepGraph_VehicleCullDistance));
+	SetClassInfo( ACircuitWheeledVehiclePawn::StaticClass(), VehicleClassRepInfo );
+
 	FClassReplicationInfo PlayerStateRepInfo;
 	PlayerStateRepInfo.DistancePriorityScale = 0.f;
 	PlayerStateRepInfo.ActorChannelFrameTimeout = 0;
 	SetClassInfo( APlayerState::StaticClass(), PlayerStateRepInfo );
-	
-	UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.ListSize = 12;
 
 	// Set FClassReplicationInfo based on legacy settings from all replicated classes
 	for (UClass* ReplicatedClass : AllReplicatedClasses)
@@ -302,58 +520,142 @@ void UShooterReplicationGraph::InitGlobalActorClassSettings()
 		const bool bClassIsSpatialized = IsSpatialized(ClassRepNodePolicies.GetChecked(ReplicatedClass));
 
 		FClassReplicationInfo ClassInfo;
-		InitClassReplicationInfo(ClassInfo, ReplicatedClass, bClassIsSpatialized, NetDriver->NetServerMaxTickRate);
+		InitClassReplicationInfo(ClassInfo, ReplicatedClass, bClassIsSpatialized, ServerMaxTickRate);
 		GlobalActorReplicationInfoMap.SetClassInfo( ReplicatedClass, ClassInfo );
 	}
+}
+
+void UShooterReplicationGraph::GetReplicatedClasses(TArray<UClass*>& OutClasses)
+{
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if (!ActorCDO || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		// Skip SKEL and REINST classes.
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		OutClasses.Add(Class);
+	}
+}
 
+uint32 UShooterReplicationGraph::GetClassSettingsInputsHash(float ServerMaxTickRate)
+{
+	// Everything BuildClassSettings reads that isn't on a class default object
+	uint32 Hash = GetTypeHash(ServerMaxTickRate);
+	Hash = HashCombine(Hash, GetTypeHash(CVar_ShooterRepGraph_VehicleCullDistance));
+	Hash = HashCombine(Hash, GetTypeHash(FEngineVersion::Current().GetChangelist()));
+	Hash = HashCombine(Hash, GetTypeHash(FString(FApp::GetBuildVersion())));
+	return Hash;
+}
 
-	// Print out what we came up with
-	UE_LOG(LogShooterReplicationGraph, Log, TEXT(""));
-	UE_LOG(LogShooterReplicationGraph, Log, TEXT("Class Routing Map: "));
-	UEnum* Enum = StaticEnum<EClassRepNodeMapping>();
-	for (auto ClassMapIt = ClassRepNodePolicies.CreateIterator(); ClassMapIt; ++ClassMapIt)
-	{		
-		UClass* Class = CastChecked<UClass>(ClassMapIt.Key().ResolveObjectPtr());
-		const EClassRepNodeMapping Mapping = ClassMapIt.Value();
+bool UShooterReplicationGraph::ApplyClassSettings(const FShooterRepGraphClassCache& Cache)
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraph_ApplyClassSettings );
 
-		// Only print if different than native class
-		UClass* ParentNativeClass = GetParentNativeClass(Class);
-		const EClassRepNodeMapping* ParentMapping = ClassRepNodePolicies.Get(ParentNativeClass);
-		if (ParentMapping && Class != ParentNativeClass && Mapping == *ParentMapping)
+	if (Cache.InputsHash != GetClassSettingsInputsHash(NetDriver->NetServerMaxTickRate))
+	{
+		UE_LOG(LogShooterReplicationGraph, Warning, TEXT("Class cache %s was written by a different build or tick rate, building class settings from scratch"), *FShooterRepGraphClassCache::GetFilename());
+		return false;
+	}
+
+	// Actor blueprints the commandlet never saw (content added or removed since the cook) have no settings in the cache
+	if (Cache.ContentHash != FShooterRepGraphClassCache::GetContentHash())
+	{
+		UE_LOG(LogShooterReplicationGraph, Warning, TEXT("Class cache %s is stale (actor blueprints changed since it was written), building class settings from scratch"), *FShooterRepGraphClassCache::GetFilename());
+		return false;
+	}
+
+	// Check everything before touching the maps so a stale cache falls back cleanly
+	TArray<TPair<UClass*, const FShooterRepGraphClassCacheEntry*>> LoadedEntries;
+	LoadedEntries.Reserve(Cache.Entries.Num());
+	for (const FShooterRepGraphClassCacheEntry& Entry : Cache.Entries)
+	{
+		// Classes that aren't loaded yet wouldn't have been seen by BuildClassSettings either, they pick up their parent's settings
+		UClass* Class = FindObject<UClass>(nullptr, *Entry.ClassPath);
+		if (Class == nullptr)
 		{
 			continue;
 		}
 
-		UE_LOG(LogShooterReplicationGraph, Log, TEXT("  %s (%s) -> %s"), *Class->GetName(), *GetNameSafe(ParentNativeClass), *Enum->GetNameStringByValue(static_cast<uint32>(Mapping)));
+		if (FShooterRepGraphClassCache::ComputeFingerprint(Class) != Entry.Fingerprint)
+		{
+			UE_LOG(LogShooterReplicationGraph, Warning, TEXT("Class cache is stale (%s changed), building class settings from scratch"), *Entry.ClassPath);
+			return false;
+		}
+
+		LoadedEntries.Emplace(Class, &Entry);
 	}
 
-	UE_LOG(LogShooterReplicationGraph, Log, TEXT(""));
-	UE_LOG(LogShooterReplicationGraph, Log, TEXT("Class Settings Map: "));
-	FClassReplicationInfo DefaultValues;
-	for (auto ClassRepInfoIt = GlobalActorReplicationInfoMap.CreateClassMapIterator(); ClassRepInfoIt; ++ClassRepInfoIt)
+	for (const TPair<UClass*, const FShooterRepGraphClassCacheEntry*>& Pair : LoadedEntries)
 	{
-		UClass* Class = CastChecked<UClass>(ClassRepInfoIt.Key().ResolveObjectPtr());
-		const FClassReplicationInfo& ClassInfo = ClassRepInfoIt.Value();
-		UE_LOG(LogShooterReplicationGraph, Log, TEXT("  %s (%s) -> %s"), *Class->GetName(), *GetNameSafe(GetParentNativeClass(Class)), *ClassInfo.BuildDebugStringDelta());
+		const FShooterRepGraphClassCacheEntry& Entry = *Pair.Value;
+		if (Entry.bHasMapping)
+		{
+			ClassRepNodePolicies.Set(Pair.Key, static_cast<EClassRepNodeMapping>(Entry.Mapping));
+		}
+		if (Entry.bHasClassInfo)
+		{
+			GlobalActorReplicationInfoMap.SetClassInfo(Pair.Key, Entry.ClassInfo);
+		}
+		if (Entry.bNonSpatializedChild)
+		{
+			NonSpatializedChildClasses.Add(Pair.Key);
+		}
 	}
 
+	UE_LOG(LogShooterReplicationGraph, Log, TEXT("Loaded settings for %d of %d classes from %s"), LoadedEntries.Num(), Cache.Entries.Num(), *FShooterRepGraphClassCache::GetFilename());
+	return true;
+}
 
-	// Rep destruct infos based on CVar value
-	DestructInfoMaxDistanceSquared = CVar_ShooterRepGraph_DestructionInfoMaxDist * CVar_ShooterRepGraph_DestructionInfoMaxDist;
+void UShooterReplicationGraph::ExportClassSettings(FShooterRepGraphClassCache& OutCache, float ServerMaxTickRate)
+{
+	OutCache.InputsHash = GetClassSettingsInputsHash(ServerMaxTickRate);
+	OutCache.ContentHash = FShooterRepGraphClassCache::GetContentHash();
+	OutCache.Entries.Reset();
 
-	// -------------------------------------------------------
-	//	Register for game code callbacks.
-	//	This could have been done the other way: E.g, AMyGameActor could do GetNetDriver()->GetReplicationDriver<UShooterReplicationGraph>()->OnMyGameEvent etc.
-	//	This way at least keeps the rep graph out of game code directly and allows rep graph to exist in its own module
-	//	So for now, erring on the side of a cleaning dependencies between classes.
-	// -------------------------------------------------------
-	
-	AShooterCharacter::NotifyEquipWeapon.AddUObject(this, &UShooterReplicationGraph::OnCharacterEquipWeapon);
-	AShooterCharacter::NotifyUnEquipWeapon.AddUObject(this, &UShooterReplicationGraph::OnCharacterUnEquipWeapon);
+	TMap<UClass*, int32> EntryIndices;
+	auto FindOrAddEntry = [&](UClass* Class) -> FShooterRepGraphClassCacheEntry&
+	{
+		if (int32* Index = EntryIndices.Find(Class))
+		{
+			return OutCache.Entries[*Index];
+		}
 
-#if WITH_GAMEPLAY_DEBUGGER
-	AGameplayDebuggerCategoryReplicator::NotifyDebuggerOwnerChange.AddUObject(this, &UShooterReplicationGraph::OnGameplayDebuggerOwnerChange);
-#endif
+		FShooterRepGraphClassCacheEntry& Entry = OutCache.Entries[OutCache.Entries.AddDefaulted()];
+		Entry.ClassPath = Class->GetPathName();
+		Entry.Fingerprint = FShooterRepGraphClassCache::ComputeFingerprint(Class);
+		Entry.bNonSpatializedChild = NonSpatializedChildClasses.Contains(Class);
+		EntryIndices.Add(Class, OutCache.Entries.Num() - 1);
+		return Entry;
+	};
+
+	for (auto ClassMapIt = ClassRepNodePolicies.CreateIterator(); ClassMapIt; ++ClassMapIt)
+	{
+		if (UClass* Class = Cast<UClass>(ClassMapIt.Key().ResolveObjectPtr()))
+		{
+			FShooterRepGraphClassCacheEntry& Entry = FindOrAddEntry(Class);
+			Entry.bHasMapping = true;
+			Entry.Mapping = static_cast<uint8>(ClassMapIt.Value());
+		}
+	}
+
+	for (auto ClassRepInfoIt = GlobalActorReplicationInfoMap.CreateClassMapIterator(); ClassRepInfoIt; ++ClassRepInfoIt)
+	{
+		if (UClass* Class = Cast<UClass>(ClassRepInfoIt.Key().ResolveObjectPtr()))
+		{
+			FShooterRepGraphClassCacheEntry& Entry = FindOrAddEntry(Class);
+			Entry.bHasClassInfo = true;
+			Entry.ClassInfo = ClassRepInfoIt.Value();
+		}
+	}
 }
 
 void UShooterReplicationGraph::InitGlobalGraphNodes()
@@ -368,16 +670,54 @@ void UShooterReplicationGraph::InitGlobalGraphNodes()
 	//	Spatial Actors
 	// -----------------------------------------------
 
-	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
-	GridNode->CellSize = CVar_ShooterRepGraph_CellSize;
-	GridNode->SpatialBias = FVector2D(CVar_ShooterRepGraph_SpatialBiasX, CVar_ShooterRepGraph_SpatialBiasY);
+	if (CVar_ShooterRepGraph_Use3DSpatialization)
+	{
+		GridNode3D = CreateNewNode<UShooterReplicationGraphNode_GridSpatialization3D>();
+		GridNode3D->CellSize = FMath::Max(CVar_ShooterRepGraph_CellSize3D, 100.f);
+		GridNode3D->GatherRadius = FMath::Max(CVar_ShooterRepGraph_GatherRadius3D, 0);
+
+		// Gather far enough out that no spatialized class is culled by the grid before its own cull distance (vehicles see further than pawns)
+		float MaxCullDistanceSquared = 0.f;
+		for (auto ClassRepInfoIt = GlobalActorReplicationInfoMap.CreateClassMapIterator(); ClassRepInfoIt; ++ClassRepInfoIt)
+		{
+			UClass* Class = Cast<UClass>(ClassRepInfoIt.Key().ResolveObjectPtr());
+			const EClassRepNodeMapping* Mapping = Class ? ClassRepNodePolicies.Get(Class) : nullptr;
+			if (Mapping && IsSpatialized(*Mapping))
+			{
+				MaxCullDistanceSquared = FMath::Max(MaxCullDistanceSquared, ClassRepInfoIt.Value().GetCullDistanceSquared());
+			}
+		}
+
+		const int32 CoveringRadius = FMath::CeilToInt(FMath::Sqrt(MaxCullDistanceSquared) / GridNode3D->CellSize);
+		if (CoveringRadius > GridNode3D->GatherRadius)
+		{
+			UE_LOG(LogShooterReplicationGraph, Log, TEXT("Raising 3D grid gather radius from %d to %d cells to cover a %.0f cull distance"), GridNode3D->GatherRadius, CoveringRadius, FMath::Sqrt(MaxCullDistanceSquared));
+			GridNode3D->GatherRadius = CoveringRadius;
+		}
 
-	if (CVar_ShooterRepGraph_DisableSpatialRebuilds)
+		AddGlobalGraphNode(GridNode3D);
+	}
+	else
 	{
-		GridNode->AddSpatialRebuildBlacklistClass(AActor::StaticClass()); // Disable All spatial rebuilding
+		GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+		GridNode->CellSize = CVar_ShooterRepGraph_CellSize;
+		GridNode->SpatialBias = FVector2D(CVar_ShooterRepGraph_SpatialBiasX, CVar_ShooterRepGraph_SpatialBiasY);
+
+		if (CVar_ShooterRepGraph_DisableSpatialRebuilds)
+		{
+			GridNode->AddSpatialRebuildBlacklistClass(AActor::StaticClass()); // Disable All spatial rebuilding
+		}
+
+		AddGlobalGraphNode(GridNode);
+	}
+
+	if (CVar_ShooterRepGraph_UseGravityFieldNode)
+	{
+		GravityFieldNode = CreateNewNode<UShooterReplicationGraphNode_GravityField>();
+		GravityFieldNode->CrossFieldDistance = FMath::Max(CVar_ShooterRepGraph_GravityFieldCrossFieldDistance, 0.f);
+
+		AddGlobalGraphNode(GravityFieldNode);
 	}
-	
-	AddGlobalGraphNode(GridNode);
 
 	// -----------------------------------------------
 	//	Always Relevant (to everyone) Actors
@@ -388,7 +728,7 @@ void UShooterReplicationGraph::InitGlobalGraphNodes()
 	// -----------------------------------------------
 	//	Player State specialization. This will return a rolling subset of the player states to replicate
 	// -----------------------------------------------
-	UShooterReplicationGraphNode_PlayerStateFrequencyLimiter* PlayerStateNode = CreateNewNode<UShooterReplicationGraphNode_PlayerStateFrequencyLimiter>();
+	PlayerStateNode = CreateNewNode<UShooterReplicationGraphNode_PlayerStateFrequencyLimiter>();
 	AddGlobalGraphNode(PlayerStateNode);
 }
 
@@ -403,6 +743,13 @@ void UShooterReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConn
 	RepGraphConnection->OnClientVisibleLevelNameRemove.AddUObject(AlwaysRelevantConnectionNode, &UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityRemove);
 
 	AddConnectionGraphNode(AlwaysRelevantConnectionNode, RepGraphConnection);
+
+	if (CVar_ShooterRepGraph_ReplayEnable && IsReplayConnection(RepGraphConnection->NetConnection))
+	{
+		UShooterReplicationGraphNode_Replay* ReplayNode = CreateNewNode<UShooterReplicationGraphNode_Replay>();
+		AddConnectionGraphNode(ReplayNode, RepGraphConnection);
+		ReplayNodes.Add(ReplayNode);
+	}
 }
 
 EClassRepNodeMapping UShooterReplicationGraph::GetMappingPolicy(UClass* Class)
@@ -437,21 +784,30 @@ void UShooterReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedA
 			break;
 		}
 
-		case EClassRepNodeMapping::Spatialize_Static:
+		case EClassRepNodeMapping::FrequencyLimited_PlayerState:
 		{
-			GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+			PlayerStateNode->NotifyAddNetworkActor(ActorInfo);
 			break;
 		}
-		
-		case EClassRepNodeMapping::Spatialize_Dynamic:
+
+		case EClassRepNodeMapping::Spatialize_Static:
 		{
-			GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+			AddActorToGrid(ActorInfo, GlobalInfo, Policy);
 			break;
 		}
 		
+		case EClassRepNodeMapping::Spatialize_Dynamic:
 		case EClassRepNodeMapping::Spatialize_Dormancy:
 		{
-			GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+			// The gravity node keeps actors that are inside a field and hands the rest back to the grid
+			if (ShouldRouteToGravityFieldNode(ActorInfo))
+			{
+				GravityFieldNode->AddActor(ActorInfo, Policy);
+			}
+			else
+			{
+				AddActorToGrid(ActorInfo, GlobalInfo, Policy);
+			}
 			break;
 		}
 	};
@@ -459,7 +815,56 @@ void UShooterReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedA
 
 void UShooterReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
 {
+	if (SeatedDrivers.Num() > 0)
+	{
+		// A seated driver was already taken out of the spatial nodes
+		TWeakObjectPtr<AActor> Vehicle;
+		if (SeatedDrivers.RemoveAndCopyValue(ActorInfo.Actor, Vehicle))
+		{
+			if (Vehicle.IsValid())
+			{
+				GlobalActorReplicationInfoMap.RemoveDependentActor(Vehicle.Get(), ActorInfo.Actor);
+			}
+			return;
+		}
+
+		// A vehicle going away without a proper exit leaves its driver to replicate on its own again
+		if (ActorInfo.Class->IsChildOf(ACircuitWheeledVehiclePawn::StaticClass()))
+		{
+			for (auto It = SeatedDrivers.CreateIterator(); It; ++It)
+			{
+				AActor* Driver = It.Key().Get();
+				if (Driver == nullptr)
+				{
+					// Driver was destroyed without being removed from the graph
+					It.RemoveCurrent();
+				}
+				else if (It.Value() == ActorInfo.Actor)
+				{
+					It.RemoveCurrent();
+					UnseatDriver(Driver, ActorInfo.Actor);
+				}
+			}
+		}
+	}
+
 	EClassRepNodeMapping Policy = GetMappingPolicy(ActorInfo.Class);
+
+	if (ReplayNodes.Num() > 0 && IsSpatialized(Policy))
+	{
+		for (int32 Idx = ReplayNodes.Num() - 1; Idx >= 0; --Idx)
+		{
+			if (UShooterReplicationGraphNode_Replay* ReplayNode = ReplayNodes[Idx].Get())
+			{
+				ReplayNode->NotifyRemoveNetworkActor(ActorInfo, false);
+			}
+			else
+			{
+				ReplayNodes.RemoveAtSwap(Idx);
+			}
+		}
+	}
+
 	switch(Policy)
 	{
 		case EClassRepNodeMapping::NotRouted:
@@ -484,339 +889,1454 @@ void UShooterReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicat
 			break;
 		}
 
-		case EClassRepNodeMapping::Spatialize_Static:
+		case EClassRepNodeMapping::FrequencyLimited_PlayerState:
 		{
-			GridNode->RemoveActor_Static(ActorInfo);
+			PlayerStateNode->NotifyRemoveNetworkActor(ActorInfo);
 			break;
 		}
-		
-		case EClassRepNodeMapping::Spatialize_Dynamic:
+
+		case EClassRepNodeMapping::Spatialize_Static:
 		{
-			GridNode->RemoveActor_Dynamic(ActorInfo);
+			RemoveActorFromGrid(ActorInfo, Policy);
 			break;
 		}
 		
+		case EClassRepNodeMapping::Spatialize_Dynamic:
 		case EClassRepNodeMapping::Spatialize_Dormancy:
 		{
-			GridNode->RemoveActor_Dormancy(ActorInfo);
+			// Routing depends on the actor's components, so just ask the gravity node first. It takes unbound actors off the grid itself.
+			if (GravityFieldNode && GravityFieldNode->NotifyRemoveNetworkActor(ActorInfo, false))
+			{
+				break;
+			}
+
+			RemoveActorFromGrid(ActorInfo, Policy);
 			break;
 		}
 	};
 }
 
-// Since we listen to global (static) events, we need to watch out for cross world broadcasts (PIE)
-#if WITH_EDITOR
-#define CHECK_WORLDS(X) if(X->GetWorld() != GetWorld()) return;
-#else
-#define CHECK_WORLDS(X)
-#endif
-
-void UShooterReplicationGraph::OnCharacterEquipWeapon(AShooterCharacter* Character, AShooterWeapon* NewWeapon)
+void UShooterReplicationGraph::AddActorToGrid(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo, EClassRepNodeMapping Policy)
 {
-	if (Character && NewWeapon)
+	switch(Policy)
+	{
+		case EClassRepNodeMapping::Spatialize_Static:
+		{
+			if (GridNode3D)
+			{
+				GridNode3D->AddActor_Static(ActorInfo, GlobalInfo);
+			}
+			else
+			{
+				GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+			}
+			break;
+		}
+
+		case EClassRepNodeMapping::Spatialize_Dynamic:
+		{
+			if (GridNode3D)
+			{
+				GridNode3D->AddActor_Dynamic(ActorInfo, GlobalInfo);
+			}
+			else
+			{
+				GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+			}
+			break;
+		}
+
+		case EClassRepNodeMapping::Spatialize_Dormancy:
+		{
+			if (GridNode3D)
+			{
+				GridNode3D->AddActor_Dormancy(ActorInfo, GlobalInfo);
+			}
+			else
+			{
+				GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+			}
+			break;
+		}
+
+		default:
+		{
+			checkNoEntry();
+			break;
+		}
+	};
+}
+
+void UShooterReplicationGraph::AddActorToGrid(AActor* Actor, EClassRepNodeMapping Policy)
+{
+	AddActorToGrid(FNewReplicatedActorInfo(Actor), GlobalActorReplicationInfoMap.Get(Actor), Policy);
+}
+
+void UShooterReplicationGraph::RemoveActorFromGrid(const FNewReplicatedActorInfo& ActorInfo, EClassRepNodeMapping Policy)
+{
+	switch(Policy)
+	{
+		case EClassRepNodeMapping::Spatialize_Static:
+		{
+			if (GridNode3D)
+			{
+				GridNode3D->RemoveActor_Static(ActorInfo);
+			}
+			else
+			{
+				GridNode->RemoveActor_Static(ActorInfo);
+			}
+			break;
+		}
+
+		case EClassRepNodeMapping::Spatialize_Dynamic:
+		{
+			if (GridNode3D)
+			{
+				GridNode3D->RemoveActor_Dynamic(ActorInfo);
+			}
+			else
+			{
+				GridNode->RemoveActor_Dynamic(ActorInfo);
+			}
+			break;
+		}
+
+		case EClassRepNodeMapping::Spatialize_Dormancy:
+		{
+			if (GridNode3D)
+			{
+				GridNode3D->RemoveActor_Dormancy(ActorInfo);
+			}
+			else
+			{
+				GridNode->RemoveActor_Dormancy(ActorInfo);
+			}
+			break;
+		}
+
+		default:
+		{
+			checkNoEntry();
+			break;
+		}
+	};
+}
+
+int32 UShooterReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	// A recording driver's own graph would write over the game graph's files
+	const bool bRecordMetrics = FShooterRepGraphMetrics::IsEnabled() && !(NetDriver && NetDriver->IsA<UDemoNetDriver>());
+	const double StartTime = bRecordMetrics ? FPlatformTime::Seconds() : 0.0;
+
+	const int32 Result = Super::ServerReplicateActors(DeltaSeconds);
+
+	if (bRecordMetrics)
+	{
+		RecordMetrics(FPlatformTime::Seconds() - StartTime);
+	}
+
+	if (CVar_ShooterRepGraph_AdaptiveEnable)
+	{
+		UpdateAdaptiveBudgets();
+	}
+
+	return Result;
+}
+
+int32 UShooterReplicationGraph::GetAdaptiveLevel(const UNetConnection* NetConnection) const
+{
+	for (const TPair<UNetReplicationGraphConnection*, FConnectionBudget>& Pair : ConnectionBudgets)
+	{
+		if (Pair.Key->NetConnection == NetConnection)
+		{
+			return Pair.Value.Level;
+		}
+	}
+	return 0;
+}
+
+void UShooterReplicationGraph::UpdateAdaptiveBudgets()
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraph_UpdateAdaptiveBudgets );
+
+	const float Alpha = FMath::Clamp(CVar_ShooterRepGraph_AdaptiveSmoothing, 0.001f, 1.f);
+
+	for (UNetReplicationGraphConnection* ConnManager : Connections)
+	{
+		UNetConnection* NetConnection = ConnManager->NetConnection;
+
+		// Recordings are never short of bandwidth and UShooterReplicationGraphNode_Replay sets their rates
+		if (NetConnection == nullptr || IsReplayConnection(NetConnection))
+		{
+			continue;
+		}
+
+		// Not being able to send at all counts fully, otherwise how close the last second came to the connection's rate
+		float FrameSaturation = 1.f;
+		if (NetConnection->IsNetReady(false))
+		{
+			FrameSaturation = NetConnection->CurrentNetSpeed > 0 ? FMath::Clamp((float)NetConnection->OutBytesPerSecond / (float)NetConnection->CurrentNetSpeed, 0.f, 1.f) : 0.f;
+		}
+
+		FConnectionBudget& Budget = ConnectionBudgets.FindOrAdd(ConnManager);
+		Budget.Saturation += (FrameSaturation - Budget.Saturation) * Alpha;
+	}
+
+	const int32 AdjustFrames = FMath::Max(CVar_ShooterRepGraph_AdaptiveAdjustFrames, 1);
+	if (GetReplicationGraphFrame() % AdjustFrames != 0)
+	{
+		return;
+	}
+
+	for (auto It = ConnectionBudgets.CreateIterator(); It; ++It)
+	{
+		if (!Connections.Contains(It.Key()))
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		FConnectionBudget& Budget = It.Value();
+		const int32 OldLevel = Budget.Level;
+
+		// Separate high and low water marks so a connection sitting near one threshold doesn't flip every adjustment
+		if (Budget.Saturation > CVar_ShooterRepGraph_AdaptiveHighWater && Budget.Level < CVar_ShooterRepGraph_AdaptiveMaxLevel)
+		{
+			Budget.Level++;
+		}
+		else if (Budget.Saturation < CVar_ShooterRepGraph_AdaptiveLowWater && Budget.Level > 0)
+		{
+			Budget.Level--;
+		}
+
+		if (Budget.Level != OldLevel)
+		{
+			UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("Adaptive level for %s %d -> %d (saturation %.2f)"), *It.Key()->NetConnection->Describe(), OldLevel, Budget.Level, Budget.Saturation);
+		}
+
+		// Actors that opened channels since the last pass start from class settings, so keep reapplying while backed off
+		if (Budget.Level > 0 || OldLevel > 0)
+		{
+			ApplyAdaptiveLevel(It.Key(), Budget);
+		}
+	}
+}
+
+void UShooterReplicationGraph::ApplyAdaptiveLevel(UNetReplicationGraphConnection* ConnManager, FConnectionBudget& Budget)
+{
+	// Puts one entry back, unless something else has set its own values since we last touched it
+	auto Restore = [](FConnectionReplicationActorInfo& ConnectionInfo, const FAdaptiveOverride& Override)
+	{
+		if (ConnectionInfo.ReplicationPeriodFrame == Override.AppliedPeriodFrame && ConnectionInfo.GetCullDistanceSquared() == Override.AppliedCullDistanceSquared)
+		{
+			ConnectionInfo.ReplicationPeriodFrame = Override.OriginalPeriodFrame;
+			ConnectionInfo.SetCullDistanceSquared(Override.OriginalCullDistanceSquared);
+		}
+	};
+
+	if (Budget.Level <= 0)
+	{
+		for (const TPair<TWeakObjectPtr<AActor>, FAdaptiveOverride>& Pair : Budget.Overrides)
+		{
+			AActor* Actor = Pair.Key.Get();
+			if (FConnectionReplicationActorInfo* ConnectionInfo = Actor ? ConnManager->ActorInfoMap.Find(Actor) : nullptr)
+			{
+				Restore(*ConnectionInfo, Pair.Value);
+			}
+		}
+		Budget.Overrides.Reset();
+		return;
+	}
+
+	const int32 MaxLevel = FMath::Max(CVar_ShooterRepGraph_AdaptiveMaxLevel, 1);
+	const float LevelAlpha = FMath::Clamp((float)Budget.Level / (float)MaxLevel, 0.f, 1.f);
+	const float CullScale = FMath::Lerp(1.f, FMath::Clamp(CVar_ShooterRepGraph_AdaptiveMinCullScale, 0.1f, 1.f), LevelAlpha);
+	const float CullScaleSq = CullScale * CullScale;
+	const uint32 PeriodMultiplier = 1 + Budget.Level * FMath::Max(CVar_ShooterRepGraph_AdaptivePeriodStep, 0);
+	const uint32 MaxPeriod = (uint32)FMath::Clamp(CVar_ShooterRepGraph_AdaptiveMaxPeriodFrames, 1, 255);
+
+	UNetConnection* NetConnection = ConnManager->NetConnection;
+
+	for (auto It = Budget.Overrides.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (auto MapIt = ConnManager->ActorInfoMap.CreateIterator(); MapIt; ++MapIt)
+	{
+		AActor* Actor = MapIt.Key();
+		FConnectionReplicationActorInfo& ConnectionInfo = *MapIt.Value().Get();
+
+		// The connection's own pawn and player state are what the player feels first, leave them alone
+		if (Actor->GetNetConnection() == NetConnection)
+		{
+			FAdaptiveOverride Override;
+			if (Budget.Overrides.RemoveAndCopyValue(Actor, Override))
+			{
+				Restore(ConnectionInfo, Override);
+			}
+			continue;
+		}
+
+		// Start from what the entry had before we first backed it off. If something else has changed it since, its values are the new base.
+		FAdaptiveOverride* Override = Budget.Overrides.Find(Actor);
+		if (Override && (ConnectionInfo.ReplicationPeriodFrame != Override->AppliedPeriodFrame || ConnectionInfo.GetCullDistanceSquared() != Override->AppliedCullDistanceSquared))
+		{
+			Override = nullptr;
+		}
+		if (Override == nullptr)
+		{
+			Override = &Budget.Overrides.Add(Actor);
+			Override->OriginalPeriodFrame = ConnectionInfo.ReplicationPeriodFrame;
+			Override->OriginalCullDistanceSquared = ConnectionInfo.GetCullDistanceSquared();
+		}
+
+		const uint32 BasePeriod = Override->OriginalPeriodFrame;
+		ConnectionInfo.ReplicationPeriodFrame = FMath::Clamp<uint32>(BasePeriod * PeriodMultiplier, BasePeriod, FMath::Max(MaxPeriod, BasePeriod));
+
+		// Zero means no culling (always relevant), keep it that way
+		const float BaseCullDistanceSq = Override->OriginalCullDistanceSquared;
+		if (BaseCullDistanceSq > 0.f)
+		{
+			ConnectionInfo.SetCullDistanceSquared(BaseCullDistanceSq * CullScaleSq);
+		}
+
+		Override->AppliedPeriodFrame = ConnectionInfo.ReplicationPeriodFrame;
+		Override->AppliedCullDistanceSquared = ConnectionInfo.GetCullDistanceSquared();
+	}
+}
+
+void UShooterReplicationGraph::BeginDestroy()
+{
+	Metrics.Flush();
+
+	Super::BeginDestroy();
+}
+
+void UShooterReplicationGraph::RecordMetrics(double ReplicateSeconds)
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraph_RecordMetrics );
+
+	UWorld* World = GetWorld();
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	const uint32 Frame = GetReplicationGraphFrame();
+	const double Now = World->GetTimeSeconds();
+	Metrics.ConditionalFlush(Now, World->GetMapName());
+
+	FShooterRepGraphFrameSample Sample;
+	Sample.Frame = Frame;
+	Sample.Time = Now;
+	Sample.ReplicateMs = (float)(ReplicateSeconds * 1000.0);
+	Sample.NumConnections = Connections.Num();
+
+	for (UNetReplicationGraphConnection* ConnManager : Connections)
+	{
+		UNetConnection* NetConnection = ConnManager->NetConnection;
+		if (NetConnection == nullptr)
+		{
+			continue;
+		}
+
+		Sample.TotalOutBytesPerSec += NetConnection->OutBytesPerSecond;
+		Sample.MaxOutBytesPerSec = FMath::Max(Sample.MaxOutBytesPerSec, NetConnection->OutBytesPerSecond);
+		if (!NetConnection->IsNetReady(false))
+		{
+			Sample.NumSaturated++;
+		}
+	}
+
+	// Walking every connection's actor map is the expensive part, so only every SamplePeriod frames
+	if (FShooterRepGraphMetrics::ShouldSampleConnections(Frame))
+	{
+		Sample.ActorsReplicated = 0;
+		Sample.StarvedActors = 0;
+		Sample.OpenChannels = 0;
+
+		const uint32 StarvationFrames = FShooterRepGraphMetrics::GetStarvationFrames();
+		TMap<UClass*, TPair<int32, int32>> ClassCounts;
+
+		for (UNetReplicationGraphConnection* ConnManager : Connections)
+		{
+			for (auto MapIt = ConnManager->ActorInfoMap.CreateIterator(); MapIt; ++MapIt)
+			{
+				const FConnectionReplicationActorInfo& ConnectionInfo = *MapIt.Value().Get();
+				if (ConnectionInfo.Channel == nullptr || ConnectionInfo.bDormantOnConnection)
+				{
+					continue;
+				}
+
+				const bool bReplicated = ConnectionInfo.LastRepFrameNum == Frame;
+				const bool bStarved = !bReplicated && Frame - ConnectionInfo.LastRepFrameNum > StarvationFrames;
+
+				Sample.OpenChannels++;
+				Sample.ActorsReplicated += bReplicated ? 1 : 0;
+				Sample.StarvedActors += bStarved ? 1 : 0;
+
+				if (bReplicated || bStarved)
+				{
+					TPair<int32, int32>& Counts = ClassCounts.FindOrAdd(GetParentNativeClass(MapIt.Key()->GetClass()), TPair<int32, int32>(0, 0));
+					Counts.Key += bReplicated ? 1 : 0;
+					Counts.Value += bStarved ? 1 : 0;
+				}
+			}
+		}
+
+		for (const TPair<UClass*, TPair<int32, int32>>& Pair : ClassCounts)
+		{
+			Metrics.RecordClassReplication(Pair.Key->GetFName(), Pair.Value.Key, Pair.Value.Value);
+		}
+	}
+
+	if (GravityFieldNode)
+	{
+		Sample.GravityFieldActors = GravityFieldNode->GetNumActors();
+		Sample.GravityFields = GravityFieldNode->GetNumFields();
+	}
+	if (GridNode3D)
+	{
+		Sample.Grid3DCells = GridNode3D->GetNumCells();
+	}
+	Sample.PlayerStates = PlayerStateNode ? PlayerStateNode->GetNumPlayerStates() : 0;
+
+	Metrics.RecordFrame(Sample);
+}
+
+void UShooterReplicationGraph::UnseatDriver(AActor* Driver, AActor* Vehicle)
+{
+	if (Vehicle)
+	{
+		GlobalActorReplicationInfoMap.RemoveDependentActor(Vehicle, Driver);
+	}
+	RouteAddNetworkActorToNodes(FNewReplicatedActorInfo(Driver), GlobalActorReplicationInfoMap.Get(Driver));
+}
+
+bool UShooterReplicationGraph::IsReplayConnection(const UNetConnection* NetConnection)
+{
+	return NetConnection && NetConnection->IsA<UDemoNetConnection>();
+}
+
+bool UShooterReplicationGraph::IsSpatializedActor(AActor* Actor)
+{
+	return IsSpatialized(GetMappingPolicy(Actor->GetClass())) && !SeatedDrivers.Contains(Actor);
+}
+
+bool UShooterReplicationGraph::ShouldRouteToGravityFieldNode(const FNewReplicatedActorInfo& ActorInfo) const
+{
+	// The gravity node has no per level lists, streaming level actors stay on the grid
+	if (GravityFieldNode == nullptr || ActorInfo.StreamingLevelName != NAME_None)
+	{
+		return false;
+	}
+
+	return ActorInfo.Actor->IsA<ACircuitCharacter>() || ActorInfo.Actor->FindComponentByClass<UCustomGravityComponent>() != nullptr;
+}
+
+// Since we listen to global (static) events, we need to watch out for cross world broadcasts (PIE)
+#if WITH_EDITOR
+#define CHECK_WORLDS(X) if(X->GetWorld() != GetWorld()) return;
+#else
+#define CHECK_WORLDS(X)
+#endif
+
+void UShooterReplicationGraph::OnCharacterEquipWeapon(AShooterCharacter* Character, AShooterWeapon* NewWeapon)
+{
+	if (Character && NewWeapon)
+	{
+		CHECK_WORLDS(Character);
+
+		GlobalActorReplicationInfoMap.AddDependentActor(Character, NewWeapon);
+	}
+}
+
+void UShooterReplicationGraph::OnCharacterUnEquipWeapon(AShooterCharacter* Character, AShooterWeapon* OldWeapon)
+{
+	if (Character && OldWeapon)
 	{
 		CHECK_WORLDS(Character);
 
-		GlobalActorReplicationInfoMap.AddDependentActor(Character, NewWeapon);
+		GlobalActorReplicationInfoMap.RemoveDependentActor(Character, OldWeapon);
+	}
+}
+
+void UShooterReplicationGraph::OnVehicleDriverEnter(ACircuitWheeledVehiclePawn* Vehicle, ACircuitCharacter* Driver)
+{
+	if (Vehicle && Driver && !SeatedDrivers.Contains(Driver))
+	{
+		CHECK_WORLDS(Vehicle);
+
+		// Hidden and attached to the seat. The attachment goes out with the driver's own replication whenever the vehicle replicates.
+		RouteRemoveNetworkActorToNodes(FNewReplicatedActorInfo(Driver));
+		SeatedDrivers.Add(Driver, Vehicle);
+		GlobalActorReplicationInfoMap.AddDependentActor(Vehicle, Driver);
+	}
+}
+
+void UShooterReplicationGraph::OnVehicleDriverExit(ACircuitWheeledVehiclePawn* Vehicle, ACircuitCharacter* Driver)
+{
+	if (Vehicle && Driver)
+	{
+		CHECK_WORLDS(Vehicle);
+
+		TWeakObjectPtr<AActor> SeatedVehicle;
+		if (SeatedDrivers.RemoveAndCopyValue(Driver, SeatedVehicle))
+		{
+			UnseatDriver(Driver, SeatedVehicle.Get());
+		}
+	}
+}
+
+#if WITH_GAMEPLAY_DEBUGGER
+void UShooterReplicationGraph::OnGameplayDebuggerOwnerChange(AGameplayDebuggerCategoryReplicator* Debugger, APlayerController* OldOwner)
+{
+	auto GetAlwaysRelevantForConnectionNode = [&](APlayerController* Controller) -> UShooterReplicationGraphNode_AlwaysRelevant_ForConnection*
+	{
+		if (OldOwner)
+		{
+			if (UNetConnection* NetConnection = OldOwner->GetNetConnection())
+			{
+				if (UNetReplicationGraphConnection* GraphConnection = FindOrAddConnectionManager(NetConnection))
+				{
+					for (UReplicationGraphNode* ConnectionNode : GraphConnection->GetConnectionGraphNodes())
+					{
+						if (UShooterReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = Cast<UShooterReplicationGraphNode_AlwaysRelevant_ForConnection>(ConnectionNode))
+						{
+							return AlwaysRelevantConnectionNode;
+						}
+					}
+
+				}
+			}
+		}
+
+		return nullptr;
+	};
+
+	if (UShooterReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = GetAlwaysRelevantForConnectionNode(OldOwner))
+	{
+		AlwaysRelevantConnectionNode->GameplayDebugger = nullptr;
+	}
+
+	if (UShooterReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = GetAlwaysRelevantForConnectionNode(Debugger->GetReplicationOwner()))
+	{
+		AlwaysRelevantConnectionNode->GameplayDebugger = Debugger;
+	}
+}
+#endif
+
+// ------------------------------------------------------------------------------
+
+void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::ResetGameWorldState()
+{
+	AlwaysRelevantStreamingLevelsNeedingReplication.Empty();
+}
+
+void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_AlwaysRelevant_ForConnection_GatherActorListsForConnection );
+
+	UShooterReplicationGraph* ShooterGraph = CastChecked<UShooterReplicationGraph>(GetOuter());
+
+	ReplicationActorList.Reset();
+
+	auto ResetActorCullDistance = [&](AActor* ActorToSet, AActor*& LastActor) {
+
+		if (ActorToSet != LastActor)
+		{
+			LastActor = ActorToSet;
+
+			UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("Setting pawn cull distance to 0. %s"), *ActorToSet->GetName());
+			FConnectionReplicationActorInfo& ConnectionActorInfo = Params.ConnectionManager.ActorInfoMap.FindOrAdd(ActorToSet);
+			ConnectionActorInfo.SetCullDistanceSquared(0.f);
+		}
+	};
+
+	for (const FNetViewer& CurViewer : Params.Viewers)
+	{
+		ReplicationActorList.ConditionalAdd(CurViewer.InViewer);
+		ReplicationActorList.ConditionalAdd(CurViewer.ViewTarget);
+
+		if (AShooterPlayerController* PC = Cast<AShooterPlayerController>(CurViewer.InViewer))
+		{
+			// 50% throttling of PlayerStates.
+			const bool bReplicatePS = (Params.ConnectionManager.ConnectionOrderNum % 2) == (Params.ReplicationFrameNum % 2);
+			if (bReplicatePS)
+			{
+				// Always return the player state to the owning player. Simulated proxy player states are handled by UShooterReplicationGraphNode_PlayerStateFrequencyLimiter
+				if (APlayerState* PS = PC->PlayerState)
+				{
+					if (!bInitializedPlayerState)
+					{
+						bInitializedPlayerState = true;
+						FConnectionReplicationActorInfo& ConnectionActorInfo = Params.ConnectionManager.ActorInfoMap.FindOrAdd(PS);
+						ConnectionActorInfo.ReplicationPeriodFrame = 1;
+					}
+
+					ReplicationActorList.ConditionalAdd(PS);
+				}
+			}
+
+			FAlwaysRelevantActorInfo* LastData = PastRelevantActors.FindByKey<UNetConnection*>(CurViewer.Connection);
+
+			// We've not seen this actor before, go ahead and add them.
+			if (LastData == nullptr)
+			{
+				FAlwaysRelevantActorInfo NewActorInfo;
+				NewActorInfo.Connection = CurViewer.Connection;
+				LastData = &(PastRelevantActors[PastRelevantActors.Add(NewActorInfo)]);
+			}
+
+			check(LastData != nullptr);
+
+			if (AShooterCharacter* Pawn = Cast<AShooterCharacter>(PC->GetPawn()))
+			{
+				ResetActorCullDistance(Pawn, static_cast<AActor*&>(LastData->LastViewer));
+
+				if (Pawn != CurViewer.ViewTarget)
+				{
+					ReplicationActorList.ConditionalAdd(Pawn);
+				}
+
+				int32 InventoryCount = Pawn->GetInventoryCount();
+				for (int32 i = 0; i < InventoryCount; ++i)
+				{
+					AShooterWeapon* Weapon = Pawn->GetInventoryWeapon(i);
+					if (Weapon)
+					{
+						ReplicationActorList.ConditionalAdd(Weapon);
+					}
+				}
+			}
+
+			if (AShooterCharacter* ViewTargetPawn = Cast<AShooterCharacter>(CurViewer.ViewTarget))
+			{
+				ResetActorCullDistance(ViewTargetPawn, static_cast<AActor*&>(LastData->LastViewTarget));
+			}
+		}
+	}
+
+	PastRelevantActors.RemoveAll([&](FAlwaysRelevantActorInfo& RelActorInfo) {
+		return RelActorInfo.Connection == nullptr;
+	});
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+
+	// Always relevant streaming level actors.
+	FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
+	
+	TMap<FName, FActorRepListRefView>& AlwaysRelevantStreamingLevelActors = ShooterGraph->AlwaysRelevantStreamingLevelActors;
+
+	for (int32 Idx=AlwaysRelevantStreamingLevelsNeedingReplication.Num()-1; Idx >= 0; --Idx)
+	{
+		const FName& StreamingLevel = AlwaysRelevantStreamingLevelsNeedingReplication[Idx];
+
+		FActorRepListRefView* Ptr = AlwaysRelevantStreamingLevelActors.Find(StreamingLevel);
+		if (Ptr == nullptr)
+		{
+			// No always relevant lists for that level
+			UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING Removing %s from AlwaysRelevantStreamingLevelActors because FActorRepListRefView is null. %s "), *StreamingLevel.ToString(),  *Params.ConnectionManager.GetName());
+			AlwaysRelevantStreamingLevelsNeedingReplication.RemoveAtSwap(Idx, 1, false);
+			continue;
+		}
+
+		FActorRepListRefView& RepList = *Ptr;
+
+		if (RepList.Num() > 0)
+		{
+			bool bAllDormant = true;
+			for (FActorRepListType Actor : RepList)
+			{
+				FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
+				if (ConnectionActorInfo.bDormantOnConnection == false)
+				{
+					bAllDormant = false;
+					break;
+				}
+			}
+
+			if (bAllDormant)
+			{
+				UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING All AlwaysRelevant Actors Dormant on StreamingLevel %s for %s. Removing list."), *StreamingLevel.ToString(), *Params.ConnectionManager.GetName());
+				AlwaysRelevantStreamingLevelsNeedingReplication.RemoveAtSwap(Idx, 1, false);
+			}
+			else
+			{
+				UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING Adding always Actors on StreamingLevel %s for %s because it has at least one non dormant actor"), *StreamingLevel.ToString(), *Params.ConnectionManager.GetName());
+				Params.OutGatheredReplicationLists.AddReplicationActorList(RepList);
+			}
+		}
+		else
+		{
+			UE_LOG(LogShooterReplicationGraph, Warning, TEXT("UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection - empty RepList %s"), *Params.ConnectionManager.GetName());
+		}
+
+	}
+
+#if WITH_GAMEPLAY_DEBUGGER
+	if (GameplayDebugger)
+	{
+		ReplicationActorList.ConditionalAdd(GameplayDebugger);
 	}
+#endif
 }
 
-void UShooterReplicationGraph::OnCharacterUnEquipWeapon(AShooterCharacter* Character, AShooterWeapon* OldWeapon)
+void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityAdd(FName LevelName, UWorld* StreamingWorld)
 {
-	if (Character && OldWeapon)
+	UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING ::OnClientLevelVisibilityAdd - %s"), *LevelName.ToString());
+	AlwaysRelevantStreamingLevelsNeedingReplication.Add(LevelName);
+}
+
+void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityRemove(FName LevelName)
+{
+	UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING ::OnClientLevelVisibilityRemove - %s"), *LevelName.ToString());
+	AlwaysRelevantStreamingLevelsNeedingReplication.Remove(LevelName);
+}
+
+void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+{
+	DebugInfo.Log(NodeName);
+	DebugInfo.PushIndent();
+	LogActorRepList(DebugInfo, NodeName, ReplicationActorList);
+
+	for (const FName& LevelName : AlwaysRelevantStreamingLevelsNeedingReplication)
 	{
-		CHECK_WORLDS(Character);
+		UShooterReplicationGraph* ShooterGraph = CastChecked<UShooterReplicationGraph>(GetOuter());
+		if (FActorRepListRefView* RepList = ShooterGraph->AlwaysRelevantStreamingLevelActors.Find(LevelName))
+		{
+			LogActorRepList(DebugInfo, FString::Printf(TEXT("AlwaysRelevant StreamingLevel List: %s"), *LevelName.ToString()), *RepList);
+		}
+	}
 
-		GlobalActorReplicationInfoMap.RemoveDependentActor(Character, OldWeapon);
+	DebugInfo.PopIndent();
+}
+
+// ------------------------------------------------------------------------------
+
+UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::UShooterReplicationGraphNode_PlayerStateFrequencyLimiter()
+{
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	APlayerState* PS = Cast<APlayerState>(ActorInfo.Actor);
+	if (PS == nullptr || PlayerStates.ContainsByPredicate([PS](const FTrackedPlayerState& Tracked) { return Tracked.PlayerState == PS; }))
+	{
+		return;
 	}
+
+	FTrackedPlayerState& Tracked = PlayerStates.AddDefaulted_GetRef();
+	Tracked.PlayerState = PS;
+	Tracked.ChangeHash = GetPlayerStateChangeHash(PS);
+
+	bBucketsDirty = true;
 }
 
-#if WITH_GAMEPLAY_DEBUGGER
-void UShooterReplicationGraph::OnGameplayDebuggerOwnerChange(AGameplayDebuggerCategoryReplicator* Debugger, APlayerController* OldOwner)
+bool UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
 {
-	auto GetAlwaysRelevantForConnectionNode = [&](APlayerController* Controller) -> UShooterReplicationGraphNode_AlwaysRelevant_ForConnection*
+	const int32 Idx = PlayerStates.IndexOfByPredicate([&ActorInfo](const FTrackedPlayerState& Tracked) { return Tracked.PlayerState == ActorInfo.Actor; });
+	if (Idx == INDEX_NONE)
 	{
-		if (OldOwner)
+		UE_CLOG(bWarnIfNotFound, LogShooterReplicationGraph, Warning, TEXT("UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::NotifyRemoveNetworkActor - %s not found"), *GetActorRepListTypeDebugString(ActorInfo.Actor));
+		return false;
+	}
+
+	// Keeps the list compact. Buckets are rebuilt before the next gather so nothing points at the removed actor.
+	PlayerStates.RemoveAtSwap(Idx, 1, false);
+	bBucketsDirty = true;
+	return true;
+}
+
+void UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::NotifyResetAllNetworkActors()
+{
+	PlayerStates.Reset();
+	bBucketsDirty = true;
+}
+
+uint32 UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::GetPlayerStateChangeHash(const APlayerState* PS)
+{
+	uint32 Hash = GetTypeHash(PS->GetScore());
+	if (const AShooterPlayerState* ShooterPS = Cast<AShooterPlayerState>(PS))
+	{
+		Hash = HashCombine(Hash, GetTypeHash(ShooterPS->GetKills()));
+		Hash = HashCombine(Hash, GetTypeHash(ShooterPS->GetDeaths()));
+		Hash = HashCombine(Hash, GetTypeHash(ShooterPS->GetTeamNum()));
+	}
+	return Hash;
+}
+
+void UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::RebuildBuckets()
+{
+	ReplicationActorLists.Reset();
+
+	ReplicationActorLists.AddDefaulted();
+	FActorRepListRefView* CurrentList = &ReplicationActorLists[0];
+	CurrentList->PrepareForWrite();
+
+	for (const FTrackedPlayerState& Tracked : PlayerStates)
+	{
+		if (CurrentList->Num() >= TargetActorsPerFrame)
 		{
-			if (UNetConnection* NetConnection = OldOwner->GetNetConnection())
+			ReplicationActorLists.AddDefaulted();
+			CurrentList = &ReplicationActorLists.Last(); 
+			CurrentList->PrepareForWrite();
+		}
+		
+		CurrentList->Add(Tracked.PlayerState);
+	}
+
+	bBucketsDirty = false;
+}
+
+void UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::PrepareForReplication()
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_PlayerStateFrequencyLimiter_GlobalPrepareForReplication );
+
+	// Scale the rotation with the server population so each player state comes around at a steady rate, until the caps kick in.
+	// Worked out every frame so changes to the cvars apply straight away.
+	const int32 NumConnections = CastChecked<UShooterReplicationGraph>(GetOuter())->GetNumConnections();
+	const int32 CycleFrames = FMath::Max(CVar_ShooterRepGraph_PlayerStateCycleFrames, 1);
+	const int32 MinPerFrame = FMath::Max(CVar_ShooterRepGraph_PlayerStateMinPerFrame, 1);
+	int32 NewTarget = FMath::Clamp(FMath::DivideAndRoundUp(NumConnections, CycleFrames), MinPerFrame, FMath::Max(CVar_ShooterRepGraph_PlayerStateMaxPerFrame, MinPerFrame));
+	if (NumConnections > 0 && CVar_ShooterRepGraph_PlayerStateMaxTotalPerFrame > 0)
+	{
+		NewTarget = FMath::Min(NewTarget, FMath::Max(CVar_ShooterRepGraph_PlayerStateMaxTotalPerFrame / NumConnections, 1));
+	}
+
+	if (NewTarget != TargetActorsPerFrame)
+	{
+		TargetActorsPerFrame = NewTarget;
+		bBucketsDirty = true;
+	}
+
+	if (bBucketsDirty)
+	{
+		RebuildBuckets();
+	}
+
+	// Buckets live across frames, so player states that can't be gathered right now (pending kill, torn off) are dropped from this frame's copy
+	CurrentBucketList.Reset();
+	CurrentBucketList.PrepareForWrite();
+	if (ReplicationActorLists.Num() > 0)
+	{
+		const uint32 Frame = CastChecked<UShooterReplicationGraph>(GetOuter())->GetReplicationGraphFrame();
+		for (FActorRepListType Actor : ReplicationActorLists[Frame % ReplicationActorLists.Num()])
+		{
+			if (IsActorValidForReplicationGather(Actor))
 			{
-				if (UNetReplicationGraphConnection* GraphConnection = FindOrAddConnectionManager(NetConnection))
+				CurrentBucketList.Add(Actor);
+			}
+		}
+	}
+
+	// Changed player states jump the queue. Anything over the per frame budget stays pending for the next frame.
+	PriorityReplicationActorList.Reset();
+	PriorityReplicationActorList.PrepareForWrite();
+
+	int32 PriorityBudget = CVar_ShooterRepGraph_PlayerStateMaxPriorityPerFrame;
+	for (FTrackedPlayerState& Tracked : PlayerStates)
+	{
+		const uint32 NewHash = GetPlayerStateChangeHash(Tracked.PlayerState);
+		if (NewHash != Tracked.ChangeHash)
+		{
+			Tracked.ChangeHash = NewHash;
+			Tracked.bPendingPriority = true;
+		}
+
+		if (Tracked.bPendingPriority && PriorityBudget > 0 && IsActorValidForReplicationGather(Tracked.PlayerState))
+		{
+			PriorityReplicationActorList.Add(Tracked.PlayerState);
+			Tracked.bPendingPriority = false;
+			--PriorityBudget;
+		}
+	}
+}
+
+void UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	if (CurrentBucketList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(CurrentBucketList);
+	}
+
+	if (PriorityReplicationActorList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(PriorityReplicationActorList);
+	}
+
+	if (ForceNetUpdateReplicationActorList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(ForceNetUpdateReplicationActorList);
+	}	
+}
+
+void UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+{
+	DebugInfo.Log(NodeName);
+	DebugInfo.PushIndent();	
+
+	DebugInfo.Log(FString::Printf(TEXT("%d player states, %d per frame"), PlayerStates.Num(), TargetActorsPerFrame));
+
+	int32 i=0;
+	for (const FActorRepListRefView& List : ReplicationActorLists)
+	{
+		LogActorRepList(DebugInfo, FString::Printf(TEXT("Bucket[%d]"), i++), List);
+	}
+
+	LogActorRepList(DebugInfo, TEXT("Priority"), PriorityReplicationActorList);
+
+	DebugInfo.PopIndent();
+}
+
+// ------------------------------------------------------------------------------
+
+UShooterReplicationGraphNode_GridSpatialization3D::UShooterReplicationGraphNode_GridSpatialization3D()
+{
+	bRequiresPrepareForReplicationCall = true;
+}
+
+FIntVector UShooterReplicationGraphNode_GridSpatialization3D::GetCellForLocation(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize),
+		FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::AddActorToCell(const FNewReplicatedActorInfo& ActorInfo, const FIntVector& CellCoord)
+{
+	FCell& Cell = Cells.FindOrAdd(CellCoord);
+
+	FActorRepListRefView& RepList = (ActorInfo.StreamingLevelName == NAME_None) ? Cell.Actors : Cell.StreamingLevelActors.FindOrAdd(ActorInfo.StreamingLevelName);
+	RepList.PrepareForWrite();
+	RepList.Add(ActorInfo.Actor);
+}
+
+bool UShooterReplicationGraphNode_GridSpatialization3D::RemoveActorFromCell(const FNewReplicatedActorInfo& ActorInfo, const FIntVector& CellCoord)
+{
+	FCell* Cell = Cells.Find(CellCoord);
+	if (Cell == nullptr)
+	{
+		return false;
+	}
+
+	bool bRemoved = false;
+	if (ActorInfo.StreamingLevelName == NAME_None)
+	{
+		bRemoved = Cell->Actors.Remove(ActorInfo.Actor);
+	}
+	else if (FActorRepListRefView* RepList = Cell->StreamingLevelActors.Find(ActorInfo.StreamingLevelName))
+	{
+		bRemoved = RepList->Remove(ActorInfo.Actor);
+		if (RepList->Num() == 0)
+		{
+			Cell->StreamingLevelActors.Remove(ActorInfo.StreamingLevelName);
+		}
+	}
+
+	// Keep the hash sparse, empty space should cost nothing
+	if (Cell->Actors.Num() == 0 && Cell->StreamingLevelActors.Num() == 0)
+	{
+		Cells.Remove(CellCoord);
+	}
+
+	return bRemoved;
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::AddTrackedActor(TMap<FActorRepListType, FTrackedActor>& Map, const FNewReplicatedActorInfo& ActorInfo, bool bDormancyDriven)
+{
+	if (Map.Contains(ActorInfo.Actor))
+	{
+		UE_LOG(LogShooterReplicationGraph, Warning, TEXT("UShooterReplicationGraphNode_GridSpatialization3D: %s was added twice"), *GetActorRepListTypeDebugString(ActorInfo.Actor));
+		return;
+	}
+
+	FTrackedActor& Tracked = Map.Add(ActorInfo.Actor);
+	Tracked.ActorInfo = ActorInfo;
+	Tracked.Cell = GetCellForLocation(ActorInfo.Actor->GetActorLocation());
+	Tracked.bDormancyDriven = bDormancyDriven;
+
+	AddActorToCell(ActorInfo, Tracked.Cell);
+}
+
+bool UShooterReplicationGraphNode_GridSpatialization3D::RemoveTrackedActor(TMap<FActorRepListType, FTrackedActor>& Map, const FNewReplicatedActorInfo& ActorInfo)
+{
+	FTrackedActor Tracked;
+	if (!Map.RemoveAndCopyValue(ActorInfo.Actor, Tracked))
+	{
+		return false;
+	}
+
+	return RemoveActorFromCell(Tracked.ActorInfo, Tracked.Cell);
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::AddActor_Static(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo)
+{
+	AddTrackedActor(StaticActors, ActorInfo, false);
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::AddActor_Dynamic(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo)
+{
+	AddTrackedActor(DynamicActors, ActorInfo, false);
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::AddActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo)
+{
+	AddTrackedActor(DynamicActors, ActorInfo, true);
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::RemoveActor_Static(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (!RemoveTrackedActor(StaticActors, ActorInfo))
+	{
+		UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("UShooterReplicationGraphNode_GridSpatialization3D::RemoveActor_Static - %s not found"), *GetActorRepListTypeDebugString(ActorInfo.Actor));
+	}
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::RemoveActor_Dynamic(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (!RemoveTrackedActor(DynamicActors, ActorInfo))
+	{
+		UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("UShooterReplicationGraphNode_GridSpatialization3D::RemoveActor_Dynamic - %s not found"), *GetActorRepListTypeDebugString(ActorInfo.Actor));
+	}
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::RemoveActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo)
+{
+	RemoveActor_Dynamic(ActorInfo);
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	// Callers should pick AddActor_Static/Dynamic/Dormancy, dynamic is the safe default
+	AddTrackedActor(DynamicActors, ActorInfo, false);
+}
+
+bool UShooterReplicationGraphNode_GridSpatialization3D::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	const bool bRemoved = RemoveTrackedActor(DynamicActors, ActorInfo) || RemoveTrackedActor(StaticActors, ActorInfo);
+	UE_CLOG(!bRemoved && bWarnIfNotFound, LogShooterReplicationGraph, Warning, TEXT("UShooterReplicationGraphNode_GridSpatialization3D::NotifyRemoveNetworkActor - %s not found"), *GetActorRepListTypeDebugString(ActorInfo.Actor));
+	return bRemoved;
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::NotifyResetAllNetworkActors()
+{
+	Cells.Reset();
+	StaticActors.Reset();
+	DynamicActors.Reset();
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::PrepareForReplication()
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_GridSpatialization3D_PrepareForReplication );
+
+	for (TPair<FActorRepListType, FTrackedActor>& Pair : DynamicActors)
+	{
+		FTrackedActor& Tracked = Pair.Value;
+		AActor* Actor = Pair.Key;
+
+		// Dormant actors don't move, and flushing dormancy will put them back on this path
+		if (Tracked.bDormancyDriven && Actor->NetDormancy > DORM_Awake)
+		{
+			continue;
+		}
+
+		const FIntVector NewCell = GetCellForLocation(Actor->GetActorLocation());
+		if (NewCell != Tracked.Cell)
+		{
+			RemoveActorFromCell(Tracked.ActorInfo, Tracked.Cell);
+			AddActorToCell(Tracked.ActorInfo, NewCell);
+			Tracked.Cell = NewCell;
+		}
+	}
+}
+
+void UShooterReplicationGraphNode_GridSpatialization3D::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_GridSpatialization3D_GatherActorListsForConnection );
+
+	// Split screen viewers can overlap, only add each cell once
+	TArray<FIntVector, TInlineAllocator<27>> GatheredCells;
+
+	for (const FNetViewer& CurViewer : Params.Viewers)
+	{
+		const FIntVector ViewerCell = GetCellForLocation(CurViewer.ViewLocation);
+
+		for (int32 X = -GatherRadius; X <= GatherRadius; ++X)
+		{
+			for (int32 Y = -GatherRadius; Y <= GatherRadius; ++Y)
+			{
+				for (int32 Z = -GatherRadius; Z <= GatherRadius; ++Z)
 				{
-					for (UReplicationGraphNode* ConnectionNode : GraphConnection->GetConnectionGraphNodes())
+					const FIntVector CellCoord = ViewerCell + FIntVector(X, Y, Z);
+					const FCell* Cell = Cells.Find(CellCoord);
+					if (Cell == nullptr || GatheredCells.Contains(CellCoord))
 					{
-						if (UShooterReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = Cast<UShooterReplicationGraphNode_AlwaysRelevant_ForConnection>(ConnectionNode))
+						continue;
+					}
+					GatheredCells.Add(CellCoord);
+
+					if (Cell->Actors.Num() > 0)
+					{
+						Params.OutGatheredReplicationLists.AddReplicationActorList(Cell->Actors);
+					}
+
+					for (const TPair<FName, FActorRepListRefView>& StreamingLevelList : Cell->StreamingLevelActors)
+					{
+						if (StreamingLevelList.Value.Num() > 0 && Params.CheckClientVisibilityForLevel(StreamingLevelList.Key))
 						{
-							return AlwaysRelevantConnectionNode;
+							Params.OutGatheredReplicationLists.AddReplicationActorList(StreamingLevelList.Value);
 						}
 					}
-
 				}
 			}
 		}
+	}
+}
 
-		return nullptr;
-	};
+void UShooterReplicationGraphNode_GridSpatialization3D::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+{
+	DebugInfo.Log(FString::Printf(TEXT("%s (%d cells, %d static, %d dynamic, CellSize %.0f)"), *NodeName, Cells.Num(), StaticActors.Num(), DynamicActors.Num(), CellSize));
+	DebugInfo.PushIndent();
 
-	if (UShooterReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = GetAlwaysRelevantForConnectionNode(OldOwner))
+	for (const TPair<FIntVector, FCell>& Pair : Cells)
 	{
-		AlwaysRelevantConnectionNode->GameplayDebugger = nullptr;
+		LogActorRepList(DebugInfo, FString::Printf(TEXT("Cell[%s]"), *Pair.Key.ToString()), Pair.Value.Actors);
+		for (const TPair<FName, FActorRepListRefView>& StreamingLevelList : Pair.Value.StreamingLevelActors)
+		{
+			LogActorRepList(DebugInfo, FString::Printf(TEXT("Cell[%s] %s"), *Pair.Key.ToString(), *StreamingLevelList.Key.ToString()), StreamingLevelList.Value);
+		}
 	}
 
-	if (UShooterReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = GetAlwaysRelevantForConnectionNode(Debugger->GetReplicationOwner()))
-	{
-		AlwaysRelevantConnectionNode->GameplayDebugger = Debugger;
-	}
+	DebugInfo.PopIndent();
 }
-#endif
 
 // ------------------------------------------------------------------------------
 
-void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::ResetGameWorldState()
+UShooterReplicationGraphNode_GravityField::UShooterReplicationGraphNode_GravityField()
 {
-	AlwaysRelevantStreamingLevelsNeedingReplication.Empty();
+	bRequiresPrepareForReplicationCall = true;
 }
 
-void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+UBaseGravityComponent* UShooterReplicationGraphNode_GravityField::GetDominantField(AActor* Actor, TWeakObjectPtr<UCustomGravityComponent>& CachedGravityComponent, bool& bSearchedForComponent)
 {
-	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_AlwaysRelevant_ForConnection_GatherActorListsForConnection );
-
-	UShooterReplicationGraph* ShooterGraph = CastChecked<UShooterReplicationGraph>(GetOuter());
-
-	ReplicationActorList.Reset();
+	UCustomGravityComponent* GravityComponent = CachedGravityComponent.Get();
+	if (GravityComponent == nullptr && !bSearchedForComponent)
+	{
+		ACircuitCharacter* Character = Cast<ACircuitCharacter>(Actor);
+		GravityComponent = (Character && Character->GravityComponent) ? Character->GravityComponent : Actor->FindComponentByClass<UCustomGravityComponent>();
+		CachedGravityComponent = GravityComponent;
+		bSearchedForComponent = true;
+	}
 
-	auto ResetActorCullDistance = [&](AActor* ActorToSet, AActor*& LastActor) {
+	// The first field entered wins, same as UCustomGravityComponent::CalculateGravity
+	return (GravityComponent && GravityComponent->GravityFieldArray.Num() > 0) ? GravityComponent->GravityFieldArray[0] : nullptr;
+}
 
-		if (ActorToSet != LastActor)
-		{
-			LastActor = ActorToSet;
+void UShooterReplicationGraphNode_GravityField::AddToFieldList(FActorRepListType Actor, UBaseGravityComponent* Field, EClassRepNodeMapping Policy)
+{
+	if (Field == nullptr)
+	{
+		// Actors outside every field are the grid's problem
+		CastChecked<UShooterReplicationGraph>(GetOuter())->AddActorToGrid(Actor, Policy);
+		return;
+	}
 
-			UE_LOG(LogShooterReplicationGraph, Verbose, TEXT("Setting pawn cull distance to 0. %s"), *ActorToSet->GetName());
-			FConnectionReplicationActorInfo& ConnectionActorInfo = Params.ConnectionManager.ActorInfoMap.FindOrAdd(ActorToSet);
-			ConnectionActorInfo.SetCullDistanceSquared(0.f);
-		}
-	};
+	FFieldList& FieldList = FieldLists.FindOrAdd(FObjectKey(Field));
+	if (!FieldList.Field.IsValid())
+	{
+		FieldList.Field = Field;
+		FieldList.Actors.Reset();
+		FieldList.Actors.PrepareForWrite();
+	}
+	FieldList.Actors.Add(Actor);
+}
 
-	for (const FNetViewer& CurViewer : Params.Viewers)
+void UShooterReplicationGraphNode_GravityField::RemoveFromFieldList(FActorRepListType Actor, const FObjectKey& FieldKey, EClassRepNodeMapping Policy)
+{
+	if (FieldKey == FObjectKey())
 	{
-		ReplicationActorList.ConditionalAdd(CurViewer.InViewer);
-		ReplicationActorList.ConditionalAdd(CurViewer.ViewTarget);
+		CastChecked<UShooterReplicationGraph>(GetOuter())->RemoveActorFromGrid(FNewReplicatedActorInfo(Actor), Policy);
+		return;
+	}
 
-		if (AShooterPlayerController* PC = Cast<AShooterPlayerController>(CurViewer.InViewer))
+	if (FFieldList* FieldList = FieldLists.Find(FieldKey))
+	{
+		FieldList->Actors.Remove(Actor);
+		if (FieldList->Actors.Num() == 0)
 		{
-			// 50% throttling of PlayerStates.
-			const bool bReplicatePS = (Params.ConnectionManager.ConnectionOrderNum % 2) == (Params.ReplicationFrameNum % 2);
-			if (bReplicatePS)
-			{
-				// Always return the player state to the owning player. Simulated proxy player states are handled by UShooterReplicationGraphNode_PlayerStateFrequencyLimiter
-				if (APlayerState* PS = PC->PlayerState)
-				{
-					if (!bInitializedPlayerState)
-					{
-						bInitializedPlayerState = true;
-						FConnectionReplicationActorInfo& ConnectionActorInfo = Params.ConnectionManager.ActorInfoMap.FindOrAdd(PS);
-						ConnectionActorInfo.ReplicationPeriodFrame = 1;
-					}
-
-					ReplicationActorList.ConditionalAdd(PS);
-				}
-			}
+			FieldLists.Remove(FieldKey);
+		}
+	}
+}
 
-			FAlwaysRelevantActorInfo* LastData = PastRelevantActors.FindByKey<UNetConnection*>(CurViewer.Connection);
+void UShooterReplicationGraphNode_GravityField::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	AddActor(ActorInfo, EClassRepNodeMapping::Spatialize_Dynamic);
+}
 
-			// We've not seen this actor before, go ahead and add them.
-			if (LastData == nullptr)
-			{
-				FAlwaysRelevantActorInfo NewActorInfo;
-				NewActorInfo.Connection = CurViewer.Connection;
-				LastData = &(PastRelevantActors[PastRelevantActors.Add(NewActorInfo)]);
-			}
+void UShooterReplicationGraphNode_GravityField::AddActor(const FNewReplicatedActorInfo& ActorInfo, EClassRepNodeMapping Policy)
+{
+	FTrackedActor& Tracked = TrackedActors.FindOrAdd(ActorInfo.Actor);
+	UBaseGravityComponent* Field = GetDominantField(ActorInfo.Actor, Tracked.GravityComponent, Tracked.bSearchedForComponent);
+	Tracked.Field = FObjectKey(Field);
+	Tracked.Policy = Policy;
+	AddToFieldList(ActorInfo.Actor, Field, Policy);
+}
 
-			check(LastData != nullptr);
+bool UShooterReplicationGraphNode_GravityField::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	FTrackedActor Tracked;
+	if (!TrackedActors.RemoveAndCopyValue(ActorInfo.Actor, Tracked))
+	{
+		UE_CLOG(bWarnIfNotFound, LogShooterReplicationGraph, Warning, TEXT("UShooterReplicationGraphNode_GravityField::NotifyRemoveNetworkActor - %s not found"), *GetActorRepListTypeDebugString(ActorInfo.Actor));
+		return false;
+	}
 
-			if (AShooterCharacter* Pawn = Cast<AShooterCharacter>(PC->GetPawn()))
-			{
-				ResetActorCullDistance(Pawn, static_cast<AActor*&>(LastData->LastViewer));
+	RemoveFromFieldList(ActorInfo.Actor, Tracked.Field, Tracked.Policy);
+	return true;
+}
 
-				if (Pawn != CurViewer.ViewTarget)
-				{
-					ReplicationActorList.ConditionalAdd(Pawn);
-				}
+void UShooterReplicationGraphNode_GravityField::NotifyResetAllNetworkActors()
+{
+	TrackedActors.Reset();
+	FieldLists.Reset();
+}
 
-				int32 InventoryCount = Pawn->GetInventoryCount();
-				for (int32 i = 0; i < InventoryCount; ++i)
-				{
-					AShooterWeapon* Weapon = Pawn->GetInventoryWeapon(i);
-					if (Weapon)
-					{
-						ReplicationActorList.ConditionalAdd(Weapon);
-					}
-				}
-			}
+void UShooterReplicationGraphNode_GravityField::PrepareForReplication()
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_GravityField_PrepareForReplication );
 
-			if (AShooterCharacter* ViewTargetPawn = Cast<AShooterCharacter>(CurViewer.ViewTarget))
-			{
-				ResetActorCullDistance(ViewTargetPawn, static_cast<AActor*&>(LastData->LastViewTarget));
-			}
+	// Field membership only changes on overlap events, so most frames this moves nothing
+	for (TPair<FActorRepListType, FTrackedActor>& Pair : TrackedActors)
+	{
+		FTrackedActor& Tracked = Pair.Value;
+		UBaseGravityComponent* Field = GetDominantField(Pair.Key, Tracked.GravityComponent, Tracked.bSearchedForComponent);
+		const FObjectKey FieldKey(Field);
+		if (FieldKey != Tracked.Field)
+		{
+			RemoveFromFieldList(Pair.Key, Tracked.Field, Tracked.Policy);
+			AddToFieldList(Pair.Key, Field, Tracked.Policy);
+			Tracked.Field = FieldKey;
 		}
 	}
+}
 
-	PastRelevantActors.RemoveAll([&](FAlwaysRelevantActorInfo& RelActorInfo) {
-		return RelActorInfo.Connection == nullptr;
-	});
+void UShooterReplicationGraphNode_GravityField::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_GravityField_GatherActorListsForConnection );
 
-	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+	if (FieldLists.Num() == 0)
+	{
+		return;
+	}
 
-	// Always relevant streaming level actors.
-	FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
-	
-	TMap<FName, FActorRepListRefView>& AlwaysRelevantStreamingLevelActors = ShooterGraph->AlwaysRelevantStreamingLevelActors;
+	// Fields the viewers of this connection are inside. Viewers in open space only pick up fields they are close to.
+	TArray<FObjectKey, TInlineAllocator<4>> ViewerFields;
 
-	for (int32 Idx=AlwaysRelevantStreamingLevelsNeedingReplication.Num()-1; Idx >= 0; --Idx)
+	for (const FNetViewer& CurViewer : Params.Viewers)
 	{
-		const FName& StreamingLevel = AlwaysRelevantStreamingLevelsNeedingReplication[Idx];
-
-		FActorRepListRefView* Ptr = AlwaysRelevantStreamingLevelActors.Find(StreamingLevel);
-		if (Ptr == nullptr)
+		AActor* ViewActor = CurViewer.ViewTarget ? CurViewer.ViewTarget : (CurViewer.InViewer ? CurViewer.InViewer->GetPawn() : nullptr);
+		if (ViewActor == nullptr)
 		{
-			// No always relevant lists for that level
-			UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING Removing %s from AlwaysRelevantStreamingLevelActors because FActorRepListRefView is null. %s "), *StreamingLevel.ToString(),  *Params.ConnectionManager.GetName());
-			AlwaysRelevantStreamingLevelsNeedingReplication.RemoveAtSwap(Idx, 1, false);
 			continue;
 		}
 
-		FActorRepListRefView& RepList = *Ptr;
-
-		if (RepList.Num() > 0)
+		// View targets are usually tracked here already, anything else (spectator pawns, cameras) is looked up
+		if (const FTrackedActor* Tracked = TrackedActors.Find(ViewActor))
 		{
-			bool bAllDormant = true;
-			for (FActorRepListType Actor : RepList)
+			if (Tracked->Field != FObjectKey())
 			{
-				FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
-				if (ConnectionActorInfo.bDormantOnConnection == false)
-				{
-					bAllDormant = false;
-					break;
-				}
+				ViewerFields.AddUnique(Tracked->Field);
+			}
+		}
+		else
+		{
+			TWeakObjectPtr<UCustomGravityComponent> GravityComponent;
+			bool bSearched = false;
+			if (UBaseGravityComponent* ViewerField = GetDominantField(ViewActor, GravityComponent, bSearched))
+			{
+				ViewerFields.AddUnique(FObjectKey(ViewerField));
 			}
+		}
+	}
 
-			if (bAllDormant)
+	const float CrossFieldDistanceSq = FMath::Square(CrossFieldDistance);
+
+	for (const TPair<FObjectKey, FFieldList>& Pair : FieldLists)
+	{
+		const FFieldList& FieldList = Pair.Value;
+		if (FieldList.Actors.Num() == 0)
+		{
+			continue;
+		}
+
+		bool bRelevant = ViewerFields.Contains(Pair.Key);
+		if (!bRelevant)
+		{
+			const UBaseGravityComponent* Field = FieldList.Field.Get();
+			if (Field == nullptr)
 			{
-				UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING All AlwaysRelevant Actors Dormant on StreamingLevel %s for %s. Removing list."), *StreamingLevel.ToString(), *Params.ConnectionManager.GetName());
-				AlwaysRelevantStreamingLevelsNeedingReplication.RemoveAtSwap(Idx, 1, false);
+				// Field went away mid frame, PrepareForReplication will rebucket these next frame
+				bRelevant = true;
 			}
 			else
 			{
-				UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING Adding always Actors on StreamingLevel %s for %s because it has at least one non dormant actor"), *StreamingLevel.ToString(), *Params.ConnectionManager.GetName());
-				Params.OutGatheredReplicationLists.AddReplicationActorList(RepList);
+				for (const FNetViewer& CurViewer : Params.Viewers)
+				{
+					if (Field->Bounds.ComputeSquaredDistanceFromBoxToPoint(CurViewer.ViewLocation) <= CrossFieldDistanceSq)
+					{
+						bRelevant = true;
+						break;
+					}
+				}
 			}
 		}
-		else
+
+		if (bRelevant)
 		{
-			UE_LOG(LogShooterReplicationGraph, Warning, TEXT("UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection - empty RepList %s"), *Params.ConnectionManager.GetName());
+			Params.OutGatheredReplicationLists.AddReplicationActorList(FieldList.Actors);
 		}
-
 	}
+}
 
-#if WITH_GAMEPLAY_DEBUGGER
-	if (GameplayDebugger)
+void UShooterReplicationGraphNode_GravityField::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+{
+	DebugInfo.Log(FString::Printf(TEXT("%s (%d actors, %d fields)"), *NodeName, TrackedActors.Num(), FieldLists.Num()));
+	DebugInfo.PushIndent();
+
+	for (const TPair<FObjectKey, FFieldList>& Pair : FieldLists)
 	{
-		ReplicationActorList.ConditionalAdd(GameplayDebugger);
+		const UBaseGravityComponent* Field = Pair.Value.Field.Get();
+		LogActorRepList(DebugInfo, Field ? FString::Printf(TEXT("%s.%s"), *GetNameSafe(Field->GetOwner()), *Field->GetName()) : FString(TEXT("<Destroyed Field>")), Pair.Value.Actors);
 	}
-#endif
+
+	DebugInfo.PopIndent();
 }
 
-void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityAdd(FName LevelName, UWorld* StreamingWorld)
+// ------------------------------------------------------------------------------
+
+bool UShooterReplicationGraphNode_Replay::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
 {
-	UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING ::OnClientLevelVisibilityAdd - %s"), *LevelName.ToString());
-	AlwaysRelevantStreamingLevelsNeedingReplication.Add(LevelName);
+	LastLocations.Remove(ActorInfo.Actor);
+	return ReplayActors.Remove(ActorInfo.Actor);
 }
 
-void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityRemove(FName LevelName)
+void UShooterReplicationGraphNode_Replay::NotifyResetAllNetworkActors()
 {
-	UE_CLOG(CVar_ShooterRepGraph_DisplayClientLevelStreaming > 0, LogShooterReplicationGraph, Display, TEXT("CLIENTSTREAMING ::OnClientLevelVisibilityRemove - %s"), *LevelName.ToString());
-	AlwaysRelevantStreamingLevelsNeedingReplication.Remove(LevelName);
+	ResetGameWorldState();
 }
 
-void UShooterReplicationGraphNode_AlwaysRelevant_ForConnection::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+void UShooterReplicationGraphNode_Replay::ResetGameWorldState()
 {
-	DebugInfo.Log(NodeName);
-	DebugInfo.PushIndent();
-	LogActorRepList(DebugInfo, NodeName, ReplicationActorList);
+	ReplayActors.Reset();
+	LastLocations.Reset();
+	NumFullRate = 0;
+	bNeedsRebuild = true;
+}
 
-	for (const FName& LevelName : AlwaysRelevantStreamingLevelsNeedingReplication)
+void UShooterReplicationGraphNode_Replay::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_Replay_GatherActorListsForConnection );
+
+	const uint32 RefreshFrames = (uint32)FMath::Max(CVar_ShooterRepGraph_ReplayRefreshFrames, 1);
+	if (bNeedsRebuild || Params.ReplicationFrameNum - LastRebuildFrame >= RefreshFrames)
 	{
-		UShooterReplicationGraph* ShooterGraph = CastChecked<UShooterReplicationGraph>(GetOuter());
-		if (FActorRepListRefView* RepList = ShooterGraph->AlwaysRelevantStreamingLevelActors.Find(LevelName))
-		{
-			LogActorRepList(DebugInfo, FString::Printf(TEXT("AlwaysRelevant StreamingLevel List: %s"), *LevelName.ToString()), *RepList);
-		}
+		RebuildActorList(Params.ConnectionManager);
+		LastRebuildFrame = Params.ReplicationFrameNum;
+		bNeedsRebuild = false;
 	}
 
-	DebugInfo.PopIndent();
+	if (ReplayActors.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(ReplayActors);
+	}
 }
 
-// ------------------------------------------------------------------------------
-
-UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::UShooterReplicationGraphNode_PlayerStateFrequencyLimiter()
+void UShooterReplicationGraphNode_Replay::RebuildActorList(UNetReplicationGraphConnection& ConnectionManager)
 {
-	bRequiresPrepareForReplicationCall = true;
-}
+	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_Replay_RebuildActorList );
 
-void UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::PrepareForReplication()
-{
-	QUICK_SCOPE_CYCLE_COUNTER( UShooterReplicationGraphNode_PlayerStateFrequencyLimiter_GlobalPrepareForReplication );
+	UShooterReplicationGraph* ShooterGraph = CastChecked<UShooterReplicationGraph>(GetOuter());
 
-	ReplicationActorLists.Reset();
-	ForceNetUpdateReplicationActorList.Reset();
+	// The players are who the recording will be watched through, the demo spectator itself has no pawn
+	TArray<FVector, TInlineAllocator<64>> PlayerLocations;
+	if (UWorld* World = GetWorld())
+	{
+		for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+		{
+			APlayerController* PC = It->Get();
+			if (PC && PC->GetPawn())
+			{
+				PlayerLocations.Add(PC->GetPawn()->GetActorLocation());
+			}
+		}
+	}
 
-	ReplicationActorLists.AddDefaulted();
-	FActorRepListRefView* CurrentList = &ReplicationActorLists[0];
-	CurrentList->PrepareForWrite();
+	const float FullRateRadiusSq = FMath::Square(CVar_ShooterRepGraph_ReplayFullRateRadius);
+	const float StaticDistanceSq = FMath::Square(CVar_ShooterRepGraph_ReplayStaticDistance);
+	const uint32 Divisor = (uint32)FMath::Max(CVar_ShooterRepGraph_ReplayReducedRateDivisor, 1);
 
-	// We rebuild our lists of player states each frame. This is not as efficient as it could be but its the simplest way
-	// to handle players disconnecting and keeping the lists compact. If the lists were persistent we would need to defrag them as players left.
+	TMap<FActorRepListType, FVector> NewLocations;
+	NewLocations.Reserve(LastLocations.Num());
 
-	for (TActorIterator<APlayerState> It(GetWorld()); It; ++It)
+	ReplayActors.Reset();
+	ReplayActors.PrepareForWrite();
+	NumFullRate = 0;
+
+	for (auto It = GraphGlobals->GlobalActorReplicationInfoMap->CreateActorMapIterator(); It; ++It)
 	{
-		APlayerState* PS = *It;
-		if (IsActorValidForReplicationGather(PS) == false)
+		AActor* Actor = It.Key();
+		if (!IsActorValidForReplicationGather(Actor) || !ShooterGraph->IsSpatializedActor(Actor))
 		{
 			continue;
 		}
 
-		if (CurrentList->Num() >= TargetActorsPerFrame)
+		const FVector Location = Actor->GetActorLocation();
+		const FVector* LastLocation = LastLocations.Find(Actor);
+		const bool bMoved = LastLocation == nullptr || FVector::DistSquared(*LastLocation, Location) > StaticDistanceSq;
+		NewLocations.Add(Actor, Location);
+
+		const APawn* Pawn = Cast<APawn>(Actor);
+		bool bFullRate = Pawn && Pawn->IsPlayerControlled();
+		if (!bFullRate && bMoved)
 		{
-			ReplicationActorLists.AddDefaulted();
-			CurrentList = &ReplicationActorLists.Last(); 
-			CurrentList->PrepareForWrite();
+			for (const FVector& PlayerLocation : PlayerLocations)
+			{
+				if (FVector::DistSquared(PlayerLocation, Location) <= FullRateRadiusSq)
+				{
+					bFullRate = true;
+					break;
+				}
+			}
 		}
-		
-		CurrentList->Add(PS);
-	}	
-}
 
-void UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
-{
-	const int32 ListIdx = Params.ReplicationFrameNum % ReplicationActorLists.Num();
-	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorLists[ListIdx]);
-
-	if (ForceNetUpdateReplicationActorList.Num() > 0)
-	{
-		Params.OutGatheredReplicationLists.AddReplicationActorList(ForceNetUpdateReplicationActorList);
-	}	
-}
+		ReplayActors.Add(Actor);
+		NumFullRate += bFullRate ? 1 : 0;
 
-void UShooterReplicationGraphNode_PlayerStateFrequencyLimiter::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
-{
-	DebugInfo.Log(NodeName);
-	DebugInfo.PushIndent();	
+		FConnectionReplicationActorInfo& ConnectionInfo = ConnectionManager.ActorInfoMap.FindOrAdd(Actor);
+		const uint32 BasePeriod = It.Value()->Settings.ReplicationPeriodFrame;
+		ConnectionInfo.ReplicationPeriodFrame = bFullRate ? BasePeriod : FMath::Clamp<uint32>(BasePeriod * Divisor, BasePeriod, FMath::Max<uint32>(255, BasePeriod));
 
-	int32 i=0;
-	for (const FActorRepListRefView& List : ReplicationActorLists)
-	{
-		LogActorRepList(DebugInfo, FString::Printf(TEXT("Bucket[%d]"), i++), List);
+		// Whoever watches the recording can fly anywhere, so nothing is culled around the demo spectator
+		ConnectionInfo.SetCullDistanceSquared(0.f);
 	}
 
+	LastLocations = MoveTemp(NewLocations);
+}
+
+void UShooterReplicationGraphNode_Replay::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+{
+	DebugInfo.Log(FString::Printf(TEXT("%s (%d full rate, %d reduced rate)"), *NodeName, GetNumFullRate(), GetNumReducedRate()));
+	DebugInfo.PushIndent();
+	LogActorRepList(DebugInfo, TEXT("Recorded"), ReplayActors);
 	DebugInfo.PopIndent();
 }
 
@@ -4,12 +4,22 @@
 
 #include "CoreMinimal.h"
 #include "ReplicationGraph.h"
+#include "ShooterReplicationGraphMetrics.h"
 #include "ShooterReplicationGraph.generated.h"
 
 class AShooterCharacter;
 class AShooterWeapon;
 class UReplicationGraphNode_GridSpatialization2D;
+class UShooterReplicationGraphNode_GridSpatialization3D;
+class UShooterReplicationGraphNode_PlayerStateFrequencyLimiter;
+class UShooterReplicationGraphNode_GravityField;
+class UShooterReplicationGraphNode_Replay;
+class UCustomGravityComponent;
+class UBaseGravityComponent;
+class ACircuitWheeledVehiclePawn;
+class ACircuitCharacter;
 class AGameplayDebuggerCategoryReplicator;
+class FShooterRepGraphClassCache;
 
 DECLARE_LOG_CATEGORY_EXTERN( LogShooterReplicationGraph, Display, All );
 
@@ -17,8 +27,9 @@ DECLARE_LOG_CATEGORY_EXTERN( LogShooterReplicationGraph, Display, All );
 UENUM()
 enum class EClassRepNodeMapping : uint32
 {
-	NotRouted,						// Doesn't map to any node. Used for special case actors that handled by special case nodes (UShooterReplicationGraphNode_PlayerStateFrequencyLimiter)
+	NotRouted,						// Doesn't map to any node. Used for special case actors that handled by special case nodes
 	RelevantAllConnections,			// Routes to an AlwaysRelevantNode or AlwaysRelevantStreamingLevelNode node
+	FrequencyLimited_PlayerState,	// Routes to PlayerStateNode (UShooterReplicationGraphNode_PlayerStateFrequencyLimiter)
 	
 	// ONLY SPATIALIZED Enums below here! See UShooterReplicationGraph::IsSpatialized
 
@@ -44,6 +55,10 @@ public:
 	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
 	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
 	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	virtual void BeginDestroy() override;
 	
 	UPROPERTY()
 	TArray<UClass*>	SpatializedClasses;
@@ -57,26 +72,117 @@ public:
 	UPROPERTY()
 	UReplicationGraphNode_GridSpatialization2D* GridNode;
 
+	/** Used instead of GridNode when ShooterRepGraph.Use3DSpatialization is set (planet maps). Only one of the two is created. */
+	UPROPERTY()
+	UShooterReplicationGraphNode_GridSpatialization3D* GridNode3D;
+
 	UPROPERTY()
 	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
 
+	UPROPERTY()
+	UShooterReplicationGraphNode_PlayerStateFrequencyLimiter* PlayerStateNode;
+
+	/** Takes spatialized actors that are inside a gravity field away from the grid when ShooterRepGraph.UseGravityFieldNode is set */
+	UPROPERTY()
+	UShooterReplicationGraphNode_GravityField* GravityFieldNode;
+
 	TMap<FName, FActorRepListRefView> AlwaysRelevantStreamingLevelActors;
 
 	void OnCharacterEquipWeapon(AShooterCharacter* Character, AShooterWeapon* NewWeapon);
 	void OnCharacterUnEquipWeapon(AShooterCharacter* Character, AShooterWeapon* OldWeapon);
 
+	void OnVehicleDriverEnter(ACircuitWheeledVehiclePawn* Vehicle, ACircuitCharacter* Driver);
+	void OnVehicleDriverExit(ACircuitWheeledVehiclePawn* Vehicle, ACircuitCharacter* Driver);
+
 #if WITH_GAMEPLAY_DEBUGGER
 	void OnGameplayDebuggerOwnerChange(AGameplayDebuggerCategoryReplicator* Debugger, APlayerController* OldOwner);
 #endif
 
 	void PrintRepNodePolicies();
 
+	int32 GetNumConnections() const { return Connections.Num(); }
+
+	/** How far the adaptive controller has backed off a connection, 0 = full rate. See ShooterRepGraph.Adaptive.* */
+	int32 GetAdaptiveLevel(const UNetConnection* NetConnection) const;
+
+	/** Demo recording connections get UShooterReplicationGraphNode_Replay instead of replicating like a client */
+	static bool IsReplayConnection(const UNetConnection* NetConnection);
+
+	/** True for actors that would be in one of the spatial nodes (seated drivers are not, they ride with their vehicle) */
+	bool IsSpatializedActor(AActor* Actor);
+
+	/** Adds to or removes from GridNode or GridNode3D, whichever this graph made. Policy must be one of the Spatialize_ mappings. */
+	void AddActorToGrid(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo, EClassRepNodeMapping Policy);
+	void AddActorToGrid(AActor* Actor, EClassRepNodeMapping Policy);
+	void RemoveActorFromGrid(const FNewReplicatedActorInfo& ActorInfo, EClassRepNodeMapping Policy);
+
+	/** Works out ClassRepNodePolicies and the per class replication settings from every loaded replicated class */
+	void BuildClassSettings(float ServerMaxTickRate);
+
+	/** Copies what BuildClassSettings produced into a cache, see UShooterRepGraphClassCacheCommandlet */
+	void ExportClassSettings(FShooterRepGraphClassCache& OutCache, float ServerMaxTickRate);
+
+	/** Uses a cache instead of BuildClassSettings. Returns false without changing anything if the cache doesn't match this build or its classes */
+	bool ApplyClassSettings(const FShooterRepGraphClassCache& Cache);
+
+	/** Every loaded replicated actor class, skipping SKEL_ and REINST_ classes */
+	static void GetReplicatedClasses(TArray<UClass*>& OutClasses);
+
+	/** Hash of the inputs to BuildClassSettings that don't live on class defaults */
+	static uint32 GetClassSettingsInputsHash(float ServerMaxTickRate);
+
 private:
 
 	EClassRepNodeMapping GetMappingPolicy(UClass* Class);
 
 	bool IsSpatialized(EClassRepNodeMapping Mapping) const { return Mapping >= EClassRepNodeMapping::Spatialize_Static; }
 
+	bool ShouldRouteToGravityFieldNode(const FNewReplicatedActorInfo& ActorInfo) const;
+
+	/** Puts a driver back into the spatial nodes and drops it as a dependent of its vehicle, if the vehicle is still around */
+	void UnseatDriver(AActor* Driver, AActor* Vehicle);
+
+	/** Drivers taken out of the spatial nodes while seated, mapped to the vehicle they replicate with. Weak, either side can be destroyed without an exit. */
+	TMap<TWeakObjectPtr<AActor>, TWeakObjectPtr<AActor>> SeatedDrivers;
+
+	void RecordMetrics(double ReplicateSeconds);
+
+	/** Per connection settings the adaptive controller replaced, so it can put back exactly what was there */
+	struct FAdaptiveOverride
+	{
+		uint32 OriginalPeriodFrame = 0;
+		float OriginalCullDistanceSquared = 0.f;
+		uint32 AppliedPeriodFrame = 0;
+		float AppliedCullDistanceSquared = 0.f;
+	};
+
+	/** Per connection state for the adaptive bandwidth controller */
+	struct FConnectionBudget
+	{
+		/** Smoothed 0..1, 1 = saturated every frame */
+		float Saturation = 0.f;
+		int32 Level = 0;
+
+		/** Only the actors backed off by ApplyAdaptiveLevel, restored when the level drops back to 0 */
+		TMap<TWeakObjectPtr<AActor>, FAdaptiveOverride> Overrides;
+	};
+
+	void UpdateAdaptiveBudgets();
+
+	/**
+	 * Scales each actor's per connection update period and cull distance for Budget.Level, starting from whatever they were before the first
+	 * back off. At level 0 only the entries it changed are restored, and only if nothing else has changed them since.
+	 */
+	void ApplyAdaptiveLevel(UNetReplicationGraphConnection* ConnManager, FConnectionBudget& Budget);
+
+	TMap<UNetReplicationGraphConnection*, FConnectionBudget> ConnectionBudgets;
+
+	/** One per demo recording connection, told about removed actors. Entries go stale when their connection closes */
+	TArray<TWeakObjectPtr<UShooterReplicationGraphNode_Replay>> ReplayNodes;
+
+	/** See ShooterRepGraph.Metrics */
+	FShooterRepGraphMetrics Metrics;
+
 	TClassMap<EClassRepNodeMapping> ClassRepNodePolicies;
 };
 
@@ -120,7 +226,11 @@ private:
 	bool bInitializedPlayerState = false;
 };
 
-/** This is a specialized node for handling PlayerState replication in a frequency limited fashion. It tracks all player states but only returns a subset of them to the replication driver each frame. */
+/**
+ * This is a specialized node for handling PlayerState replication in a frequency limited fashion. It tracks all player states but only returns a subset of them to the replication driver each frame.
+ * The player state list is persistent (maintained by add/remove notifications) and the rolling buckets are only rebuilt when players join/leave or the bucket size changes.
+ * Player states whose score/kills/deaths changed are returned to everyone on the next frame, ahead of their turn in the rotation.
+ */
 UCLASS()
 class UShooterReplicationGraphNode_PlayerStateFrequencyLimiter : public UReplicationGraphNode
 {
@@ -128,8 +238,9 @@ class UShooterReplicationGraphNode_PlayerStateFrequencyLimiter : public UReplica
 
 	UShooterReplicationGraphNode_PlayerStateFrequencyLimiter();
 
-	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& Actor) override { }
-	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound=true) override { return false; }
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& Actor) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound=true) override;
+	virtual void NotifyResetAllNetworkActors() override;
 
 	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
 
@@ -137,11 +248,215 @@ class UShooterReplicationGraphNode_PlayerStateFrequencyLimiter : public UReplica
 
 	virtual void LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const override;
 
-	/** How many actors we want to return to the replication driver per frame. Will not suppress ForceNetUpdate. */
+	/** How many actors we want to return to the replication driver per frame. Will not suppress ForceNetUpdate. Scaled with connection count and capped, see ShooterRepGraph.PlayerState.* */
 	int32 TargetActorsPerFrame = 2;
 
+public:
+
+	int32 GetNumPlayerStates() const { return PlayerStates.Num(); }
+
 private:
-	
+
+	void RebuildBuckets();
+
+	/** Cheap summary of the replicated stats we care about, used to spot changes without touching the replication system */
+	static uint32 GetPlayerStateChangeHash(const APlayerState* PS);
+
+	struct FTrackedPlayerState
+	{
+		APlayerState* PlayerState = nullptr;
+		uint32 ChangeHash = 0;
+		bool bPendingPriority = false;
+	};
+
+	/** Every routed player state. Order is not stable: removal swaps the last entry in */
+	TArray<FTrackedPlayerState> PlayerStates;
+
 	TArray<FActorRepListRefView> ReplicationActorLists;
 	FActorRepListRefView ForceNetUpdateReplicationActorList;
-};
\ No newline at end of file
+
+	/** This frame's bucket, minus player states that aren't valid to gather */
+	FActorRepListRefView CurrentBucketList;
+
+	/** Player states that changed since they last went out, returned to every connection this frame */
+	FActorRepListRefView PriorityReplicationActorList;
+
+	bool bBucketsDirty = true;
+};
+
+/**
+ * 3D counterpart of UReplicationGraphNode_GridSpatialization2D for planet maps, where XY cells put players on opposite sides of a planet together.
+ * Each actor lives in the one cubic cell containing it, kept in a sparse hash keyed by cell coordinate. A connection gathers the cells within
+ * GatherRadius of its viewers. The graph raises GatherRadius until CellSize * GatherRadius covers the largest spatialized cull distance; per actor distance culling still happens in the graph.
+ */
+UCLASS()
+class UShooterReplicationGraphNode_GridSpatialization3D : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterReplicationGraphNode_GridSpatialization3D();
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound=true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+
+	/** Policy is the grid the actor goes to while it is in no field */
+	void AddActor(const FNewReplicatedActorInfo& ActorInfo, EClassRepNodeMapping Policy);
+
+	virtual void PrepareForReplication() override;
+
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	virtual void LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const override;
+
+	/** Same entry points as the 2D grid so routing can use either node. */
+	void AddActor_Static(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo);
+	void AddActor_Dynamic(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo);
+	void AddActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo);
+
+	void RemoveActor_Static(const FNewReplicatedActorInfo& ActorInfo);
+	void RemoveActor_Dynamic(const FNewReplicatedActorInfo& ActorInfo);
+	void RemoveActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo);
+
+	/** Edge length of a cell in world units */
+	float CellSize = 15000.f;
+
+	/** How many cells out from the viewer's cell are gathered on each axis. 1 = 3x3x3 */
+	int32 GatherRadius = 1;
+
+	int32 GetNumCells() const { return Cells.Num(); }
+
+private:
+
+	struct FCell
+	{
+		FActorRepListRefView Actors;
+		TMap<FName, FActorRepListRefView> StreamingLevelActors;
+	};
+
+	struct FTrackedActor
+	{
+		FNewReplicatedActorInfo ActorInfo;
+		FIntVector Cell;
+
+		/** Dormancy routed actors are not rebucketed while dormant */
+		bool bDormancyDriven = false;
+	};
+
+	FIntVector GetCellForLocation(const FVector& Location) const;
+
+	void AddActorToCell(const FNewReplicatedActorInfo& ActorInfo, const FIntVector& CellCoord);
+	bool RemoveActorFromCell(const FNewReplicatedActorInfo& ActorInfo, const FIntVector& CellCoord);
+
+	void AddTrackedActor(TMap<FActorRepListType, FTrackedActor>& Map, const FNewReplicatedActorInfo& ActorInfo, bool bDormancyDriven);
+	bool RemoveTrackedActor(TMap<FActorRepListType, FTrackedActor>& Map, const FNewReplicatedActorInfo& ActorInfo);
+
+	TMap<FIntVector, FCell> Cells;
+
+	TMap<FActorRepListType, FTrackedActor> StaticActors;
+	TMap<FActorRepListType, FTrackedActor> DynamicActors;
+};
+
+/**
+ * Groups actors that receive custom gravity by their dominant gravity field (UCustomGravityComponent::GravityFieldArray[0]).
+ * A field's actors are gathered for a connection when one of its viewers is inside that field or within CrossFieldDistance of its bounds.
+ * Actors in no field are kept on the graph's grid node and moved between it and the field lists as they enter and leave fields.
+ */
+UCLASS()
+class UShooterReplicationGraphNode_GravityField : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterReplicationGraphNode_GravityField();
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound=true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+
+	/** Policy is the grid the actor goes to while it is in no field */
+	void AddActor(const FNewReplicatedActorInfo& ActorInfo, EClassRepNodeMapping Policy);
+
+	virtual void PrepareForReplication() override;
+
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	virtual void LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const override;
+
+	/** Actors in another field are still gathered when the viewer is within this distance of that field's bounds (docking, low orbit) */
+	float CrossFieldDistance = 5000.f;
+
+	int32 GetNumActors() const { return TrackedActors.Num(); }
+	int32 GetNumFields() const { return FieldLists.Num(); }
+
+private:
+
+	struct FTrackedActor
+	{
+		TWeakObjectPtr<UCustomGravityComponent> GravityComponent;
+		FObjectKey Field;
+		EClassRepNodeMapping Policy = EClassRepNodeMapping::Spatialize_Dynamic;
+		bool bSearchedForComponent = false;
+	};
+
+	struct FFieldList
+	{
+		TWeakObjectPtr<UBaseGravityComponent> Field;
+		FActorRepListRefView Actors;
+	};
+
+	/** Field the actor is currently bound to, or null */
+	static UBaseGravityComponent* GetDominantField(AActor* Actor, TWeakObjectPtr<UCustomGravityComponent>& CachedGravityComponent, bool& bSearchedForComponent);
+
+	/** A null field means the graph's grid node */
+	void AddToFieldList(FActorRepListType Actor, UBaseGravityComponent* Field, EClassRepNodeMapping Policy);
+	void RemoveFromFieldList(FActorRepListType Actor, const FObjectKey& FieldKey, EClassRepNodeMapping Policy);
+
+	TMap<FActorRepListType, FTrackedActor> TrackedActors;
+
+	TMap<FObjectKey, FFieldList> FieldLists;
+};
+
+/**
+ * Connection node for demo recording connections. The spatial nodes gather around the viewer, which for a recording is just wherever the demo spectator
+ * sits, so this node hands the recording every spatialized actor instead. Actors near a player's pawn that have moved recently record at their class rate,
+ * everything else ShooterRepGraph.Replay.ReducedRateDivisor times slower. The split is rebuilt every ShooterRepGraph.Replay.RefreshFrames frames.
+ */
+UCLASS()
+class UShooterReplicationGraphNode_Replay : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+
+	/** New actors are picked up by the next rebuild. Removals come from UShooterReplicationGraph::RouteRemoveNetworkActorToNodes so the list never holds a dead actor */
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& Actor) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound=true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	virtual void LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const override;
+
+	void ResetGameWorldState();
+
+	int32 GetNumFullRate() const { return NumFullRate; }
+	int32 GetNumReducedRate() const { return ReplayActors.Num() - NumFullRate; }
+
+private:
+
+	void RebuildActorList(UNetReplicationGraphConnection& ConnectionManager);
+
+	FActorRepListRefView ReplayActors;
+
+	/** Where each actor was at the last rebuild, to tell static actors from moving ones */
+	TMap<FActorRepListType, FVector> LastLocations;
+
+	int32 NumFullRate = 0;
+
+	uint32 LastRebuildFrame = 0;
+	bool bNeedsRebuild = true;
+};
@@ -0,0 +1,193 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "ShooterReplicationGraphClassCache.h"
+#include "ShooterReplicationGraph.h"
+#include "AssetRegistryModule.h"
+#include "IAssetRegistry.h"
+#include "Engine/Blueprint.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace ShooterRepGraphClassCache
+{
+	static const uint32 Magic = 0x53524743; // SRGC
+	static const int32 Version = 3;
+}
+
+static FArchive& operator<<(FArchive& Ar, FShooterRepGraphClassCacheEntry& Entry)
+{
+	Ar << Entry.ClassPath;
+	Ar << Entry.Fingerprint;
+	Ar << Entry.Mapping;
+	Ar << Entry.bHasMapping;
+	Ar << Entry.bNonSpatializedChild;
+	Ar << Entry.bHasClassInfo;
+
+	if (Entry.bHasClassInfo)
+	{
+		FClassReplicationInfo& Info = Entry.ClassInfo;
+		Ar << Info.DistancePriorityScale;
+		Ar << Info.StarvationPriorityScale;
+		Ar << Info.AccumulatedNetPriorityBias;
+
+		uint32 ReplicationPeriodFrame = Info.ReplicationPeriodFrame;
+		uint32 FastPathReplicationPeriodFrame = Info.FastPath_ReplicationPeriodFrame;
+		uint32 ActorChannelFrameTimeout = Info.ActorChannelFrameTimeout;
+		float CullDistanceSquared = Info.GetCullDistanceSquared();
+		Ar << ReplicationPeriodFrame;
+		Ar << FastPathReplicationPeriodFrame;
+		Ar << ActorChannelFrameTimeout;
+		Ar << CullDistanceSquared;
+
+		if (Ar.IsLoading())
+		{
+			Info.ReplicationPeriodFrame = ReplicationPeriodFrame;
+			Info.FastPath_ReplicationPeriodFrame = FastPathReplicationPeriodFrame;
+			Info.ActorChannelFrameTimeout = ActorChannelFrameTimeout;
+			Info.SetCullDistanceSquared(CullDistanceSquared);
+		}
+	}
+
+	return Ar;
+}
+
+FString FShooterRepGraphClassCache::GetFilename()
+{
+	return FPaths::ProjectContentDir() / TEXT("RepGraph/ClassCache.bin");
+}
+
+uint32 FShooterRepGraphClassCache::ComputeFingerprint(const UClass* Class)
+{
+	const AActor* CDO = Class->GetDefaultObject<AActor>();
+	if (CDO == nullptr)
+	{
+		return 0;
+	}
+
+	uint32 Hash = GetTypeHash(Class->GetSuperClass() ? Class->GetSuperClass()->GetFName() : NAME_None);
+	Hash = HashCombine(Hash, GetTypeHash(CDO->GetIsReplicated()));
+	Hash = HashCombine(Hash, GetTypeHash((bool)CDO->bAlwaysRelevant));
+	Hash = HashCombine(Hash, GetTypeHash((bool)CDO->bOnlyRelevantToOwner));
+	Hash = HashCombine(Hash, GetTypeHash((bool)CDO->bNetUseOwnerRelevancy));
+	Hash = HashCombine(Hash, GetTypeHash((uint32)CDO->NetDormancy));
+	Hash = HashCombine(Hash, GetTypeHash(CDO->NetUpdateFrequency));
+	Hash = HashCombine(Hash, GetTypeHash(CDO->NetCullDistanceSquared));
+	return Hash;
+}
+
+void FShooterRepGraphClassCache::GetActorBlueprintClassPaths(TArray<FString>& OutClassPaths)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	TArray<FAssetData> Blueprints;
+	AssetRegistry.GetAssetsByClass(UBlueprint::StaticClass()->GetFName(), Blueprints, true);
+
+	for (const FAssetData& Blueprint : Blueprints)
+	{
+		FString NativeParentClassPath;
+		FString GeneratedClassPath;
+		if (!Blueprint.GetTagValue(FBlueprintTags::NativeParentClassPath, NativeParentClassPath) || !Blueprint.GetTagValue(FBlueprintTags::GeneratedClassPath, GeneratedClassPath))
+		{
+			continue;
+		}
+
+		UClass* NativeParentClass = FindObject<UClass>(nullptr, *FPackageName::ExportTextPathToObjectPath(NativeParentClassPath));
+		if (NativeParentClass == nullptr || !NativeParentClass->IsChildOf(AActor::StaticClass()))
+		{
+			continue;
+		}
+
+		OutClassPaths.Add(FPackageName::ExportTextPathToObjectPath(GeneratedClassPath));
+	}
+
+	OutClassPaths.Sort();
+}
+
+uint32 FShooterRepGraphClassCache::GetContentHash()
+{
+	static uint32 ContentHash = 0;
+	static bool bComputed = false;
+
+	if (!bComputed)
+	{
+		bComputed = true;
+
+		TArray<FString> ClassPaths;
+		GetActorBlueprintClassPaths(ClassPaths);
+
+		ContentHash = GetTypeHash(ClassPaths.Num());
+		for (const FString& ClassPath : ClassPaths)
+		{
+			ContentHash = HashCombine(ContentHash, GetTypeHash(ClassPath));
+		}
+	}
+
+	return ContentHash;
+}
+
+const FShooterRepGraphClassCache* FShooterRepGraphClassCache::GetLoaded()
+{
+	static FShooterRepGraphClassCache Cache;
+	static bool bAttemptedLoad = false;
+	static bool bLoaded = false;
+
+	if (!bAttemptedLoad)
+	{
+		bAttemptedLoad = true;
+		bLoaded = Cache.Load(GetFilename());
+	}
+
+	return bLoaded ? &Cache : nullptr;
+}
+
+bool FShooterRepGraphClassCache::Load(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename, FILEREAD_Silent))
+	{
+		UE_LOG(LogShooterReplicationGraph, Log, TEXT("No replication graph class cache at %s"), *Filename);
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	Serialize(Reader);
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogShooterReplicationGraph, Warning, TEXT("Replication graph class cache %s is corrupt or from an older version"), *Filename);
+		Entries.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FShooterRepGraphClassCache::Save(const FString& Filename) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	const_cast<FShooterRepGraphClassCache*>(this)->Serialize(Writer);
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+void FShooterRepGraphClassCache::Serialize(FArchive& Ar)
+{
+	uint32 Magic = ShooterRepGraphClassCache::Magic;
+	int32 Version = ShooterRepGraphClassCache::Version;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsLoading() && (Magic != ShooterRepGraphClassCache::Magic || Version != ShooterRepGraphClassCache::Version))
+	{
+		Ar.SetError();
+		return;
+	}
+
+	Ar << InputsHash;
+	Ar << ContentHash;
+	Ar << Entries;
+}
@@ -0,0 +1,65 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraphTypes.h"
+
+/** What UShooterReplicationGraph::BuildClassSettings worked out for one class */
+struct FShooterRepGraphClassCacheEntry
+{
+	FString ClassPath;
+
+	/** Hash of the class defaults the routing and settings were derived from, see FShooterRepGraphClassCache::ComputeFingerprint */
+	uint32 Fingerprint = 0;
+
+	/** EClassRepNodeMapping */
+	uint8 Mapping = 0;
+	bool bHasMapping = false;
+
+	bool bHasClassInfo = false;
+	FClassReplicationInfo ClassInfo;
+
+	bool bNonSpatializedChild = false;
+};
+
+/**
+ * Class routing and FClassReplicationInfo table for UShooterReplicationGraph, written at cook time by UShooterRepGraphClassCacheCommandlet
+ * (every actor blueprint loaded) to Content/RepGraph/ClassCache.bin, which is staged with the build.
+ *
+ * Dedicated servers apply it instead of walking every UClass and CDO on each map load. The header hash covers the build and the non class inputs
+ * (tick rate, cvars), each entry carries a fingerprint of its class defaults, and a hash of the actor blueprints in the asset registry catches content
+ * added since the cook. Any mismatch and the graph builds the table from scratch.
+ */
+class FShooterRepGraphClassCache
+{
+public:
+
+	static FString GetFilename();
+
+	/** Hash of the replication related defaults BuildClassSettings looks at */
+	static uint32 ComputeFingerprint(const UClass* Class);
+
+	/** Generated class paths of every actor blueprint the asset registry knows about, sorted. Doesn't load anything */
+	static void GetActorBlueprintClassPaths(TArray<FString>& OutClassPaths);
+
+	/** Hash of GetActorBlueprintClassPaths. Worked out once per process, the registry doesn't change under a cooked server */
+	static uint32 GetContentHash();
+
+	/** Read once per process, so map travel doesn't hit the disk again. Null if there is no usable cache */
+	static const FShooterRepGraphClassCache* GetLoaded();
+
+	bool Load(const FString& Filename);
+	bool Save(const FString& Filename) const;
+
+	uint32 InputsHash = 0;
+
+	TArray<FShooterRepGraphClassCacheEntry> Entries;
+
+	/** GetContentHash when the cache was written. A different value means actor blueprints were added or removed since */
+	uint32 ContentHash = 0;
+
+private:
+
+	void Serialize(FArchive& Ar);
+};
@@ -0,0 +1,163 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "ShooterReplicationGraphMetrics.h"
+#include "ShooterReplicationGraph.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+
+// 0 = off, 1 = dedicated servers only, 2 = any server (listen servers, PIE)
+int32 CVar_ShooterRepGraph_Metrics = 1;
+static FAutoConsoleVariableRef CVarShooterRepGraphMetrics(TEXT("ShooterRepGraph.Metrics"), CVar_ShooterRepGraph_Metrics, TEXT("Record replication graph metrics to Saved/Profiling/RepGraphMetrics. 0: off, 1: dedicated servers, 2: any server"), ECVF_Default );
+
+float CVar_ShooterRepGraph_MetricsFlushInterval = 10.f;
+static FAutoConsoleVariableRef CVarShooterRepGraphMetricsFlushInterval(TEXT("ShooterRepGraph.Metrics.FlushInterval"), CVar_ShooterRepGraph_MetricsFlushInterval, TEXT("Seconds between writes to disk"), ECVF_Default );
+
+// At 30Hz the default holds a little over 30 seconds, so a flush can be missed without losing anything
+int32 CVar_ShooterRepGraph_MetricsBufferSize = 1024;
+static FAutoConsoleVariableRef CVarShooterRepGraphMetricsBufferSize(TEXT("ShooterRepGraph.Metrics.BufferSize"), CVar_ShooterRepGraph_MetricsBufferSize, TEXT("Frame samples kept between flushes. Read when recording starts"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_MetricsSamplePeriod = 30;
+static FAutoConsoleVariableRef CVarShooterRepGraphMetricsSamplePeriod(TEXT("ShooterRepGraph.Metrics.SamplePeriod"), CVar_ShooterRepGraph_MetricsSamplePeriod, TEXT("Walk every connection's actor map (per class and starvation counts) once per this many frames"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_MetricsStarvationFrames = 60;
+static FAutoConsoleVariableRef CVarShooterRepGraphMetricsStarvationFrames(TEXT("ShooterRepGraph.Metrics.StarvationFrames"), CVar_ShooterRepGraph_MetricsStarvationFrames, TEXT("Replication frames an open channel can go without replicating before it counts as starved"), ECVF_Default );
+
+int32 CVar_ShooterRepGraph_MetricsFormat = 0;
+static FAutoConsoleVariableRef CVarShooterRepGraphMetricsFormat(TEXT("ShooterRepGraph.Metrics.Format"), CVar_ShooterRepGraph_MetricsFormat, TEXT("0: CSV, 1: JSON lines. Read when recording starts"), ECVF_Default );
+
+bool FShooterRepGraphMetrics::IsEnabled()
+{
+	return CVar_ShooterRepGraph_Metrics >= 2 || (CVar_ShooterRepGraph_Metrics == 1 && IsRunningDedicatedServer());
+}
+
+bool FShooterRepGraphMetrics::ShouldSampleConnections(uint32 Frame)
+{
+	return CVar_ShooterRepGraph_MetricsSamplePeriod > 0 && (Frame % (uint32)CVar_ShooterRepGraph_MetricsSamplePeriod) == 0;
+}
+
+uint32 FShooterRepGraphMetrics::GetStarvationFrames()
+{
+	return (uint32)FMath::Max(CVar_ShooterRepGraph_MetricsStarvationFrames, 1);
+}
+
+void FShooterRepGraphMetrics::Initialize(const FString& MapName)
+{
+	Samples.SetNum(FMath::Max(CVar_ShooterRepGraph_MetricsBufferSize, 16));
+	Head = 0;
+	NumPending = 0;
+	ClassTotals.Reset();
+	bJson = CVar_ShooterRepGraph_MetricsFormat == 1;
+
+	const FString Directory = FPaths::ProfilingDir() / TEXT("RepGraphMetrics");
+	IFileManager::Get().MakeDirectory(*Directory, true);
+
+	const FString Prefix = Directory / FString::Printf(TEXT("%s_%s"), *FPaths::GetBaseFilename(MapName), *FDateTime::Now().ToString());
+	const TCHAR* Extension = bJson ? TEXT("jsonl") : TEXT("csv");
+	FramesFilename = FString::Printf(TEXT("%s_frames.%s"), *Prefix, Extension);
+	ClassesFilename = FString::Printf(TEXT("%s_classes.%s"), *Prefix, Extension);
+
+	if (!bJson)
+	{
+		FFileHelper::SaveStringToFile(TEXT("Frame,Time,ReplicateMs,Connections,Saturated,TotalOutBytesPerSec,MaxOutBytesPerSec,ActorsReplicated,StarvedActors,OpenChannels,GravityFieldActors,GravityFields,Grid3DCells,PlayerStates\n"), *FramesFilename);
+		FFileHelper::SaveStringToFile(TEXT("Time,Class,Replications,Starved\n"), *ClassesFilename);
+	}
+
+	UE_LOG(LogShooterReplicationGraph, Log, TEXT("Recording replication graph metrics to %s"), *FramesFilename);
+
+	bInitialized = true;
+}
+
+void FShooterRepGraphMetrics::RecordFrame(const FShooterRepGraphFrameSample& Sample)
+{
+	if (!bInitialized)
+	{
+		return;
+	}
+
+	Samples[Head] = Sample;
+	Head = (Head + 1) % Samples.Num();
+	NumPending++;
+	LastSampleTime = Sample.Time;
+}
+
+void FShooterRepGraphMetrics::RecordClassReplication(FName ClassName, int32 Replications, int32 Starved)
+{
+	FClassTotals& Totals = ClassTotals.FindOrAdd(ClassName);
+	Totals.Replications += Replications;
+	Totals.Starved += Starved;
+}
+
+void FShooterRepGraphMetrics::ConditionalFlush(double Now, const FString& MapName)
+{
+	if (!bInitialized)
+	{
+		Initialize(MapName);
+		LastFlushTime = Now;
+		return;
+	}
+
+	if (Now - LastFlushTime >= CVar_ShooterRepGraph_MetricsFlushInterval)
+	{
+		LastFlushTime = Now;
+		Flush();
+	}
+}
+
+void FShooterRepGraphMetrics::AppendFrame(FString& Out, const FShooterRepGraphFrameSample& S, bool bAsJson) const
+{
+	if (bAsJson)
+	{
+		Out += FString::Printf(TEXT("{\"frame\":%u,\"time\":%.3f,\"replicateMs\":%.3f,\"connections\":%d,\"saturated\":%d,\"totalOutBytesPerSec\":%d,\"maxOutBytesPerSec\":%d,\"actorsReplicated\":%d,\"starvedActors\":%d,\"openChannels\":%d,\"gravityFieldActors\":%d,\"gravityFields\":%d,\"grid3DCells\":%d,\"playerStates\":%d}\n"),
+			S.Frame, S.Time, S.ReplicateMs, S.NumConnections, S.NumSaturated, S.TotalOutBytesPerSec, S.MaxOutBytesPerSec, S.ActorsReplicated, S.StarvedActors, S.OpenChannels, S.GravityFieldActors, S.GravityFields, S.Grid3DCells, S.PlayerStates);
+	}
+	else
+	{
+		Out += FString::Printf(TEXT("%u,%.3f,%.3f,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n"),
+			S.Frame, S.Time, S.ReplicateMs, S.NumConnections, S.NumSaturated, S.TotalOutBytesPerSec, S.MaxOutBytesPerSec, S.ActorsReplicated, S.StarvedActors, S.OpenChannels, S.GravityFieldActors, S.GravityFields, S.Grid3DCells, S.PlayerStates);
+	}
+}
+
+void FShooterRepGraphMetrics::Flush()
+{
+	if (!bInitialized || (NumPending == 0 && ClassTotals.Num() == 0))
+	{
+		return;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER( FShooterRepGraphMetrics_Flush );
+
+	const int32 NumToWrite = FMath::Min(NumPending, Samples.Num());
+	UE_CLOG(NumPending > Samples.Num(), LogShooterReplicationGraph, Warning, TEXT("Replication graph metrics dropped %d frames, raise ShooterRepGraph.Metrics.BufferSize or lower FlushInterval"), NumPending - Samples.Num());
+
+	FString Frames;
+	Frames.Reserve(NumToWrite * 96);
+	for (int32 i = NumToWrite; i > 0; --i)
+	{
+		const int32 Index = (Head - i + Samples.Num()) % Samples.Num();
+		AppendFrame(Frames, Samples[Index], bJson);
+	}
+	NumPending = 0;
+
+	FString Classes;
+	for (const TPair<FName, FClassTotals>& Pair : ClassTotals)
+	{
+		if (bJson)
+		{
+			Classes += FString::Printf(TEXT("{\"time\":%.3f,\"class\":\"%s\",\"replications\":%d,\"starved\":%d}\n"), LastSampleTime, *Pair.Key.ToString(), Pair.Value.Replications, Pair.Value.Starved);
+		}
+		else
+		{
+			Classes += FString::Printf(TEXT("%.3f,%s,%d,%d\n"), LastSampleTime, *Pair.Key.ToString(), Pair.Value.Replications, Pair.Value.Starved);
+		}
+	}
+	ClassTotals.Reset();
+
+	// A few KB every FlushInterval, not worth a thread
+	FFileHelper::SaveStringToFile(Frames, *FramesFilename, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	if (Classes.Len() > 0)
+	{
+		FFileHelper::SaveStringToFile(Classes, *ClassesFilename, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	}
+}
@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** One replication frame as seen by UShooterReplicationGraph::ServerReplicateActors */
+struct FShooterRepGraphFrameSample
+{
+	uint32 Frame = 0;
+	double Time = 0.0;
+	float ReplicateMs = 0.f;
+
+	int32 NumConnections = 0;
+	/** Connections that were not net ready once replication finished */
+	int32 NumSaturated = 0;
+	int32 TotalOutBytesPerSec = 0;
+	int32 MaxOutBytesPerSec = 0;
+
+	/** Filled in on connection sample frames only (ShooterRepGraph.Metrics.SamplePeriod), -1 otherwise */
+	int32 ActorsReplicated = -1;
+	int32 StarvedActors = -1;
+	int32 OpenChannels = -1;
+
+	/** Node sizes */
+	int32 GravityFieldActors = 0;
+	int32 GravityFields = 0;
+	int32 Grid3DCells = 0;
+	int32 PlayerStates = 0;
+};
+
+/**
+ * Keeps the last ShooterRepGraph.Metrics.BufferSize frame samples plus per class counters and appends them to
+ * Saved/Profiling/RepGraphMetrics every ShooterRepGraph.Metrics.FlushInterval seconds, as CSV or JSON lines.
+ *
+ * Per class bytes are not visible from the graph; they come from the engine's CSV profiler (csvprofile start) using the
+ * class tracking set up in UShooterReplicationGraph::InitGlobalActorClassSettings. These files cover what the CSV profiler
+ * does not: saturation, starvation and how the graph's own nodes are loaded.
+ */
+class FShooterRepGraphMetrics
+{
+public:
+
+	/** Off by default on anything that isn't a dedicated server, see ShooterRepGraph.Metrics */
+	static bool IsEnabled();
+
+	/** True on frames where the graph should walk every connection's actor map */
+	static bool ShouldSampleConnections(uint32 Frame);
+
+	/** Frames since an open channel last replicated before it counts as starved */
+	static uint32 GetStarvationFrames();
+
+	void RecordFrame(const FShooterRepGraphFrameSample& Sample);
+
+	void RecordClassReplication(FName ClassName, int32 Replications, int32 Starved);
+
+	/** Writes out anything recorded since the last flush once FlushInterval has passed */
+	void ConditionalFlush(double Now, const FString& MapName);
+
+	void Flush();
+
+private:
+
+	struct FClassTotals
+	{
+		int32 Replications = 0;
+		int32 Starved = 0;
+	};
+
+	void Initialize(const FString& MapName);
+
+	void AppendFrame(FString& Out, const FShooterRepGraphFrameSample& Sample, bool bJson) const;
+
+	TArray<FShooterRepGraphFrameSample> Samples;
+
+	/** Next slot to write */
+	int32 Head = 0;
+
+	/** Samples recorded since the last flush. Anything past Samples.Num() was overwritten before it got to disk */
+	int32 NumPending = 0;
+
+	TMap<FName, FClassTotals> ClassTotals;
+
+	double LastFlushTime = 0.0;
+	double LastSampleTime = 0.0;
+
+	FString FramesFilename;
+	FString ClassesFilename;
+	bool bJson = false;
+	bool bInitialized = false;
+};
@@ -28,6 +28,28 @@ FAutoConsoleVariableRef CVarNetEnablePauseRelevancy(
 	TEXT("0: Disable, 1: Enable"),
 	ECVF_Cheat);
 
+// Visible results go stale slowly (replicating something hidden costs bandwidth), paused ones quickly (someone stepping out of cover has to appear)
+static int32 NetPauseRelevancyCacheFrames = 8;
+FAutoConsoleVariableRef CVarNetPauseRelevancyCacheFrames(
+	TEXT("p.NetPauseRelevancyCacheFrames"),
+	NetPauseRelevancyCacheFrames,
+	TEXT("Frames a visible line of sight result is reused for a viewer. 0 traces every time"),
+	ECVF_Default);
+
+static int32 NetPauseRelevancyPausedCacheFrames = 2;
+FAutoConsoleVariableRef CVarNetPauseRelevancyPausedCacheFrames(
+	TEXT("p.NetPauseRelevancyPausedCacheFrames"),
+	NetPauseRelevancyPausedCacheFrames,
+	TEXT("Frames an occluded (paused) result is reused for a viewer"),
+	ECVF_Default);
+
+static float NetPauseRelevancyCacheDistance = 50.f;
+FAutoConsoleVariableRef CVarNetPauseRelevancyCacheDistance(
+	TEXT("p.NetPauseRelevancyCacheDistance"),
+	NetPauseRelevancyCacheDistance,
+	TEXT("A cached result is thrown away early if the viewer or the character moved further than this"),
+	ECVF_Default);
+
 FOnShooterCharacterEquipWeapon AShooterCharacter::NotifyEquipWeapon;
 FOnShooterCharacterUnEquipWeapon AShooterCharacter::NotifyUnEquipWeapon;
 
@@ -1168,11 +1190,11 @@ void AShooterCharacter::Tick(float DeltaSeconds)
 	    USoundNodeLocalPlayer::GetLocallyControlledActorCache().Add(UniqueID, bLocallyControlled);
 	});
 	
-	TArray<FVector> PointsToTest;
-	BuildPauseReplicationCheckPoints(PointsToTest);
-
 	if (NetVisualizeRelevancyTestPoints == 1)
 	{
+		TArray<FVector> PointsToTest;
+		BuildPauseReplicationCheckPoints(PointsToTest);
+
 		for (FVector PointToTest : PointsToTest)
 		{
 			DrawDebugSphere(GetWorld(), PointToTest, 10.0f, 8, FColor::Red);
@@ -1249,21 +1271,65 @@ bool AShooterCharacter::IsReplicationPausedForConnection(const FNetViewer& Conne
 		FRotator ViewRotation;
 		PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
 
+		const FVector ActorLocation = GetActorLocation();
+		const float MaxMoveSq = FMath::Square(NetPauseRelevancyCacheDistance);
+
+		FPauseRelevancyCacheEntry* CacheEntry = PauseRelevancyCache.Find(PC);
+		if (CacheEntry && GFrameCounter < CacheEntry->ValidUntilFrame
+			&& FVector::DistSquared(CacheEntry->ViewLocation, ViewLocation) <= MaxMoveSq
+			&& FVector::DistSquared(CacheEntry->ActorLocation, ActorLocation) <= MaxMoveSq)
+		{
+			return CacheEntry->bPaused;
+		}
+
+		uint64 Stagger = 0;
+		if (CacheEntry == nullptr)
+		{
+			// Players leave without telling us, drop their entries before the map grows
+			if (PauseRelevancyCache.Num() >= 32)
+			{
+				for (auto It = PauseRelevancyCache.CreateIterator(); It; ++It)
+				{
+					if (!It.Key().IsValid())
+					{
+						It.RemoveCurrent();
+					}
+				}
+			}
+
+			CacheEntry = &PauseRelevancyCache.Add(PC);
+
+			// Spread refreshes of pairs that were first checked on the same frame
+			Stagger = (GetUniqueID() ^ PC->GetUniqueID()) % (uint32)FMath::Max(NetPauseRelevancyCacheFrames, 1);
+		}
+
 		FCollisionQueryParams CollisionParams(SCENE_QUERY_STAT(LineOfSight), true, PC->GetPawn());
 		CollisionParams.AddIgnoredActor(this);
 
 		TArray<FVector> PointsToTest;
 		BuildPauseReplicationCheckPoints(PointsToTest);
 
-		for (FVector PointToTest : PointsToTest)
+		// Whatever was visible last time usually still is, so most refreshes are a single trace
+		bool bPaused = true;
+		const int32 NumPoints = PointsToTest.Num();
+		for (int32 i = 0; i < NumPoints; ++i)
 		{
-			if (!GetWorld()->LineTraceTestByChannel(PointToTest, ViewLocation, ECC_Visibility, CollisionParams))
+			const int32 PointIdx = (CacheEntry->LastVisiblePoint + i) % NumPoints;
+			if (!GetWorld()->LineTraceTestByChannel(PointsToTest[PointIdx], ViewLocation, ECC_Visibility, CollisionParams))
 			{
-				return false;
+				CacheEntry->LastVisiblePoint = PointIdx;
+				bPaused = false;
+				break;
 			}
 		}
 
-		return true;
+		CacheEntry->bPaused = bPaused;
+		CacheEntry->ViewLocation = ViewLocation;
+		CacheEntry->ActorLocation = ActorLocation;
+		// Paused entries keep their short lifetime so someone stepping out of cover shows up promptly, only visible ones are staggered
+		CacheEntry->ValidUntilFrame = GFrameCounter + (bPaused ? FMath::Max(NetPauseRelevancyPausedCacheFrames, 0) : FMath::Max(NetPauseRelevancyCacheFrames, 0) + Stagger);
+
+		return bPaused;
 	}
 
 	return false;
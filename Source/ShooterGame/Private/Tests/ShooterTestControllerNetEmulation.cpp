@@ -0,0 +1,155 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#include "ShooterTestControllerNetEmulation.h"
+#include "ShooterGame.h"
+#include "Online/ShooterReplicationGraph.h"
+
+void UShooterTestControllerNetEmulation::OnInit()
+{
+	Super::OnInit();
+
+	Phase = EPhase::WaitingForClient;
+	PhaseTime = 0.f;
+
+	if (!FParse::Value(FCommandLine::Get(), TEXT("NetEmuLoss="), PktLoss))
+	{
+		PktLoss = 10;
+	}
+	if (!FParse::Value(FCommandLine::Get(), TEXT("NetEmuLag="), PktLag))
+	{
+		PktLag = 200;
+	}
+	if (!FParse::Value(FCommandLine::Get(), TEXT("NetEmuSpeed="), LowNetSpeed))
+	{
+		LowNetSpeed = 3000;
+	}
+	if (!FParse::Value(FCommandLine::Get(), TEXT("NetEmuPhaseTime="), MaxPhaseTime))
+	{
+		MaxPhaseTime = 60.f;
+	}
+}
+
+void UShooterTestControllerNetEmulation::OnPostMapChange(UWorld* World)
+{
+	// Match cycling is not what this test is about, just keep going on the new map
+}
+
+void UShooterTestControllerNetEmulation::ApplyEmulation(bool bEnable)
+{
+	UNetDriver* NetDriver = GetWorld() ? GetWorld()->GetNetDriver() : nullptr;
+	if (NetDriver == nullptr)
+	{
+		return;
+	}
+
+#if DO_ENABLE_NET_TEST
+	FPacketSimulationSettings Settings;
+	if (bEnable)
+	{
+		Settings.PktLoss = PktLoss;
+		Settings.PktLag = PktLag;
+	}
+	NetDriver->SetPacketSimulationSettings(Settings);
+#endif
+
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (Connection == nullptr)
+		{
+			continue;
+		}
+
+		if (bEnable)
+		{
+			SavedNetSpeeds.Add(Connection, Connection->CurrentNetSpeed);
+			Connection->CurrentNetSpeed = LowNetSpeed;
+		}
+		else if (const int32* SavedSpeed = SavedNetSpeeds.Find(Connection))
+		{
+			Connection->CurrentNetSpeed = *SavedSpeed;
+		}
+	}
+
+	if (!bEnable)
+	{
+		SavedNetSpeeds.Reset();
+	}
+
+	UE_LOG(LogGauntlet, Display, TEXT("Net emulation %s (loss %d%%, lag %dms, speed %d) on %d connections"), bEnable ? TEXT("on") : TEXT("off"), PktLoss, PktLag, LowNetSpeed, NetDriver->ClientConnections.Num());
+}
+
+int32 UShooterTestControllerNetEmulation::GetMaxAdaptiveLevel() const
+{
+	UNetDriver* NetDriver = GetWorld() ? GetWorld()->GetNetDriver() : nullptr;
+	UShooterReplicationGraph* Graph = NetDriver ? NetDriver->GetReplicationDriver<UShooterReplicationGraph>() : nullptr;
+	if (Graph == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	int32 MaxLevel = 0;
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		MaxLevel = FMath::Max(MaxLevel, Graph->GetAdaptiveLevel(Connection));
+	}
+	return MaxLevel;
+}
+
+void UShooterTestControllerNetEmulation::OnTick(float TimeDelta)
+{
+	UNetDriver* NetDriver = GetWorld() ? GetWorld()->GetNetDriver() : nullptr;
+
+	PhaseTime += TimeDelta;
+
+	switch (Phase)
+	{
+	case EPhase::WaitingForClient:
+		if (NetDriver && NetDriver->ClientConnections.Num() > 0 && IsInGame())
+		{
+			if (GetMaxAdaptiveLevel() == INDEX_NONE)
+			{
+				UE_LOG(LogGauntlet, Error, TEXT("Net emulation test needs UShooterReplicationGraph as the replication driver"));
+				EndTest(-1);
+				return;
+			}
+
+			ApplyEmulation(true);
+			Phase = EPhase::Degraded;
+			PhaseTime = 0.f;
+		}
+		else if (GetTimeInCurrentState() > 300)
+		{
+			UE_LOG(LogGauntlet, Error, TEXT("Failing net emulation test, no client joined after 300 secs!"));
+			EndTest(-1);
+		}
+		break;
+
+	case EPhase::Degraded:
+		if (GetMaxAdaptiveLevel() > 0)
+		{
+			UE_LOG(LogGauntlet, Display, TEXT("Replication graph backed off to level %d after %.1f secs"), GetMaxAdaptiveLevel(), PhaseTime);
+			ApplyEmulation(false);
+			Phase = EPhase::Recovering;
+			PhaseTime = 0.f;
+		}
+		else if (PhaseTime > MaxPhaseTime)
+		{
+			UE_LOG(LogGauntlet, Error, TEXT("Replication graph never backed off a saturated connection in %.0f secs"), MaxPhaseTime);
+			ApplyEmulation(false);
+			EndTest(-1);
+		}
+		break;
+
+	case EPhase::Recovering:
+		if (GetMaxAdaptiveLevel() == 0)
+		{
+			UE_LOG(LogGauntlet, Display, TEXT("Replication graph recovered after %.1f secs"), PhaseTime);
+			EndTest(0);
+		}
+		else if (PhaseTime > MaxPhaseTime)
+		{
+			UE_LOG(LogGauntlet, Error, TEXT("Replication graph still backed off to level %d %.0f secs after emulation ended"), GetMaxAdaptiveLevel(), MaxPhaseTime);
+			EndTest(-1);
+		}
+		break;
+	}
+}
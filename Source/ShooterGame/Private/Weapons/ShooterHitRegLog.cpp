@@ -0,0 +1,278 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Weapons/ShooterHitRegLog.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+int32 CVar_ShooterHitRegLog_Enable = 1;
+static FAutoConsoleVariableRef CVarShooterHitRegLogEnable(TEXT("ShooterHitRegLog.Enable"), CVar_ShooterHitRegLog_Enable, TEXT("Log every client side hit the server checks to Saved/HitReg."), ECVF_Default);
+
+int32 CVar_ShooterHitRegLog_Capacity = 65536;
+static FAutoConsoleVariableRef CVarShooterHitRegLogCapacity(TEXT("ShooterHitRegLog.Capacity"), CVar_ShooterHitRegLog_Capacity, TEXT("Records kept in each hit registration log before the oldest are overwritten. Read when a log is created."), ECVF_Default);
+
+float CVar_ShooterHitRegLog_FlushInterval = 5.0f;
+static FAutoConsoleVariableRef CVarShooterHitRegLogFlushInterval(TEXT("ShooterHitRegLog.FlushInterval"), CVar_ShooterHitRegLog_FlushInterval, TEXT("Seconds between writes of queued hit registration records."), ECVF_Default);
+
+namespace ShooterHitRegLog
+{
+	static const uint32 Magic = 0x53485247; // SHRG
+	static const int32 Version = 2;
+
+	/** keeps 64 names well inside the header */
+	static const int32 MaxWeaponNameLength = 48;
+}
+
+const TCHAR* EHitRegDecision::ToString(Type Decision)
+{
+	switch (Decision)
+	{
+		case Trusted:			return TEXT("Trusted");
+		case ConfirmedRewind:	return TEXT("ConfirmedRewind");
+		case ConfirmedBounds:	return TEXT("ConfirmedBounds");
+		case RejectedRewind:	return TEXT("RejectedRewind");
+		case RejectedBounds:	return TEXT("RejectedBounds");
+		case RejectedViewAngle:	return TEXT("RejectedViewAngle");
+		case RejectedSpread:	return TEXT("RejectedSpread");
+		case RejectedNotFiring:	return TEXT("RejectedNotFiring");
+		default:				return TEXT("Unknown");
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FShooterHitRegRecord& Record)
+{
+	Ar << Record.ServerTime;
+	Ar << Record.ClientTimestamp;
+	Ar << Record.RewindDelta;
+	Ar << Record.ShooterId;
+	Ar << Record.TargetId;
+	Ar << Record.ShotDistance;
+	Ar << Record.TraceStartError;
+	Ar << Record.ViewDotHitDir;
+	Ar << Record.ShotIndex;
+	Ar << Record.WeaponIndex;
+	Ar << Record.Decision;
+	return Ar;
+}
+
+FString FShooterHitRegLogFile::GetDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("HitReg");
+}
+
+void FShooterHitRegLogFile::SerializeHeader(FArchive& Ar)
+{
+	uint32 Magic = ShooterHitRegLog::Magic;
+	int32 Version = ShooterHitRegLog::Version;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsLoading() && (Magic != ShooterHitRegLog::Magic || Version != ShooterHitRegLog::Version))
+	{
+		Ar.SetError();
+		return;
+	}
+
+	Ar << Capacity;
+	Ar << NumWritten;
+	Ar << WeaponNames;
+}
+
+bool FShooterHitRegLogFile::Load(const FString& Filename, TArray<FShooterHitRegRecord>& OutRecords)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename, FILEREAD_Silent) || Bytes.Num() < HeaderSize)
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	SerializeHeader(Reader);
+
+	const int64 NumRecords = FMath::Min<uint64>(NumWritten, Capacity);
+	if (Reader.IsError() || Capacity == 0 || Bytes.Num() < HeaderSize + NumRecords * RecordSize)
+	{
+		return false;
+	}
+
+	OutRecords.Reset(NumRecords);
+	for (uint64 RecordNumber = NumWritten - NumRecords; RecordNumber < NumWritten; RecordNumber++)
+	{
+		Reader.Seek(HeaderSize + (RecordNumber % Capacity) * RecordSize);
+		Reader << OutRecords.AddDefaulted_GetRef();
+	}
+
+	return !Reader.IsError();
+}
+
+void UShooterHitRegLogSubsystem::Deinitialize()
+{
+	Flush();
+
+	delete LogFile;
+	LogFile = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UShooterHitRegLogSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (LogFile)
+	{
+		TimeSinceFlush += DeltaTime;
+		if (TimeSinceFlush >= CVar_ShooterHitRegLog_FlushInterval)
+		{
+			Flush();
+			TimeSinceFlush = 0.0f;
+		}
+	}
+}
+
+TStatId UShooterHitRegLogSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterHitRegLogSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterHitRegLogSubsystem::AddRecord(const UClass* WeaponClass, FShooterHitRegRecord& Record)
+{
+	if (CVar_ShooterHitRegLog_Enable == 0 || !OpenLog())
+	{
+		return;
+	}
+
+	const FName WeaponName = WeaponClass ? WeaponClass->GetFName() : NAME_None;
+	const uint8* WeaponIndex = WeaponIndices.Find(WeaponName);
+	if (WeaponIndex == nullptr)
+	{
+		uint8 NewIndex = FShooterHitRegLogFile::OtherWeaponIndex;
+		if (FileLayout.WeaponNames.Num() < FShooterHitRegLogFile::MaxWeapons)
+		{
+			// names with non ANSI characters are stored as UTF-16, so the count alone doesn't keep the header inside HeaderSize
+			FileLayout.WeaponNames.Add(WeaponName.ToString().Left(ShooterHitRegLog::MaxWeaponNameLength));
+			if (SerializeHeaderToBuffer() > FShooterHitRegLogFile::HeaderSize)
+			{
+				FileLayout.WeaponNames.Pop();
+			}
+			else
+			{
+				NewIndex = FileLayout.WeaponNames.Num() - 1;
+			}
+		}
+
+		if (NewIndex == FShooterHitRegLogFile::OtherWeaponIndex && !bWarnedWeaponsFull)
+		{
+			UE_LOG(LogShooterWeapon, Warning, TEXT("Hit registration log has no room for more weapon names, %s and any after it are logged as %s"), *WeaponName.ToString(), *FileLayout.WeaponNames[FShooterHitRegLogFile::OtherWeaponIndex]);
+			bWarnedWeaponsFull = true;
+		}
+		WeaponIndex = &WeaponIndices.Add(WeaponName, NewIndex);
+	}
+
+	Record.WeaponIndex = *WeaponIndex;
+	PendingRecords.Add(Record);
+
+	if (PendingRecords.Num() >= (int32)FileLayout.Capacity)
+	{
+		Flush();
+	}
+}
+
+void UShooterHitRegLogSubsystem::Flush()
+{
+	if (LogFile == nullptr || PendingRecords.Num() == 0)
+	{
+		return;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER(UShooterHitRegLogSubsystem_Flush);
+
+	// anything older than the last Capacity records would be overwritten by this same flush
+	const int32 Capacity = FileLayout.Capacity;
+	int32 Index = FMath::Max(0, PendingRecords.Num() - Capacity);
+	uint64 RecordNumber = FileLayout.NumWritten + Index;
+
+	// one write per contiguous run of slots, two when the ring wraps
+	while (Index < PendingRecords.Num())
+	{
+		const int32 Slot = RecordNumber % Capacity;
+		const int32 Count = FMath::Min(PendingRecords.Num() - Index, Capacity - Slot);
+
+		WriteBuffer.Reset();
+		FMemoryWriter Writer(WriteBuffer);
+		for (int32 i = 0; i < Count; i++)
+		{
+			Writer << PendingRecords[Index + i];
+		}
+
+		LogFile->Seek(FShooterHitRegLogFile::HeaderSize + (int64)Slot * FShooterHitRegLogFile::RecordSize);
+		LogFile->Write(WriteBuffer.GetData(), WriteBuffer.Num());
+
+		Index += Count;
+		RecordNumber += Count;
+	}
+
+	FileLayout.NumWritten += PendingRecords.Num();
+	PendingRecords.Reset();
+
+	WriteHeader();
+	LogFile->Flush();
+}
+
+bool UShooterHitRegLogSubsystem::OpenLog()
+{
+	if (bTriedOpen)
+	{
+		return LogFile != nullptr;
+	}
+	bTriedOpen = true;
+
+	if (CVar_ShooterHitRegLog_Capacity <= 0)
+	{
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FShooterHitRegLogFile::GetDirectory());
+
+	const FString Filename = FShooterHitRegLogFile::GetDirectory() / FString::Printf(TEXT("HitReg_%s_%s.bin"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString());
+	LogFile = PlatformFile.OpenWrite(*Filename);
+	if (LogFile == nullptr)
+	{
+		UE_LOG(LogShooterWeapon, Warning, TEXT("Failed to create hit registration log %s"), *Filename);
+		return false;
+	}
+
+	FileLayout.Capacity = CVar_ShooterHitRegLog_Capacity;
+	FileLayout.NumWritten = 0;
+	FileLayout.WeaponNames.Reset();
+	FileLayout.WeaponNames.Add(TEXT("Other"));
+	WriteHeader();
+
+	UE_LOG(LogShooterWeapon, Log, TEXT("Logging hit registration to %s"), *Filename);
+	return true;
+}
+
+int32 UShooterHitRegLogSubsystem::SerializeHeaderToBuffer()
+{
+	WriteBuffer.Reset();
+	FMemoryWriter Writer(WriteBuffer);
+	FileLayout.SerializeHeader(Writer);
+	return WriteBuffer.Num();
+}
+
+void UShooterHitRegLogSubsystem::WriteHeader()
+{
+	// AddRecord only keeps names that fit
+	if (!ensure(SerializeHeaderToBuffer() <= FShooterHitRegLogFile::HeaderSize))
+	{
+		return;
+	}
+	WriteBuffer.SetNumZeroed(FShooterHitRegLogFile::HeaderSize);
+
+	LogFile->Seek(0);
+	LogFile->Write(WriteBuffer.GetData(), WriteBuffer.Num());
+}
@@ -0,0 +1,147 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "ShooterHitRegReportCommandlet.h"
+#include "Weapons/ShooterHitRegLog.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+
+namespace ShooterHitRegReport
+{
+	struct FHitStats
+	{
+		int32 Decisions[EHitRegDecision::MAX] = {};
+		int32 NumHits = 0;
+		int32 NumRejected = 0;
+		double RewindDeltaSum = 0.0;
+
+		void Add(const FShooterHitRegRecord& Record)
+		{
+			if (Record.Decision < EHitRegDecision::MAX)
+			{
+				Decisions[Record.Decision]++;
+			}
+
+			NumHits++;
+			NumRejected += EHitRegDecision::IsRejected((EHitRegDecision::Type)Record.Decision) ? 1 : 0;
+			RewindDeltaSum += Record.RewindDelta;
+		}
+
+		float GetRejectionRate() const
+		{
+			return NumHits > 0 ? (float)NumRejected / NumHits : 0.0f;
+		}
+
+		float GetAverageRewindMs() const
+		{
+			return NumHits > 0 ? (float)(RewindDeltaSum * 1000.0 / NumHits) : 0.0f;
+		}
+	};
+}
+
+UShooterHitRegReportCommandlet::UShooterHitRegReportCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UShooterHitRegReportCommandlet::Main(const FString& Params)
+{
+	using namespace ShooterHitRegReport;
+
+	int32 MinHits = 50;
+	float FlagRate = 0.25f;
+	FString CsvFilename;
+	FParse::Value(*Params, TEXT("MinHits="), MinHits);
+	FParse::Value(*Params, TEXT("FlagRate="), FlagRate);
+	FParse::Value(*Params, TEXT("Csv="), CsvFilename);
+
+	TArray<FString> Filenames;
+	FString Filename;
+	if (FParse::Value(*Params, TEXT("File="), Filename))
+	{
+		Filenames.Add(Filename);
+	}
+	else
+	{
+		const FString Directory = FShooterHitRegLogFile::GetDirectory();
+		IFileManager::Get().FindFiles(Filenames, *(Directory / TEXT("HitReg_*.bin")), true, false);
+		for (FString& Found : Filenames)
+		{
+			Found = Directory / Found;
+		}
+	}
+
+	if (Filenames.Num() == 0)
+	{
+		UE_LOG(LogShooterWeapon, Error, TEXT("No hit registration logs found"));
+		return 1;
+	}
+
+	TMap<FString, FHitStats> WeaponStats;
+	int32 NumLogs = 0;
+
+	for (const FString& LogFilename : Filenames)
+	{
+		FShooterHitRegLogFile HitRegLog;
+		TArray<FShooterHitRegRecord> Records;
+		if (!HitRegLog.Load(LogFilename, Records))
+		{
+			UE_LOG(LogShooterWeapon, Warning, TEXT("Skipping %s, not a hit registration log or from an older version"), *LogFilename);
+			continue;
+		}
+		NumLogs++;
+
+		TMap<int32, FHitStats> ShooterStats;
+		for (const FShooterHitRegRecord& Record : Records)
+		{
+			const FString WeaponName = HitRegLog.WeaponNames.IsValidIndex(Record.WeaponIndex) ? HitRegLog.WeaponNames[Record.WeaponIndex] : TEXT("Unknown");
+			WeaponStats.FindOrAdd(WeaponName).Add(Record);
+			ShooterStats.FindOrAdd(Record.ShooterId).Add(Record);
+		}
+
+		for (const TPair<int32, FHitStats>& Shooter : ShooterStats)
+		{
+			if (Shooter.Value.NumHits >= MinHits && Shooter.Value.GetRejectionRate() >= FlagRate)
+			{
+				UE_LOG(LogShooterWeapon, Display, TEXT("%s: player %d had %d of %d hits rejected (%.1f%%)"), *FPaths::GetCleanFilename(LogFilename), Shooter.Key, Shooter.Value.NumRejected, Shooter.Value.NumHits, Shooter.Value.GetRejectionRate() * 100.0f);
+			}
+		}
+	}
+
+	WeaponStats.KeySort(TLess<FString>());
+
+	FString Csv = TEXT("Weapon,Hits,Rejected,RejectionRate,AvgRewindMs");
+	for (int32 Decision = 0; Decision < EHitRegDecision::MAX; Decision++)
+	{
+		Csv += FString::Printf(TEXT(",%s"), EHitRegDecision::ToString((EHitRegDecision::Type)Decision));
+	}
+	Csv += LINE_TERMINATOR;
+
+	for (const TPair<FString, FHitStats>& Weapon : WeaponStats)
+	{
+		const FHitStats& Stats = Weapon.Value;
+		UE_LOG(LogShooterWeapon, Display, TEXT("%-32s %8d hits %6.2f%% rejected (rewind %d, bounds %d, view %d, spread %d, not firing %d), average rewind %.0f ms"),
+			*Weapon.Key, Stats.NumHits, Stats.GetRejectionRate() * 100.0f,
+			Stats.Decisions[EHitRegDecision::RejectedRewind], Stats.Decisions[EHitRegDecision::RejectedBounds], Stats.Decisions[EHitRegDecision::RejectedViewAngle],
+			Stats.Decisions[EHitRegDecision::RejectedSpread], Stats.Decisions[EHitRegDecision::RejectedNotFiring], Stats.GetAverageRewindMs());
+
+		Csv += FString::Printf(TEXT("%s,%d,%d,%f,%f"), *Weapon.Key, Stats.NumHits, Stats.NumRejected, Stats.GetRejectionRate(), Stats.GetAverageRewindMs());
+		for (int32 Decision = 0; Decision < EHitRegDecision::MAX; Decision++)
+		{
+			Csv += FString::Printf(TEXT(",%d"), Stats.Decisions[Decision]);
+		}
+		Csv += LINE_TERMINATOR;
+	}
+
+	if (!CsvFilename.IsEmpty() && !FFileHelper::SaveStringToFile(Csv, *CsvFilename))
+	{
+		UE_LOG(LogShooterWeapon, Error, TEXT("Failed to write %s"), *CsvFilename);
+		return 1;
+	}
+
+	UE_LOG(LogShooterWeapon, Display, TEXT("Read %d of %d hit registration logs"), NumLogs, Filenames.Num());
+	return 0;
+}
@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ShooterHitRegReportCommandlet.generated.h"
+
+/**
+ * Aggregates hit registration logs written by UShooterHitRegLogSubsystem into per weapon rejection rates, and lists players whose hits
+ * were rejected unusually often. Reads every log in Saved/HitReg unless one is given:
+ *
+ *		UnrealEditor-Cmd ShooterGame.uproject -run=ShooterHitRegReport [-File=<log>] [-Csv=<output>] [-MinHits=50] [-FlagRate=0.25]
+ *
+ * Player ids are only unique within one server session, so players are reported per log.
+ */
+UCLASS()
+class UShooterHitRegReportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UShooterHitRegReportCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
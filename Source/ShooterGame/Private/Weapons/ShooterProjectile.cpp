@@ -4,6 +4,8 @@
 #include "Weapons/ShooterProjectile.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "Effects/ShooterExplosionEffect.h"
+#include "Effects/ShooterEffectPool.h"
+#include "Weapons/ShooterProjectileManager.h"
 
 AShooterProjectile::AShooterProjectile(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -63,6 +65,15 @@ void AShooterProjectile::InitVelocity(FVector& ShootDirection)
 	}
 }
 
+void AShooterProjectile::InitManagedProjectileType(FShooterManagedProjectileType& Type) const
+{
+	Type.Speed = MovementComp->InitialSpeed;
+	Type.CollisionRadius = CollisionComp->GetUnscaledSphereRadius();
+	Type.GravityScale = MovementComp->ProjectileGravityScale;
+	Type.ExplosionTemplate = ExplosionTemplate;
+	Type.TrailFX = ParticleComp->Template;
+}
+
 void AShooterProjectile::OnImpact(const FHitResult& HitResult)
 {
 	if (GetLocalRole() == ROLE_Authority && !bExploded)
@@ -90,11 +101,19 @@ void AShooterProjectile::Explode(const FHitResult& Impact)
 	if (ExplosionTemplate)
 	{
 		FTransform const SpawnTransform(Impact.ImpactNormal.Rotation(), NudgedImpactLocation);
-		AShooterExplosionEffect* const EffectActor = GetWorld()->SpawnActorDeferred<AShooterExplosionEffect>(ExplosionTemplate, SpawnTransform);
-		if (EffectActor)
+		UShooterEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UShooterEffectPoolSubsystem>();
+		if (EffectPool)
+		{
+			EffectPool->SpawnExplosionEffect(ExplosionTemplate, SpawnTransform, Impact);
+		}
+		else
 		{
-			EffectActor->SurfaceHit = Impact;
-			UGameplayStatics::FinishSpawningActor(EffectActor, SpawnTransform);
+			AShooterExplosionEffect* const EffectActor = GetWorld()->SpawnActorDeferred<AShooterExplosionEffect>(ExplosionTemplate, SpawnTransform);
+			if (EffectActor)
+			{
+				EffectActor->SurfaceHit = Impact;
+				UGameplayStatics::FinishSpawningActor(EffectActor, SpawnTransform);
+			}
 		}
 	}
 
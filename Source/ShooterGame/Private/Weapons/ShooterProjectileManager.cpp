@@ -0,0 +1,258 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Weapons/ShooterProjectileManager.h"
+#include "Weapons/ShooterProjectile.h"
+#include "Weapons/ShooterWeapon_Projectile.h"
+#include "Effects/ShooterEffectPool.h"
+#include "Effects/ShooterExplosionEffect.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Circuit/Subsystems/GravityFieldSubsystem.h"
+
+int32 CVar_ShooterProjectileManager_MaxProjectiles = 2048;
+static FAutoConsoleVariableRef CVarShooterProjectileManagerMaxProjectiles(TEXT("ShooterProjectileManager.MaxProjectiles"), CVar_ShooterProjectileManager_MaxProjectiles, TEXT("Most managed projectiles in flight at once, new ones past that are dropped."), ECVF_Default);
+
+/** longest step one projectile is moved in a single sweep, so a hitch doesn't tunnel it through thin walls */
+static const float ShooterProjectileMaxSubstep = 1.0f / 30.0f;
+
+void UShooterProjectileManager::Deinitialize()
+{
+	for (UParticleSystemComponent* Trail : Trails)
+	{
+		if (Trail)
+		{
+			Trail->ReleaseToPool();
+		}
+	}
+
+	Types.Empty();
+	Positions.Empty();
+	Velocities.Empty();
+	LifeRemaining.Empty();
+	TypeIndices.Empty();
+	Authority.Empty();
+	Instigators.Empty();
+	InstigatorControllers.Empty();
+	DamageCausers.Empty();
+	Trails.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShooterProjectileManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Positions.Num() > 0)
+	{
+		SimulateProjectiles(DeltaTime);
+	}
+}
+
+TStatId UShooterProjectileManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterProjectileManager, STATGROUP_Tickables);
+}
+
+int32 UShooterProjectileManager::GetProjectileType(AShooterWeapon_Projectile* Weapon)
+{
+	UClass* WeaponClass = Weapon->GetClass();
+	const int32 ExistingIndex = Types.IndexOfByPredicate([WeaponClass](const FShooterManagedProjectileType& Type) { return Type.WeaponClass.Get() == WeaponClass; });
+	if (ExistingIndex != INDEX_NONE)
+	{
+		return ExistingIndex;
+	}
+
+	FProjectileWeaponData WeaponConfig;
+	Weapon->ApplyWeaponConfig(WeaponConfig);
+
+	const AShooterProjectile* ProjectileCDO = WeaponConfig.ProjectileClass ? WeaponConfig.ProjectileClass->GetDefaultObject<AShooterProjectile>() : nullptr;
+	if (ProjectileCDO == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	FShooterManagedProjectileType& Type = Types.AddDefaulted_GetRef();
+	Type.WeaponClass = WeaponClass;
+	Type.Life = WeaponConfig.ProjectileLife;
+	Type.ExplosionDamage = WeaponConfig.ExplosionDamage;
+	Type.ExplosionRadius = WeaponConfig.ExplosionRadius;
+	Type.DamageType = WeaponConfig.DamageType;
+	ProjectileCDO->InitManagedProjectileType(Type);
+
+	return Types.Num() - 1;
+}
+
+void UShooterProjectileManager::SpawnProjectile(int32 TypeIndex, AShooterWeapon_Projectile* Weapon, const FVector& Origin, const FVector& Direction, float ElapsedTime, bool bAuthority)
+{
+	if (!Types.IsValidIndex(TypeIndex) || Positions.Num() >= CVar_ShooterProjectileManager_MaxProjectiles)
+	{
+		return;
+	}
+
+	const FShooterManagedProjectileType& Type = Types[TypeIndex];
+
+	Positions.Add(Origin);
+	Velocities.Add(Direction * Type.Speed);
+	LifeRemaining.Add(Type.Life);
+	TypeIndices.Add(TypeIndex);
+	Authority.Add(bAuthority);
+	Instigators.Add(Weapon ? Weapon->GetInstigator() : nullptr);
+	InstigatorControllers.Add(Weapon ? Weapon->GetInstigatorController() : nullptr);
+	DamageCausers.Add(Weapon);
+
+	UParticleSystemComponent* Trail = nullptr;
+	if (Type.TrailFX && GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		Trail = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Type.TrailFX, Origin, Direction.Rotation(), FVector(1.0f), false, EPSCPoolMethod::ManualRelease);
+	}
+	Trails.Add(Trail);
+
+	// catch up on the flight time it missed, the sweeps still run so it can hit things on the way
+	if (ElapsedTime > 0.0f)
+	{
+		const int32 Index = Positions.Num() - 1;
+
+		FGravityFieldQuery GravityQuery;
+		const bool bUseGravityFields = Type.GravityScale != 0.0f && GatherGravityFields(GravityQuery);
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterProjectileManager), false);
+		FHitResult Hit;
+		if (SimulateProjectile(Index, ElapsedTime, QueryParams, bUseGravityFields ? &GravityQuery : nullptr, Hit))
+		{
+			ExplodeProjectile(Index, Hit);
+			RemoveProjectile(Index);
+		}
+		else if (LifeRemaining[Index] <= 0.0f)
+		{
+			RemoveProjectile(Index);
+		}
+	}
+}
+
+void UShooterProjectileManager::SimulateProjectiles(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(UShooterProjectileManager_SimulateProjectiles);
+
+	// one gravity field lookup for the whole batch, only if anything actually falls
+	FGravityFieldQuery GravityQuery;
+	const FGravityFieldQuery* GravityQueryPtr = nullptr;
+	if (Types.ContainsByPredicate([](const FShooterManagedProjectileType& Type) { return Type.GravityScale != 0.0f; }) && GatherGravityFields(GravityQuery))
+	{
+		GravityQueryPtr = &GravityQuery;
+	}
+
+	// shared query, only the ignored instigator changes per projectile
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterProjectileManager), false);
+
+	for (int32 Index = Positions.Num() - 1; Index >= 0; --Index)
+	{
+		FHitResult Hit;
+		if (SimulateProjectile(Index, DeltaTime, QueryParams, GravityQueryPtr, Hit))
+		{
+			ExplodeProjectile(Index, Hit);
+			RemoveProjectile(Index);
+		}
+		else if (LifeRemaining[Index] <= 0.0f)
+		{
+			RemoveProjectile(Index);
+		}
+	}
+}
+
+bool UShooterProjectileManager::GatherGravityFields(FGravityFieldQuery& OutQuery) const
+{
+	if (const UGravityFieldSubsystem* GravityFields = GetWorld()->GetSubsystem<UGravityFieldSubsystem>())
+	{
+		GravityFields->GatherFields(FVector::ZeroVector, WORLD_MAX, OutQuery);
+		return true;
+	}
+	return false;
+}
+
+bool UShooterProjectileManager::SimulateProjectile(int32 Index, float DeltaTime, FCollisionQueryParams& QueryParams, const FGravityFieldQuery* GravityQuery, FHitResult& OutHit)
+{
+	const FShooterManagedProjectileType& Type = Types[TypeIndices[Index]];
+	const FCollisionShape Shape = FCollisionShape::MakeSphere(Type.CollisionRadius);
+
+	QueryParams.ClearIgnoredActors();
+	if (AActor* Instigator = Instigators[Index].Get())
+	{
+		QueryParams.AddIgnoredActor(Instigator);
+	}
+
+	float TimeLeft = FMath::Min(DeltaTime, LifeRemaining[Index]);
+	LifeRemaining[Index] -= DeltaTime;
+
+	bool bHit = false;
+	while (TimeLeft > KINDA_SMALL_NUMBER && !bHit)
+	{
+		const float StepTime = FMath::Min(TimeLeft, ShooterProjectileMaxSubstep);
+		TimeLeft -= StepTime;
+
+		FVector& Position = Positions[Index];
+		FVector& Velocity = Velocities[Index];
+
+		FVector NewVelocity = Velocity;
+		if (Type.GravityScale != 0.0f)
+		{
+			const FVector Gravity = GravityQuery ? GravityQuery->GetGravity(Position) : FVector(0.0f, 0.0f, GetWorld()->GetGravityZ());
+			NewVelocity += Gravity * Type.GravityScale * StepTime;
+		}
+
+		const FVector NewPosition = Position + (Velocity + NewVelocity) * 0.5f * StepTime;
+
+		bHit = GetWorld()->SweepSingleByChannel(OutHit, Position, NewPosition, FQuat::Identity, COLLISION_PROJECTILE, Shape, QueryParams);
+
+		Position = bHit ? OutHit.Location : NewPosition;
+		Velocity = NewVelocity;
+	}
+
+	if (UParticleSystemComponent* Trail = Trails[Index])
+	{
+		Trail->SetWorldLocationAndRotation(Positions[Index], Velocities[Index].Rotation());
+	}
+
+	return bHit;
+}
+
+void UShooterProjectileManager::ExplodeProjectile(int32 Index, const FHitResult& Impact)
+{
+	const FShooterManagedProjectileType& Type = Types[TypeIndices[Index]];
+
+	// effects and damage origin shouldn't be placed inside mesh at impact point
+	const FVector NudgedImpactLocation = Impact.ImpactPoint + Impact.ImpactNormal * 10.0f;
+
+	if (Authority[Index] && Type.ExplosionDamage > 0 && Type.ExplosionRadius > 0 && Type.DamageType)
+	{
+		UGameplayStatics::ApplyRadialDamage(this, Type.ExplosionDamage, NudgedImpactLocation, Type.ExplosionRadius, Type.DamageType, TArray<AActor*>(), DamageCausers[Index].Get(), InstigatorControllers[Index].Get());
+	}
+
+	if (Type.ExplosionTemplate && GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		FTransform const SpawnTransform(Impact.ImpactNormal.Rotation(), NudgedImpactLocation);
+		if (UShooterEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UShooterEffectPoolSubsystem>())
+		{
+			EffectPool->SpawnExplosionEffect(Type.ExplosionTemplate, SpawnTransform, Impact);
+		}
+	}
+}
+
+void UShooterProjectileManager::RemoveProjectile(int32 Index)
+{
+	if (UParticleSystemComponent* Trail = Trails[Index])
+	{
+		Trail->DeactivateSystem();
+		Trail->ReleaseToPool();
+	}
+
+	Positions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	LifeRemaining.RemoveAtSwap(Index, 1, false);
+	TypeIndices.RemoveAtSwap(Index, 1, false);
+	Authority.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+	InstigatorControllers.RemoveAtSwap(Index, 1, false);
+	DamageCausers.RemoveAtSwap(Index, 1, false);
+	Trails.RemoveAtSwap(Index, 1, false);
+}
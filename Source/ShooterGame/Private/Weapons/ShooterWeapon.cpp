@@ -2,6 +2,7 @@
 
 #include "ShooterGame.h"
 #include "Weapons/ShooterWeapon.h"
+#include "Weapons/ShooterWeaponScheduler.h"
 #include "Player/ShooterCharacter.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "Bots/ShooterAIController.h"
@@ -37,13 +38,9 @@ AShooterWeapon::AShooterWeapon(const FObjectInitializer& ObjectInitializer) : Su
 	bPlayingFireAnim = false;
 	bIsEquipped = false;
 	bWantsToFire = false;
-	bPendingReload = false;
 	bPendingEquip = false;
 	CurrentState = EWeaponState::Idle;
 
-	CurrentAmmo = 0;
-	CurrentAmmoInClip = 0;
-	BurstCounter = 0;
 	LastFireTime = 0.0f;
 
 	PrimaryActorTick.bCanEverTick = true;
@@ -59,8 +56,8 @@ void AShooterWeapon::PostInitializeComponents()
 
 	if (WeaponConfig.InitialClips > 0)
 	{
-		CurrentAmmoInClip = WeaponConfig.AmmoPerClip;
-		CurrentAmmo = WeaponConfig.AmmoPerClip * WeaponConfig.InitialClips;
+		AmmoState.CurrentAmmoInClip = WeaponConfig.AmmoPerClip;
+		AmmoState.CurrentAmmo = WeaponConfig.AmmoPerClip * WeaponConfig.InitialClips;
 	}
 
 	DetachMeshFromPawn();
@@ -71,6 +68,11 @@ void AShooterWeapon::Destroyed()
 	Super::Destroyed();
 
 	StopSimulatingWeaponFire();
+
+	if (UShooterWeaponScheduler* WeaponScheduler = GetWorld()->GetSubsystem<UShooterWeaponScheduler>())
+	{
+		WeaponScheduler->CancelReFiring(this);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -124,7 +126,7 @@ void AShooterWeapon::OnEquipFinished()
 	{
 		// try to reload empty clip
 		if (MyPawn->IsLocallyControlled() &&
-			CurrentAmmoInClip <= 0 &&
+			AmmoState.CurrentAmmoInClip <= 0 &&
 			CanReload())
 		{
 			StartReload();
@@ -140,10 +142,10 @@ void AShooterWeapon::OnUnEquip()
 	bIsEquipped = false;
 	StopFire();
 
-	if (bPendingReload)
+	if (FireState.bPendingReload)
 	{
 		StopWeaponAnimation(ReloadAnim);
-		bPendingReload = false;
+		FireState.bPendingReload = false;
 
 		GetWorldTimerManager().ClearTimer(TimerHandle_StopReload);
 		GetWorldTimerManager().ClearTimer(TimerHandle_ReloadWeapon);
@@ -267,7 +269,7 @@ void AShooterWeapon::StartReload(bool bFromReplication)
 
 	if (bFromReplication || CanReload())
 	{
-		bPendingReload = true;
+		FireState.bPendingReload = true;
 		DetermineWeaponState();
 
 		float AnimDuration = PlayWeaponAnimation(ReloadAnim);		
@@ -296,7 +298,7 @@ void AShooterWeapon::StopReload()
 
 	if (CurrentState == EWeaponState::Reloading)
 	{
-		bPendingReload = false;
+		FireState.bPendingReload = false;
 		DetermineWeaponState();
 		StopWeaponAnimation(ReloadAnim);
 	}
@@ -354,13 +356,13 @@ bool AShooterWeapon::CanFire() const
 {
 	bool bCanFire = MyPawn && MyPawn->CanFire();
 	bool bStateOKToFire = ( ( CurrentState ==  EWeaponState::Idle ) || ( CurrentState == EWeaponState::Firing) );	
-	return (( bCanFire == true ) && ( bStateOKToFire == true ) && ( bPendingReload == false ));
+	return (( bCanFire == true ) && ( bStateOKToFire == true ) && ( FireState.bPendingReload == false ));
 }
 
 bool AShooterWeapon::CanReload() const
 {
 	bool bCanReload = (!MyPawn || MyPawn->CanReload());
-	bool bGotAmmo = ( CurrentAmmoInClip < WeaponConfig.AmmoPerClip) && (CurrentAmmo - CurrentAmmoInClip > 0 || HasInfiniteClip());
+	bool bGotAmmo = ( AmmoState.CurrentAmmoInClip < WeaponConfig.AmmoPerClip) && (AmmoState.CurrentAmmo - AmmoState.CurrentAmmoInClip > 0 || HasInfiniteClip());
 	bool bStateOKToReload = ( ( CurrentState ==  EWeaponState::Idle ) || ( CurrentState == EWeaponState::Firing) );
 	return ( ( bCanReload == true ) && ( bGotAmmo == true ) && ( bStateOKToReload == true) );	
 }
@@ -371,9 +373,9 @@ bool AShooterWeapon::CanReload() const
 
 void AShooterWeapon::GiveAmmo(int AddAmount)
 {
-	const int32 MissingAmmo = FMath::Max(0, WeaponConfig.MaxAmmo - CurrentAmmo);
+	const int32 MissingAmmo = FMath::Max(0, WeaponConfig.MaxAmmo - AmmoState.CurrentAmmo);
 	AddAmount = FMath::Min(AddAmount, MissingAmmo);
-	CurrentAmmo += AddAmount;
+	AmmoState.CurrentAmmo += AddAmount;
 
 	AShooterAIController* BotAI = MyPawn ? Cast<AShooterAIController>(MyPawn->GetController()) : NULL;
 	if (BotAI)
@@ -394,12 +396,12 @@ void AShooterWeapon::UseAmmo()
 {
 	if (!HasInfiniteAmmo())
 	{
-		CurrentAmmoInClip--;
+		AmmoState.CurrentAmmoInClip--;
 	}
 
 	if (!HasInfiniteAmmo() && !HasInfiniteClip())
 	{
-		CurrentAmmo--;
+		AmmoState.CurrentAmmo--;
 	}
 
 	AShooterAIController* BotAI = MyPawn ? Cast<AShooterAIController>(MyPawn->GetController()) : NULL;	
@@ -424,24 +426,15 @@ void AShooterWeapon::UseAmmo()
 	}
 }
 
-void AShooterWeapon::HandleReFiring()
+void AShooterWeapon::HandleReFiring(double FireTime)
 {
-	// Update TimerIntervalAdjustment
-	UWorld* MyWorld = GetWorld();
-
-	float SlackTimeThisFrame = FMath::Max(0.0f, (MyWorld->TimeSeconds - LastFireTime) - WeaponConfig.TimeBetweenShots);
-
-	if (bAllowAutomaticWeaponCatchup)
-	{
-		TimerIntervalAdjustment -= SlackTimeThisFrame;
-	}
-
-	HandleFiring();
+	// without catch up the next shot is timed from this frame instead, losing whatever the tick overshot by
+	HandleFiring(bAllowAutomaticWeaponCatchup ? FireTime : GetWorld()->GetTimeSeconds());
 }
 
-void AShooterWeapon::HandleFiring()
+void AShooterWeapon::HandleFiring(double FireTime)
 {
-	if ((CurrentAmmoInClip > 0 || HasInfiniteClip() || HasInfiniteAmmo()) && CanFire())
+	if ((AmmoState.CurrentAmmoInClip > 0 || HasInfiniteClip() || HasInfiniteAmmo()) && CanFire())
 	{
 		if (GetNetMode() != NM_DedicatedServer)
 		{
@@ -455,7 +448,7 @@ void AShooterWeapon::HandleFiring()
 			UseAmmo();
 			
 			// update firing FX on remote clients if function was called on server
-			BurstCounter++;
+			FireState.IncrementBurstCounter();
 		}
 	}
 	else if (CanReload())
@@ -476,7 +469,7 @@ void AShooterWeapon::HandleFiring()
 		}
 		
 		// stop weapon fire FX, but stay in Firing state
-		if (BurstCounter > 0)
+		if (FireState.BurstCounter > 0)
 		{
 			OnBurstFinished();
 		}
@@ -495,21 +488,21 @@ void AShooterWeapon::HandleFiring()
 		}
 
 		// reload after firing last round
-		if (CurrentAmmoInClip <= 0 && CanReload())
+		if (AmmoState.CurrentAmmoInClip <= 0 && CanReload())
 		{
 			StartReload();
 		}
 
 		// setup refire timer
 		bRefiring = (CurrentState == EWeaponState::Firing && WeaponConfig.TimeBetweenShots > 0.0f);
-		if (bRefiring)
+		UShooterWeaponScheduler* WeaponScheduler = GetWorld()->GetSubsystem<UShooterWeaponScheduler>();
+		if (bRefiring && WeaponScheduler)
 		{
-			GetWorldTimerManager().SetTimer(TimerHandle_HandleFiring, this, &AShooterWeapon::HandleReFiring, FMath::Max<float>(WeaponConfig.TimeBetweenShots + TimerIntervalAdjustment, SMALL_NUMBER), false);
-			TimerIntervalAdjustment = 0.f;
+			WeaponScheduler->ScheduleReFiring(this, FireTime + WeaponConfig.TimeBetweenShots);
 		}
 	}
 
-	LastFireTime = GetWorld()->GetTimeSeconds();
+	LastFireTime = FireTime;
 }
 
 bool AShooterWeapon::ServerHandleFiring_Validate()
@@ -519,9 +512,9 @@ bool AShooterWeapon::ServerHandleFiring_Validate()
 
 void AShooterWeapon::ServerHandleFiring_Implementation()
 {
-	const bool bShouldUpdateAmmo = (CurrentAmmoInClip > 0 && CanFire());
+	const bool bShouldUpdateAmmo = (AmmoState.CurrentAmmoInClip > 0 && CanFire());
 
-	HandleFiring();
+	HandleFiring(GetWorld()->GetTimeSeconds());
 
 	if (bShouldUpdateAmmo)
 	{
@@ -529,27 +522,27 @@ void AShooterWeapon::ServerHandleFiring_Implementation()
 		UseAmmo();
 
 		// update firing FX on remote clients
-		BurstCounter++;
+		FireState.IncrementBurstCounter();
 	}
 }
 
 void AShooterWeapon::ReloadWeapon()
 {
-	int32 ClipDelta = FMath::Min(WeaponConfig.AmmoPerClip - CurrentAmmoInClip, CurrentAmmo - CurrentAmmoInClip);
+	int32 ClipDelta = FMath::Min(WeaponConfig.AmmoPerClip - AmmoState.CurrentAmmoInClip, AmmoState.CurrentAmmo - AmmoState.CurrentAmmoInClip);
 
 	if (HasInfiniteClip())
 	{
-		ClipDelta = WeaponConfig.AmmoPerClip - CurrentAmmoInClip;
+		ClipDelta = WeaponConfig.AmmoPerClip - AmmoState.CurrentAmmoInClip;
 	}
 
 	if (ClipDelta > 0)
 	{
-		CurrentAmmoInClip += ClipDelta;
+		AmmoState.CurrentAmmoInClip += ClipDelta;
 	}
 
 	if (HasInfiniteClip())
 	{
-		CurrentAmmo = FMath::Max(CurrentAmmoInClip, CurrentAmmo);
+		AmmoState.CurrentAmmo = FMath::Max(AmmoState.CurrentAmmoInClip, AmmoState.CurrentAmmo);
 	}
 }
 
@@ -576,7 +569,7 @@ void AShooterWeapon::DetermineWeaponState()
 
 	if (bIsEquipped)
 	{
-		if( bPendingReload  )
+		if( FireState.bPendingReload  )
 		{
 			if( CanReload() == false )
 			{
@@ -587,7 +580,7 @@ void AShooterWeapon::DetermineWeaponState()
 				NewState = EWeaponState::Reloading;
 			}
 		}		
-		else if ( (bPendingReload == false ) && ( bWantsToFire == true ) && ( CanFire() == true ))
+		else if ( (FireState.bPendingReload == false ) && ( bWantsToFire == true ) && ( CanFire() == true ))
 		{
 			NewState = EWeaponState::Firing;
 		}
@@ -603,22 +596,23 @@ void AShooterWeapon::DetermineWeaponState()
 void AShooterWeapon::OnBurstStarted()
 {
 	// start firing, can be delayed to satisfy TimeBetweenShots
-	const float GameTime = GetWorld()->GetTimeSeconds();
+	const double GameTime = GetWorld()->GetTimeSeconds();
+	UShooterWeaponScheduler* WeaponScheduler = GetWorld()->GetSubsystem<UShooterWeaponScheduler>();
 	if (LastFireTime > 0 && WeaponConfig.TimeBetweenShots > 0.0f &&
-		LastFireTime + WeaponConfig.TimeBetweenShots > GameTime)
+		LastFireTime + WeaponConfig.TimeBetweenShots > GameTime && WeaponScheduler)
 	{
-		GetWorldTimerManager().SetTimer(TimerHandle_HandleFiring, this, &AShooterWeapon::HandleFiring, LastFireTime + WeaponConfig.TimeBetweenShots - GameTime, false);
+		WeaponScheduler->ScheduleReFiring(this, LastFireTime + WeaponConfig.TimeBetweenShots);
 	}
 	else
 	{
-		HandleFiring();
+		HandleFiring(GameTime);
 	}
 }
 
 void AShooterWeapon::OnBurstFinished()
 {
 	// stop firing FX on remote clients
-	BurstCounter = 0;
+	FireState.BurstCounter = 0;
 
 	// stop firing FX locally, unless it's a dedicated server
 	//if (GetNetMode() != NM_DedicatedServer)
@@ -626,11 +620,11 @@ void AShooterWeapon::OnBurstFinished()
 		StopSimulatingWeaponFire();
 	//}
 	
-	GetWorldTimerManager().ClearTimer(TimerHandle_HandleFiring);
+	if (UShooterWeaponScheduler* WeaponScheduler = GetWorld()->GetSubsystem<UShooterWeaponScheduler>())
+	{
+		WeaponScheduler->CancelReFiring(this);
+	}
 	bRefiring = false;
-
-	// reset firing interval adjustment
-	TimerIntervalAdjustment = 0.0f;
 }
 
 
@@ -798,9 +792,22 @@ void AShooterWeapon::OnRep_MyPawn()
 	}
 }
 
+void AShooterWeapon::OnRep_FireState(const FShooterWeaponFireState& PreviousFireState)
+{
+	if (FireState.bPendingReload != PreviousFireState.bPendingReload)
+	{
+		OnRep_Reload();
+	}
+
+	if (FireState.BurstCounter != PreviousFireState.BurstCounter)
+	{
+		OnRep_BurstCounter();
+	}
+}
+
 void AShooterWeapon::OnRep_BurstCounter()
 {
-	if (BurstCounter > 0)
+	if (FireState.BurstCounter > 0)
 	{
 		SimulateWeaponFire();
 	}
@@ -812,7 +819,7 @@ void AShooterWeapon::OnRep_BurstCounter()
 
 void AShooterWeapon::OnRep_Reload()
 {
-	if (bPendingReload)
+	if (FireState.bPendingReload)
 	{
 		StartReload(true);
 	}
@@ -929,11 +936,51 @@ void AShooterWeapon::GetLifetimeReplicatedProps( TArray< FLifetimeProperty > & O
 
 	DOREPLIFETIME( AShooterWeapon, MyPawn );
 
-	DOREPLIFETIME_CONDITION( AShooterWeapon, CurrentAmmo,		COND_OwnerOnly );
-	DOREPLIFETIME_CONDITION( AShooterWeapon, CurrentAmmoInClip, COND_OwnerOnly );
+	DOREPLIFETIME_CONDITION( AShooterWeapon, AmmoState,	COND_OwnerOnly );
+	DOREPLIFETIME_CONDITION( AShooterWeapon, FireState,	COND_SkipOwner );
+}
 
-	DOREPLIFETIME_CONDITION( AShooterWeapon, BurstCounter,		COND_SkipOwner );
-	DOREPLIFETIME_CONDITION( AShooterWeapon, bPendingReload,	COND_SkipOwner );
+bool FShooterWeaponAmmoState::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PackedAmmo = FMath::Max(CurrentAmmo, 0);
+	uint32 PackedAmmoInClip = FMath::Max(CurrentAmmoInClip, 0);
+	Ar.SerializeIntPacked(PackedAmmo);
+	Ar.SerializeIntPacked(PackedAmmoInClip);
+
+	if (Ar.IsLoading())
+	{
+		CurrentAmmo = PackedAmmo;
+		CurrentAmmoInClip = PackedAmmoInClip;
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+bool FShooterWeaponFireState::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 bReloading = bPendingReload;
+	uint8 bFiring = (BurstCounter != 0);
+	Ar.SerializeBits(&bReloading, 1);
+	Ar.SerializeBits(&bFiring, 1);
+
+	// the counter only means anything while firing
+	if (bFiring)
+	{
+		Ar << BurstCounter;
+	}
+	else if (Ar.IsLoading())
+	{
+		BurstCounter = 0;
+	}
+
+	if (Ar.IsLoading())
+	{
+		bPendingReload = bReloading;
+	}
+
+	bOutSuccess = true;
+	return true;
 }
 
 USkeletalMeshComponent* AShooterWeapon::GetWeaponMesh() const
@@ -963,12 +1010,12 @@ EWeaponState::Type AShooterWeapon::GetCurrentState() const
 
 int32 AShooterWeapon::GetCurrentAmmo() const
 {
-	return CurrentAmmo;
+	return AmmoState.CurrentAmmo;
 }
 
 int32 AShooterWeapon::GetCurrentAmmoInClip() const
 {
-	return CurrentAmmoInClip;
+	return AmmoState.CurrentAmmoInClip;
 }
 
 int32 AShooterWeapon::GetAmmoPerClip() const
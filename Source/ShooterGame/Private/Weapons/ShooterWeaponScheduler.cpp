@@ -0,0 +1,159 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Weapons/ShooterWeaponScheduler.h"
+#include "Weapons/ShooterWeapon.h"
+
+int32 CVar_ShooterWeaponScheduler_MaxReFiresPerTick = 8;
+static FAutoConsoleVariableRef CVarShooterWeaponSchedulerMaxReFiresPerTick(TEXT("ShooterWeaponScheduler.MaxReFiresPerTick"), CVar_ShooterWeaponScheduler_MaxReFiresPerTick, TEXT("Most times one weapon refires in a single tick, the rest carry over to the next one so a hitch doesn't empty a clip in one frame."), ECVF_Default);
+
+/** width of one wheel slot, finer than any tick rate we run at so a slot never holds more than a frame's worth of refires */
+static const double WeaponSchedulerSlotTime = 1.0 / 120.0;
+
+/** slots in the wheel, about two seconds which covers the refire time of every weapon in a single turn */
+static const int32 WeaponSchedulerNumSlots = 256;
+
+void UShooterWeaponScheduler::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Slots.SetNum(WeaponSchedulerNumSlots);
+	CurrentSlot = 0;
+	NextSequence = 0;
+	bFiringDueReFirings = false;
+}
+
+void UShooterWeaponScheduler::Deinitialize()
+{
+	Slots.Empty();
+	PendingSequences.Empty();
+	DueReFirings.Empty();
+	ReFiresThisTick.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShooterWeaponScheduler::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	if (PendingSequences.Num() == 0)
+	{
+		CurrentSlot = FMath::Max(CurrentSlot, GetSlot(Now));
+		return;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER(UShooterWeaponScheduler_Tick);
+
+	CollectDueReFirings(Now);
+
+	ReFiresThisTick.Reset();
+
+	TGuardValue<bool> FiringGuard(bFiringDueReFirings, true);
+	while (DueReFirings.Num() > 0)
+	{
+		FScheduledReFiring Entry;
+		DueReFirings.HeapPop(Entry, false);
+
+		if (!IsCurrent(Entry))
+		{
+			continue;
+		}
+
+		AShooterWeapon* Weapon = Entry.Weapon.Get();
+		int32& ReFireCount = ReFiresThisTick.FindOrAdd(Weapon);
+		if (ReFireCount >= CVar_ShooterWeaponScheduler_MaxReFiresPerTick)
+		{
+			// keeps its due time, so it catches up over the next ticks
+			Slots[GetSlot(Entry.FireTime) % WeaponSchedulerNumSlots].Add(Entry);
+			continue;
+		}
+		ReFireCount++;
+
+		// fire rates above the tick rate reschedule into DueReFirings and go again in this pass
+		PendingSequences.Remove(Entry.Weapon);
+		Weapon->HandleReFiring(Entry.FireTime);
+	}
+}
+
+TStatId UShooterWeaponScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterWeaponScheduler, STATGROUP_Tickables);
+}
+
+void UShooterWeaponScheduler::ScheduleReFiring(AShooterWeapon* Weapon, double FireTime)
+{
+	check(Weapon);
+
+	FScheduledReFiring Entry;
+	Entry.Weapon = Weapon;
+	Entry.FireTime = FireTime;
+	Entry.Sequence = ++NextSequence;
+
+	PendingSequences.Add(Entry.Weapon, Entry.Sequence);
+
+	// anything already due goes straight to this tick's pass if it's running, or is found in the current slot next tick
+	if (bFiringDueReFirings && FireTime <= GetWorld()->GetTimeSeconds())
+	{
+		DueReFirings.HeapPush(Entry);
+	}
+	else
+	{
+		Slots[GetSlot(FireTime) % WeaponSchedulerNumSlots].Add(Entry);
+	}
+}
+
+void UShooterWeaponScheduler::CancelReFiring(AShooterWeapon* Weapon)
+{
+	PendingSequences.Remove(Weapon);
+}
+
+bool UShooterWeaponScheduler::IsReFiringScheduled(AShooterWeapon* Weapon) const
+{
+	return PendingSequences.Contains(Weapon);
+}
+
+int64 UShooterWeaponScheduler::GetSlot(double Time) const
+{
+	return FMath::Max((int64)FMath::FloorToDouble(Time / WeaponSchedulerSlotTime), CurrentSlot);
+}
+
+void UShooterWeaponScheduler::CollectDueReFirings(double Now)
+{
+	// after a long hitch one turn of the wheel already visits every slot
+	const int64 NowSlot = GetSlot(Now);
+	const int64 LastSlot = FMath::Min(NowSlot, CurrentSlot + WeaponSchedulerNumSlots - 1);
+
+	for (int64 Slot = CurrentSlot; Slot <= LastSlot; Slot++)
+	{
+		TArray<FScheduledReFiring>& Bucket = Slots[Slot % WeaponSchedulerNumSlots];
+		for (int32 Index = Bucket.Num() - 1; Index >= 0; --Index)
+		{
+			const FScheduledReFiring& Entry = Bucket[Index];
+			if (!IsCurrent(Entry))
+			{
+				if (!Entry.Weapon.IsValid())
+				{
+					PendingSequences.Remove(Entry.Weapon);
+				}
+				Bucket.RemoveAtSwap(Index, 1, false);
+			}
+			else if (Entry.FireTime <= Now)
+			{
+				DueReFirings.HeapPush(Entry);
+				Bucket.RemoveAtSwap(Index, 1, false);
+			}
+		}
+	}
+
+	// the current slot is visited again next tick, for refires scheduled late into it
+	CurrentSlot = NowSlot;
+}
+
+bool UShooterWeaponScheduler::IsCurrent(const FScheduledReFiring& Entry) const
+{
+	const uint32* Sequence = PendingSequences.Find(Entry.Weapon);
+	return Sequence && *Sequence == Entry.Sequence && Entry.Weapon.IsValid();
+}
@@ -4,10 +4,151 @@
 #include "Weapons/ShooterWeapon_Instant.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "Effects/ShooterImpactEffect.h"
+#include "Effects/ShooterEffectPool.h"
+#include "Circuit/Components/LagCompensationComponent.h"
+#include "Circuit/Subsystems/GravityFieldSubsystem.h"
 
 AShooterWeapon_Instant::AShooterWeapon_Instant(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
 	CurrentFiringSpread = 0.0f;
+	ShotSeedBase = 0;
+	ShotCounter = 0;
+}
+
+void AShooterWeapon_Instant::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (GetLocalRole() == ROLE_Authority)
+	{
+		ShotSeedBase = FMath::Rand();
+	}
+
+	if (GetNetMode() != NM_DedicatedServer && ImpactTemplate)
+	{
+		if (UShooterEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UShooterEffectPoolSubsystem>())
+		{
+			EffectPool->Prewarm(ImpactTemplate);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Shot info
+
+void FInstantHitInfo::SetAim(const FVector& AimDir)
+{
+	const FRotator AimRotation = AimDir.Rotation();
+	AimPitch = FRotator::CompressAxisToShort(AimRotation.Pitch);
+	AimYaw = FRotator::CompressAxisToShort(AimRotation.Yaw);
+}
+
+FVector FInstantHitInfo::GetAimDir() const
+{
+	return FRotator(FRotator::DecompressAxisFromShort(AimPitch), FRotator::DecompressAxisFromShort(AimYaw), 0.0f).Vector();
+}
+
+void FInstantHitInfo::SetReticleSpread(float SpreadDegrees)
+{
+	ReticleSpread = (uint16)FMath::Clamp(FMath::RoundToInt(SpreadDegrees * 100.0f), 0, (int32)MAX_uint16);
+}
+
+float FInstantHitInfo::GetReticleSpread() const
+{
+	return ReticleSpread / 100.0f;
+}
+
+bool FInstantHitInfo::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << ShotIndex;
+	Ar << ReticleSpread;
+	Ar << AimPitch;
+	Ar << AimYaw;
+
+	bOutSuccess = true;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Pellet batch
+
+FHitResult FInstantPelletBatch::MakeHitResult(int32 HitIndex, float WeaponRange) const
+{
+	const FVector ImpactPoint = HitPoints[HitIndex];
+	const FVector ShootDir = (ImpactPoint - TraceStart).GetSafeNormal();
+
+	FHitResult Impact(ForceInit);
+	Impact.bBlockingHit = true;
+	Impact.TraceStart = TraceStart;
+	Impact.TraceEnd = TraceStart + ShootDir * WeaponRange;
+	Impact.Location = ImpactPoint;
+	Impact.ImpactPoint = ImpactPoint;
+	Impact.Normal = -ShootDir;
+	Impact.ImpactNormal = -ShootDir;
+	Impact.Distance = FVector::Dist(TraceStart, ImpactPoint);
+	Impact.HitObjectHandle = FActorInstanceHandle(HitActors[HitIndex]);
+
+	return Impact;
+}
+
+bool FInstantPelletBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	bool bStartSuccess = true;
+	TraceStart.NetSerialize(Ar, Map, bStartSuccess);
+	bOutSuccess &= bStartSuccess;
+
+	bool bShotSuccess = true;
+	Shot.NetSerialize(Ar, Map, bShotSuccess);
+	bOutSuccess &= bShotSuccess;
+
+	Ar << ClientTimestamp;
+
+	// 1..MaxPellets in 5 bits
+	uint32 PackedNumPellets = FMath::Clamp<int32>(NumPellets, 1, MaxPellets) - 1;
+	if (Ar.IsLoading())
+	{
+		PackedNumPellets = 0;
+	}
+	Ar.SerializeBits(&PackedNumPellets, 5);
+	NumPellets = PackedNumPellets + 1;
+
+	// only as many mask bits as there are pellets
+	if (Ar.IsLoading())
+	{
+		HitMask = 0;
+	}
+	Ar.SerializeBits(&HitMask, NumPellets);
+	if (NumPellets < MaxPellets)
+	{
+		HitMask &= (1u << NumPellets) - 1;
+	}
+
+	const int32 NumHits = FMath::CountBits(HitMask);
+	if (Ar.IsLoading())
+	{
+		HitPoints.SetNum(NumHits);
+		HitActors.SetNum(NumHits);
+	}
+	else if (HitPoints.Num() != NumHits || HitActors.Num() != NumHits)
+	{
+		bOutSuccess = false;
+		return false;
+	}
+
+	for (int32 HitIndex = 0; HitIndex < NumHits; HitIndex++)
+	{
+		bool bPointSuccess = true;
+		HitPoints[HitIndex].NetSerialize(Ar, Map, bPointSuccess);
+		bOutSuccess &= bPointSuccess;
+
+		UObject* HitActor = HitActors[HitIndex];
+		bOutSuccess &= Map->SerializeObject(Ar, AActor::StaticClass(), HitActor);
+		HitActors[HitIndex] = Cast<AActor>(HitActor);
+	}
+
+	return true;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -15,55 +156,183 @@ AShooterWeapon_Instant::AShooterWeapon_Instant(const FObjectInitializer& ObjectI
 
 void AShooterWeapon_Instant::FireWeapon()
 {
-	const int32 RandomSeed = FMath::Rand();
-	FRandomStream WeaponRandomStream(RandomSeed);
-	const float CurrentSpread = GetCurrentSpread();
-	const float ConeHalfAngle = FMath::DegreesToRadians(CurrentSpread * 0.5f);
+	FInstantHitInfo ShotInfo;
+	ShotInfo.ShotIndex = ++ShotCounter;
+	ShotInfo.SetReticleSpread(GetCurrentSpread());
+	ShotInfo.SetAim(GetAdjustedAim());
 
-	const FVector AimDir = GetAdjustedAim();
+	// fire with the quantized aim, so remote machines regenerate exactly this shot
+	const FVector AimDir = ShotInfo.GetAimDir();
 	const FVector StartTrace = GetCameraDamageStartLocation(AimDir);
-	const FVector ShootDir = WeaponRandomStream.VRandCone(AimDir, ConeHalfAngle, ConeHalfAngle);
-	const FVector EndTrace = StartTrace + ShootDir * InstantConfig.WeaponRange;
 
-	const FHitResult Impact = WeaponTrace(StartTrace, EndTrace);
-	ProcessInstantHit(Impact, StartTrace, ShootDir, RandomSeed, CurrentSpread);
+	if (GetPelletsPerShot() > 1)
+	{
+		FirePellets(ShotInfo, StartTrace);
+	}
+	else
+	{
+		FRandomStream WeaponRandomStream = GetShotRandomStream(ShotInfo);
+		const FVector ShootDir = GetShotDirection(WeaponRandomStream, ShotInfo);
+
+		const FHitResult Impact = InstantTrace(StartTrace, ShootDir);
+		ProcessInstantHit(Impact, StartTrace, ShootDir, ShotInfo);
+	}
 
 	CurrentFiringSpread = FMath::Min(InstantConfig.FiringSpreadMax, CurrentFiringSpread + InstantConfig.FiringSpreadIncrement);
 }
 
-bool AShooterWeapon_Instant::ServerNotifyHit_Validate(const FHitResult& Impact, FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread)
+bool AShooterWeapon_Instant::ServerNotifyHit_Validate(const FHitResult& Impact, FInstantHitInfo ShotInfo, float ClientTimestamp)
 {
 	return true;
 }
 
-void AShooterWeapon_Instant::ServerNotifyHit_Implementation(const FHitResult& Impact, FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread)
+FRandomStream AShooterWeapon_Instant::GetShotRandomStream(const FInstantHitInfo& ShotInfo) const
+{
+	return FRandomStream((int32)HashCombine((uint32)ShotSeedBase, (uint32)ShotInfo.ShotIndex));
+}
+
+FVector AShooterWeapon_Instant::GetShotDirection(FRandomStream& WeaponRandomStream, const FInstantHitInfo& ShotInfo) const
+{
+	const float ConeHalfAngle = FMath::DegreesToRadians(ShotInfo.GetReticleSpread() * 0.5f);
+	return WeaponRandomStream.VRandCone(ShotInfo.GetAimDir(), ConeHalfAngle, ConeHalfAngle);
+}
+
+void AShooterWeapon_Instant::FirePellets(const FInstantHitInfo& ShotInfo, const FVector& StartTrace)
 {
-	const float WeaponAngleDot = FMath::Abs(FMath::Sin(ReticleSpread * PI / 180.f));
+	FRandomStream WeaponRandomStream = GetShotRandomStream(ShotInfo);
+	const int32 NumPellets = GetPelletsPerShot();
+
+	// same query for every pellet, so set it up once
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(WeaponTrace), true, GetInstigator());
+	TraceParams.bReturnPhysicalMaterial = true;
+
+	TArray<FVector, TInlineAllocator<FInstantPelletBatch::MaxPellets>> ShootDirs;
+	TArray<FHitResult, TInlineAllocator<FInstantPelletBatch::MaxPellets>> Impacts;
+	ShootDirs.SetNum(NumPellets);
+	Impacts.SetNum(NumPellets);
+
+	// draw every direction before tracing, in the same order SimulateInstantHit does
+	for (int32 PelletIndex = 0; PelletIndex < NumPellets; PelletIndex++)
+	{
+		ShootDirs[PelletIndex] = GetShotDirection(WeaponRandomStream, ShotInfo);
+	}
+
+	for (int32 PelletIndex = 0; PelletIndex < NumPellets; PelletIndex++)
+	{
+		if (InstantConfig.bBallistic)
+		{
+			Impacts[PelletIndex] = InstantTrace(StartTrace, ShootDirs[PelletIndex]);
+		}
+		else
+		{
+			const FVector EndTrace = StartTrace + ShootDirs[PelletIndex] * InstantConfig.WeaponRange;
+			GetWorld()->LineTraceSingleByChannel(Impacts[PelletIndex], StartTrace, EndTrace, COLLISION_WEAPON, TraceParams);
+		}
+	}
+
+	if (MyPawn && MyPawn->IsLocallyControlled() && GetNetMode() == NM_Client)
+	{
+		FInstantPelletBatch Batch;
+		Batch.TraceStart = StartTrace;
+		Batch.Shot = ShotInfo;
+		Batch.ClientTimestamp = GetClientHitTimestamp();
+		Batch.NumPellets = NumPellets;
+
+		for (int32 PelletIndex = 0; PelletIndex < NumPellets; PelletIndex++)
+		{
+			// report the same hits a single shot would: things the server controls, and the world
+			const FHitResult& Impact = Impacts[PelletIndex];
+			const bool bReportHit = Impact.GetActor() ? Impact.GetActor()->GetRemoteRole() == ROLE_Authority : Impact.bBlockingHit;
+			if (bReportHit)
+			{
+				Batch.HitMask |= 1u << PelletIndex;
+				Batch.HitPoints.Add(Impact.ImpactPoint);
+				Batch.HitActors.Add(Impact.GetActor());
+			}
+		}
+
+		ServerNotifyPellets(Batch);
+	}
+
+	for (int32 PelletIndex = 0; PelletIndex < NumPellets; PelletIndex++)
+	{
+		ProcessInstantHit_Confirmed(Impacts[PelletIndex], StartTrace, ShootDirs[PelletIndex], ShotInfo);
+	}
+}
+
+bool AShooterWeapon_Instant::ServerNotifyPellets_Validate(const FInstantPelletBatch& Batch)
+{
+	return Batch.NumPellets <= GetPelletsPerShot();
+}
+
+void AShooterWeapon_Instant::ServerNotifyPellets_Implementation(const FInstantPelletBatch& Batch)
+{
+	const FVector Origin = GetMuzzleLocation();
+
+	// play FX on remote clients, they regenerate every pellet from the shot
+	HitNotify = Batch.Shot;
+
+	// same cone the client drew, so ballistic pellets can be rebuilt exactly
+	FRandomStream WeaponRandomStream = GetShotRandomStream(Batch.Shot);
+
+	int32 HitIndex = 0;
+	for (int32 PelletIndex = 0; PelletIndex < Batch.NumPellets; PelletIndex++)
+	{
+		const FVector ShootDir = GetShotDirection(WeaponRandomStream, Batch.Shot);
+
+		if (Batch.HitMask & (1u << PelletIndex))
+		{
+			const FHitResult Impact = Batch.MakeHitResult(HitIndex++, InstantConfig.WeaponRange);
+			ServerConfirmHit(Impact, ShootDir, Batch.Shot, Batch.ClientTimestamp);
+		}
+		else if (GetNetMode() != NM_DedicatedServer)
+		{
+			SpawnTrailEffect(Origin + ShootDir * InstantConfig.WeaponRange);
+		}
+	}
+}
+
+void AShooterWeapon_Instant::ServerNotifyHit_Implementation(const FHitResult& Impact, FInstantHitInfo ShotInfo, float ClientTimestamp)
+{
+	FRandomStream WeaponRandomStream = GetShotRandomStream(ShotInfo);
+	const FVector ShootDir = GetShotDirection(WeaponRandomStream, ShotInfo);
+
+	ServerConfirmHit(Impact, ShootDir, ShotInfo, ClientTimestamp);
+}
+
+void AShooterWeapon_Instant::ServerConfirmHit(const FHitResult& Impact, const FVector& ShootDir, const FInstantHitInfo& ShotInfo, float ClientTimestamp)
+{
+	const float WeaponAngleDot = FMath::Abs(FMath::Sin(ShotInfo.GetReticleSpread() * PI / 180.f));
 
 	// if we have an instigator, calculate dot between the view and the shot
 	if (GetInstigator() && (Impact.GetActor() || Impact.bBlockingHit))
 	{
 		const FVector Origin = GetMuzzleLocation();
-		const FVector ViewDir = (Impact.Location - Origin).GetSafeNormal();
+
+		// ballistic shots bend away from the line to the impact, so check the direction they were fired in instead
+		const FVector ViewDir = InstantConfig.bBallistic ? ShootDir : (Impact.Location - Origin).GetSafeNormal();
 
 		// is the angle between the hit and the view within allowed limits (limit + weapon max angle)
 		const float ViewDotHitDir = FVector::DotProduct(GetInstigator()->GetViewRotation().Vector(), ViewDir);
+
+		// characters take the bone from our own rewound trace, not the client's word
+		FHitResult ConfirmedImpact = Impact;
+
+		EHitRegDecision::Type Decision = EHitRegDecision::RejectedNotFiring;
 		if (ViewDotHitDir > InstantConfig.AllowedViewDotHitDir - WeaponAngleDot)
 		{
 			if (CurrentState != EWeaponState::Idle)
 			{
-				if (Impact.GetActor() == NULL)
-				{
-					if (Impact.bBlockingHit)
-					{
-						ProcessInstantHit_Confirmed(Impact, Origin, ShootDir, RandomSeed, ReticleSpread);
-					}
-				}
 				// assume it told the truth about static things because the don't move and the hit 
 				// usually doesn't have significant gameplay implications
-				else if (Impact.GetActor()->IsRootComponentStatic() || Impact.GetActor()->IsRootComponentStationary())
+				if (Impact.GetActor() == NULL || Impact.GetActor()->IsRootComponentStatic() || Impact.GetActor()->IsRootComponentStationary())
+				{
+					Decision = EHitRegDecision::Trusted;
+				}
+				// characters keep a history, so check against where the client actually saw them
+				else if (const ULagCompensationComponent* LagCompensation = Impact.GetActor()->FindComponentByClass<ULagCompensationComponent>())
 				{
-					ProcessInstantHit_Confirmed(Impact, Origin, ShootDir, RandomSeed, ReticleSpread);
+					Decision = ConfirmRewoundHit(Impact, ShootDir, LagCompensation, ClientTimestamp, ConfirmedImpact.BoneName) ? EHitRegDecision::ConfirmedRewind : EHitRegDecision::RejectedRewind;
 				}
 				else
 				{
@@ -87,49 +356,190 @@ void AShooterWeapon_Instant::ServerNotifyHit_Implementation(const FHitResult& Im
 						FMath::Abs(Impact.Location.X - BoxCenter.X) < BoxExtent.X &&
 						FMath::Abs(Impact.Location.Y - BoxCenter.Y) < BoxExtent.Y)
 					{
-						ProcessInstantHit_Confirmed(Impact, Origin, ShootDir, RandomSeed, ReticleSpread);
+						Decision = EHitRegDecision::ConfirmedBounds;
 					}
 					else
 					{
-						UE_LOG(LogShooterWeapon, Log, TEXT("%s Rejected client side hit of %s (outside bounding box tolerance)"), *GetNameSafe(this), *GetNameSafe(Impact.GetActor()));
+						Decision = EHitRegDecision::RejectedBounds;
 					}
 				}
 			}
 		}
 		else if (ViewDotHitDir <= InstantConfig.AllowedViewDotHitDir)
 		{
-			UE_LOG(LogShooterWeapon, Log, TEXT("%s Rejected client side hit of %s (facing too far from the hit direction)"), *GetNameSafe(this), *GetNameSafe(Impact.GetActor()));
+			Decision = EHitRegDecision::RejectedViewAngle;
 		}
 		else
 		{
-			UE_LOG(LogShooterWeapon, Log, TEXT("%s Rejected client side hit of %s"), *GetNameSafe(this), *GetNameSafe(Impact.GetActor()));
+			Decision = EHitRegDecision::RejectedSpread;
+		}
+
+		if (!EHitRegDecision::IsRejected(Decision))
+		{
+			ProcessInstantHit_Confirmed(ConfirmedImpact, Origin, ShootDir, ShotInfo);
 		}
+		else if (Decision != EHitRegDecision::RejectedNotFiring)
+		{
+			UE_LOG(LogShooterWeapon, Verbose, TEXT("%s Rejected client side hit of %s (%s)"), *GetNameSafe(this), *GetNameSafe(Impact.GetActor()), EHitRegDecision::ToString(Decision));
+		}
+
+		RecordHitReg(Impact, Origin, ShotInfo, ClientTimestamp, ViewDotHitDir, Decision);
 	}
 }
 
-bool AShooterWeapon_Instant::ServerNotifyMiss_Validate(FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::RecordHitReg(const FHitResult& Impact, const FVector& Origin, const FInstantHitInfo& ShotInfo, float ClientTimestamp, float ViewDotHitDir, EHitRegDecision::Type Decision) const
+{
+	UShooterHitRegLogSubsystem* HitRegLog = GetWorld()->GetSubsystem<UShooterHitRegLogSubsystem>();
+	if (HitRegLog == nullptr)
+	{
+		return;
+	}
+
+	const APawn* TargetPawn = Cast<APawn>(Impact.GetActor());
+	const APlayerState* ShooterPlayerState = GetInstigator()->GetPlayerState();
+	const APlayerState* TargetPlayerState = TargetPawn ? TargetPawn->GetPlayerState() : nullptr;
+
+	FShooterHitRegRecord Record;
+	Record.ServerTime = GetWorld()->GetTimeSeconds();
+	Record.ClientTimestamp = ClientTimestamp;
+	Record.RewindDelta = Record.ServerTime - ClientTimestamp;
+	Record.ShooterId = ShooterPlayerState ? ShooterPlayerState->GetPlayerId() : INDEX_NONE;
+	Record.TargetId = TargetPlayerState ? TargetPlayerState->GetPlayerId() : INDEX_NONE;
+	Record.ShotDistance = FVector::Dist(Origin, Impact.ImpactPoint);
+	Record.TraceStartError = FVector::Dist(Impact.TraceStart, GetInstigator()->GetPawnViewLocation());
+	Record.ViewDotHitDir = ViewDotHitDir;
+	Record.ShotIndex = ShotInfo.ShotIndex;
+	Record.Decision = Decision;
+
+	HitRegLog->AddRecord(GetClass(), Record);
+}
+
+bool AShooterWeapon_Instant::ConfirmRewoundHit(const FHitResult& Impact, const FVector& ShootDir, const ULagCompensationComponent* LagCompensation, float ClientTimestamp, FName& OutBoneName) const
+{
+	// the rewound trace uses the client's start point, so it has to be about where the server has the shooter's eyes
+	if (FVector::DistSquared(Impact.TraceStart, GetInstigator()->GetPawnViewLocation()) > FMath::Square(InstantConfig.MaxTraceStartError))
+	{
+		return false;
+	}
+
+	// never further back than MaxRewindTime, whatever the client claims
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double RewindTime = FMath::Clamp<double>(ClientTimestamp, Now - InstantConfig.MaxRewindTime, Now);
+
+	// the direction is our own seeded one, never the client's trace end, so a hit can't be steered onto a target off the line of fire.
+	// ballistic shots are re-traced along the segment of our own copy of the path that the impact is on
+	FVector RewindStart = Impact.TraceStart;
+	FVector RewindEnd = Impact.TraceStart + ShootDir * InstantConfig.WeaponRange;
+	if (InstantConfig.bBallistic && !FindBallisticSegment(Impact.TraceStart, ShootDir, Impact.ImpactPoint, RewindStart, RewindEnd))
+	{
+		return false;
+	}
+
+	FVector RewoundHitLocation;
+	return LagCompensation->RewindTrace(RewindTime, RewindStart, RewindEnd, InstantConfig.RewindHitLeeway, RewoundHitLocation, OutBoneName);
+}
+
+FHitResult AShooterWeapon_Instant::InstantTrace(const FVector& StartTrace, const FVector& ShootDir) const
+{
+	if (!InstantConfig.bBallistic)
+	{
+		return WeaponTrace(StartTrace, StartTrace + ShootDir * InstantConfig.WeaponRange);
+	}
+
+	TArray<FVector> Path;
+	GetBallisticPath(StartTrace, ShootDir, Path);
+
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(WeaponTrace), true, GetInstigator());
+	TraceParams.bReturnPhysicalMaterial = true;
+
+	FHitResult Hit(ForceInit);
+	for (int32 PointIndex = 1; PointIndex < Path.Num(); PointIndex++)
+	{
+		if (GetWorld()->LineTraceSingleByChannel(Hit, Path[PointIndex - 1], Path[PointIndex], COLLISION_WEAPON, TraceParams))
+		{
+			break;
+		}
+	}
+
+	Hit.TraceStart = StartTrace;
+	if (!Hit.bBlockingHit)
+	{
+		Hit.TraceEnd = Path.Last();
+	}
+
+	return Hit;
+}
+
+void AShooterWeapon_Instant::GetBallisticPath(const FVector& StartTrace, const FVector& ShootDir, TArray<FVector>& OutPath) const
+{
+	const UGravityFieldSubsystem* GravityFields = GetWorld()->GetSubsystem<UGravityFieldSubsystem>();
+	if (GravityFields)
+	{
+		const int32 MaxSegments = FMath::Clamp(InstantConfig.MaxBallisticSegments, 1, 64);
+		GravityFields->ComputeBallisticPath(StartTrace, ShootDir * InstantConfig.BallisticSpeed, InstantConfig.WeaponRange, MaxSegments, OutPath);
+	}
+	else
+	{
+		OutPath.Reset();
+		OutPath.Add(StartTrace);
+		OutPath.Add(StartTrace + ShootDir * InstantConfig.WeaponRange);
+	}
+}
+
+bool AShooterWeapon_Instant::FindBallisticSegment(const FVector& StartTrace, const FVector& ShootDir, const FVector& ImpactPoint, FVector& OutSegmentStart, FVector& OutSegmentEnd) const
+{
+	TArray<FVector> Path;
+	GetBallisticPath(StartTrace, ShootDir, Path);
+
+	float BestDistSq = FMath::Square(InstantConfig.BallisticHitTolerance);
+	bool bFound = false;
+
+	for (int32 PointIndex = 1; PointIndex < Path.Num(); PointIndex++)
+	{
+		const FVector ClosestPoint = FMath::ClosestPointOnSegment(ImpactPoint, Path[PointIndex - 1], Path[PointIndex]);
+		const float DistSq = FVector::DistSquared(ClosestPoint, ImpactPoint);
+		if (DistSq <= BestDistSq)
+		{
+			BestDistSq = DistSq;
+			OutSegmentStart = Path[PointIndex - 1];
+			OutSegmentEnd = Path[PointIndex];
+			bFound = true;
+		}
+	}
+
+	return bFound;
+}
+
+float AShooterWeapon_Instant::GetClientHitTimestamp() const
+{
+	// a client's estimate of server time trails the server by the trip the replicated time took, as do the characters it sees
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+bool AShooterWeapon_Instant::ServerNotifyMiss_Validate(FInstantHitInfo ShotInfo)
 {
 	return true;
 }
 
-void AShooterWeapon_Instant::ServerNotifyMiss_Implementation(FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::ServerNotifyMiss_Implementation(FInstantHitInfo ShotInfo)
 {
 	const FVector Origin = GetMuzzleLocation();
 
 	// play FX on remote clients
-	HitNotify.Origin = Origin;
-	HitNotify.RandomSeed = RandomSeed;
-	HitNotify.ReticleSpread = ReticleSpread;
+	HitNotify = ShotInfo;
 
 	// play FX locally
 	if (GetNetMode() != NM_DedicatedServer)
 	{
+		FRandomStream WeaponRandomStream = GetShotRandomStream(ShotInfo);
+		const FVector ShootDir = GetShotDirection(WeaponRandomStream, ShotInfo);
 		const FVector EndTrace = Origin + ShootDir * InstantConfig.WeaponRange;
 		SpawnTrailEffect(EndTrace);
 	}
 }
 
-void AShooterWeapon_Instant::ProcessInstantHit(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::ProcessInstantHit(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, const FInstantHitInfo& ShotInfo)
 {
 	if (MyPawn && MyPawn->IsLocallyControlled() && GetNetMode() == NM_Client)
 	{
@@ -137,28 +547,28 @@ void AShooterWeapon_Instant::ProcessInstantHit(const FHitResult& Impact, const F
 		if (Impact.GetActor() && Impact.GetActor()->GetRemoteRole() == ROLE_Authority)
 		{
 			// notify the server of the hit
-			ServerNotifyHit(Impact, ShootDir, RandomSeed, ReticleSpread);
+			ServerNotifyHit(Impact, ShotInfo, GetClientHitTimestamp());
 		}
 		else if (Impact.GetActor() == NULL)
 		{
 			if (Impact.bBlockingHit)
 			{
 				// notify the server of the hit
-				ServerNotifyHit(Impact, ShootDir, RandomSeed, ReticleSpread);
+				ServerNotifyHit(Impact, ShotInfo, GetClientHitTimestamp());
 			}
 			else
 			{
 				// notify server of the miss
-				ServerNotifyMiss(ShootDir, RandomSeed, ReticleSpread);
+				ServerNotifyMiss(ShotInfo);
 			}
 		}
 	}
 
 	// process a confirmed hit
-	ProcessInstantHit_Confirmed(Impact, Origin, ShootDir, RandomSeed, ReticleSpread);
+	ProcessInstantHit_Confirmed(Impact, Origin, ShootDir, ShotInfo);
 }
 
-void AShooterWeapon_Instant::ProcessInstantHit_Confirmed(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::ProcessInstantHit_Confirmed(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, const FInstantHitInfo& ShotInfo)
 {
 	// handle damage
 	if (ShouldDealDamage(Impact.GetActor()))
@@ -169,15 +579,13 @@ void AShooterWeapon_Instant::ProcessInstantHit_Confirmed(const FHitResult& Impac
 	// play FX on remote clients
 	if (GetLocalRole() == ROLE_Authority)
 	{
-		HitNotify.Origin = Origin;
-		HitNotify.RandomSeed = RandomSeed;
-		HitNotify.ReticleSpread = ReticleSpread;
+		HitNotify = ShotInfo;
 	}
 
 	// play FX locally
 	if (GetNetMode() != NM_DedicatedServer)
 	{
-		const FVector EndTrace = Origin + ShootDir * InstantConfig.WeaponRange;
+		const FVector EndTrace = InstantConfig.bBallistic ? Impact.TraceEnd : Origin + ShootDir * InstantConfig.WeaponRange;
 		const FVector EndPoint = Impact.GetActor() ? Impact.ImpactPoint : EndTrace;
 
 		SpawnTrailEffect(EndPoint);
@@ -209,9 +617,26 @@ void AShooterWeapon_Instant::DealDamage(const FHitResult& Impact, const FVector&
 	PointDmg.ShotDirection = ShootDir;
 	PointDmg.Damage = InstantConfig.HitDamage;
 
+	// scale by the hitbox the bone belongs to, the bone comes from a trace against the physics asset or the server's rewound hitboxes
+	if (const ULagCompensationComponent* Hitboxes = Impact.GetActor()->FindComponentByClass<ULagCompensationComponent>())
+	{
+		PointDmg.Damage *= GetHitboxDamageMultiplier(Hitboxes->GetHitboxRegion(Impact.BoneName));
+	}
+
 	Impact.GetActor()->TakeDamage(PointDmg.Damage, PointDmg, MyPawn->Controller, this);
 }
 
+float AShooterWeapon_Instant::GetHitboxDamageMultiplier(ECircuitHitboxRegion::Type Region) const
+{
+	switch (Region)
+	{
+		case ECircuitHitboxRegion::Head:	return InstantConfig.HeadDamageMultiplier;
+		case ECircuitHitboxRegion::Arm:		return InstantConfig.ArmDamageMultiplier;
+		case ECircuitHitboxRegion::Leg:		return InstantConfig.LegDamageMultiplier;
+		default:							return InstantConfig.TorsoDamageMultiplier;
+	}
+}
+
 void AShooterWeapon_Instant::OnBurstFinished()
 {
 	Super::OnBurstFinished();
@@ -234,34 +659,42 @@ float AShooterWeapon_Instant::GetCurrentSpread() const
 	return FinalSpread;
 }
 
+int32 AShooterWeapon_Instant::GetPelletsPerShot() const
+{
+	return FMath::Clamp(InstantConfig.PelletsPerShot, 1, FInstantPelletBatch::MaxPellets);
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 // Replication & effects
 
 void AShooterWeapon_Instant::OnRep_HitNotify()
 {
-	SimulateInstantHit(HitNotify.Origin, HitNotify.RandomSeed, HitNotify.ReticleSpread);
+	SimulateInstantHit(HitNotify);
 }
 
-void AShooterWeapon_Instant::SimulateInstantHit(const FVector& ShotOrigin, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::SimulateInstantHit(const FInstantHitInfo& ShotInfo)
 {
-	FRandomStream WeaponRandomStream(RandomSeed);
-	const float ConeHalfAngle = FMath::DegreesToRadians(ReticleSpread * 0.5f);
+	FRandomStream WeaponRandomStream = GetShotRandomStream(ShotInfo);
 
-	const FVector StartTrace = ShotOrigin;
-	const FVector AimDir = GetAdjustedAim();
-	const FVector ShootDir = WeaponRandomStream.VRandCone(AimDir, ConeHalfAngle, ConeHalfAngle);
-	const FVector EndTrace = StartTrace + ShootDir * InstantConfig.WeaponRange;
+	// the shot's directions are exact, only the start is our own copy of the muzzle
+	const FVector StartTrace = GetMuzzleLocation();
+	const int32 NumPellets = GetPelletsPerShot();
 
-	FHitResult Impact = WeaponTrace(StartTrace, EndTrace);
-	if (Impact.bBlockingHit)
+	for (int32 PelletIndex = 0; PelletIndex < NumPellets; PelletIndex++)
 	{
-		SpawnImpactEffects(Impact);
-		SpawnTrailEffect(Impact.ImpactPoint);
-	}
-	else
-	{
-		SpawnTrailEffect(EndTrace);
+		const FVector ShootDir = GetShotDirection(WeaponRandomStream, ShotInfo);
+
+		FHitResult Impact = InstantTrace(StartTrace, ShootDir);
+		if (Impact.bBlockingHit)
+		{
+			SpawnImpactEffects(Impact);
+			SpawnTrailEffect(Impact.ImpactPoint);
+		}
+		else
+		{
+			SpawnTrailEffect(InstantConfig.bBallistic ? Impact.TraceEnd : StartTrace + ShootDir * InstantConfig.WeaponRange);
+		}
 	}
 }
 
@@ -281,11 +714,19 @@ void AShooterWeapon_Instant::SpawnImpactEffects(const FHitResult& Impact)
 		}
 
 		FTransform const SpawnTransform(Impact.ImpactNormal.Rotation(), Impact.ImpactPoint);
-		AShooterImpactEffect* EffectActor = GetWorld()->SpawnActorDeferred<AShooterImpactEffect>(ImpactTemplate, SpawnTransform);
-		if (EffectActor)
+		UShooterEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UShooterEffectPoolSubsystem>();
+		if (EffectPool)
+		{
+			EffectPool->SpawnImpactEffect(ImpactTemplate, SpawnTransform, UseImpact);
+		}
+		else
 		{
-			EffectActor->SurfaceHit = UseImpact;
-			UGameplayStatics::FinishSpawningActor(EffectActor, SpawnTransform);
+			AShooterImpactEffect* EffectActor = GetWorld()->SpawnActorDeferred<AShooterImpactEffect>(ImpactTemplate, SpawnTransform);
+			if (EffectActor)
+			{
+				EffectActor->SurfaceHit = UseImpact;
+				UGameplayStatics::FinishSpawningActor(EffectActor, SpawnTransform);
+			}
 		}
 	}
 }
@@ -296,7 +737,8 @@ void AShooterWeapon_Instant::SpawnTrailEffect(const FVector& EndPoint)
 	{
 		const FVector Origin = GetMuzzleLocation();
 
-		UParticleSystemComponent* TrailPSC = UGameplayStatics::SpawnEmitterAtLocation(this, TrailFX, Origin);
+		// pooled by the world, trails are the most frequently spawned effect
+		UParticleSystemComponent* TrailPSC = UGameplayStatics::SpawnEmitterAtLocation(this, TrailFX, Origin, FRotator::ZeroRotator, FVector(1.0f), true, EPSCPoolMethod::AutoRelease);
 		if (TrailPSC)
 		{
 			TrailPSC->SetVectorParameter(TrailTargetParam, EndPoint);
@@ -309,4 +751,5 @@ void AShooterWeapon_Instant::GetLifetimeReplicatedProps( TArray< FLifetimeProper
 	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
 
 	DOREPLIFETIME_CONDITION( AShooterWeapon_Instant, HitNotify, COND_SkipOwner );
+	DOREPLIFETIME_CONDITION( AShooterWeapon_Instant, ShotSeedBase, COND_InitialOnly );
 }
\ No newline at end of file
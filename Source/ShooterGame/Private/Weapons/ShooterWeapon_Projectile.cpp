@@ -3,6 +3,7 @@
 #include "ShooterGame.h"
 #include "Weapons/ShooterWeapon_Projectile.h"
 #include "Weapons/ShooterProjectile.h"
+#include "Weapons/ShooterProjectileManager.h"
 
 AShooterWeapon_Projectile::AShooterWeapon_Projectile(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -61,6 +62,12 @@ void AShooterWeapon_Projectile::FireWeapon()
 		}
 	}
 
+	// managed projectiles are cheap enough to predict, the multicast skips us
+	if (GetLocalRole() < ROLE_Authority)
+	{
+		SpawnManagedProjectile(Origin, ShootDir, 0.0f);
+	}
+
 	ServerFireProjectile(Origin, ShootDir);
 }
 
@@ -71,6 +78,15 @@ bool AShooterWeapon_Projectile::ServerFireProjectile_Validate(FVector Origin, FV
 
 void AShooterWeapon_Projectile::ServerFireProjectile_Implementation(FVector Origin, FVector_NetQuantizeNormal ShootDir)
 {
+	if (SpawnManagedProjectile(Origin, ShootDir, 0.0f))
+	{
+		FShooterProjectileSpawn Spawn;
+		Spawn.Origin = Origin;
+		Spawn.Direction = ShootDir;
+		MulticastSpawnProjectile(Spawn);
+		return;
+	}
+
 	FTransform SpawnTM(ShootDir.Rotation(), Origin);
 	AShooterProjectile* Projectile = Cast<AShooterProjectile>(UGameplayStatics::BeginDeferredActorSpawnFromClass(this, ProjectileConfig.ProjectileClass, SpawnTM));
 	if (Projectile)
@@ -83,6 +99,45 @@ void AShooterWeapon_Projectile::ServerFireProjectile_Implementation(FVector Orig
 	}
 }
 
+void AShooterWeapon_Projectile::MulticastSpawnProjectile_Implementation(FShooterProjectileSpawn Spawn)
+{
+	// the server already has it, and the shooter predicted it
+	if (GetLocalRole() == ROLE_Authority || (MyPawn && MyPawn->IsLocallyControlled()))
+	{
+		return;
+	}
+
+	// start it where the server's copy is by now, which is roughly one way trip behind (ExactPing is the round trip in ms)
+	const APlayerController* LocalPC = GetWorld()->GetFirstPlayerController();
+	const APlayerState* LocalPlayerState = LocalPC ? LocalPC->PlayerState : nullptr;
+	const float ElapsedTime = LocalPlayerState ? FMath::Clamp(LocalPlayerState->ExactPing * 0.0005f, 0.0f, 0.25f) : 0.0f;
+
+	SpawnManagedProjectile(Spawn.Origin, Spawn.Direction, ElapsedTime);
+}
+
+bool AShooterWeapon_Projectile::SpawnManagedProjectile(const FVector& Origin, const FVector& ShootDir, float ElapsedTime)
+{
+	if (!ProjectileConfig.bUseProjectileManager)
+	{
+		return false;
+	}
+
+	UShooterProjectileManager* ProjectileManager = GetWorld()->GetSubsystem<UShooterProjectileManager>();
+	if (ProjectileManager == nullptr)
+	{
+		return false;
+	}
+
+	const int32 TypeIndex = ProjectileManager->GetProjectileType(this);
+	if (TypeIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	ProjectileManager->SpawnProjectile(TypeIndex, this, Origin, ShootDir, ElapsedTime, GetLocalRole() == ROLE_Authority);
+	return true;
+}
+
 void AShooterWeapon_Projectile::ApplyWeaponConfig(FProjectileWeaponData& Data)
 {
 	Data = ProjectileConfig;
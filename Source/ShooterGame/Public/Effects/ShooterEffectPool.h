@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ShooterTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterEffectPool.generated.h"
+
+class AShooterImpactEffect;
+class AShooterExplosionEffect;
+class UDecalComponent;
+
+struct FShooterPooledEffect
+{
+	TWeakObjectPtr<AActor> Effect;
+
+	/** world time the pool takes it back, 0 if the effect releases itself */
+	double ReleaseTime = 0.0;
+};
+
+struct FShooterEffectClassPool
+{
+	TArray<TWeakObjectPtr<AActor>> Free;
+
+	/** in activation order, so the front is the least recently used */
+	TArray<FShooterPooledEffect> Active;
+};
+
+struct FShooterPooledDecal
+{
+	TWeakObjectPtr<UDecalComponent> Decal;
+
+	/** world time the decal is hidden again, 0 if it stays until reused */
+	double ReleaseTime = 0.0;
+};
+
+//
+// Per world pool for weapon impact and explosion effect actors and their decals.
+// Effects are hidden and kept instead of destroyed, and handed out again for the next hit; when a class reaches
+// ShooterEffectPool.MaxActorsPerClass (or decals reach ShooterEffectPool.MaxDecals) the oldest active one is reused.
+// Particle systems go through the engine's own component pool (EPSCPoolMethod::AutoRelease).
+//
+UCLASS()
+class UShooterEffectPoolSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** place an impact effect at SpawnTransform and play it for SurfaceHit */
+	AShooterImpactEffect* SpawnImpactEffect(TSubclassOf<AShooterImpactEffect> Template, const FTransform& SpawnTransform, const FHitResult& SurfaceHit);
+
+	/** place an explosion effect at SpawnTransform and play it for SurfaceHit, it hands itself back through ReleaseEffect once the light has faded */
+	AShooterExplosionEffect* SpawnExplosionEffect(TSubclassOf<AShooterExplosionEffect> Template, const FTransform& SpawnTransform, const FHitResult& SurfaceHit);
+
+	/** decal on the hit surface, follows it if it moves */
+	UDecalComponent* SpawnDecal(const FDecalData& Decal, const FVector& DecalSize, const FHitResult& SurfaceHit, const FRotator& Rotation);
+
+	/** make sure ShooterEffectPool.PrewarmCount hidden instances of Template are ready, so the first shots in a fight don't spawn */
+	void Prewarm(TSubclassOf<AActor> Template);
+
+	/** return an effect to its pool, false if it didn't come from one */
+	bool ReleaseEffect(AActor* Effect);
+
+private:
+
+	/** free instance of Template (or the least recently used one if the class is at its cap), moved to SpawnTransform and active */
+	AActor* AcquireEffect(UClass* Template, const FTransform& SpawnTransform, double ReleaseTime);
+
+	AActor* SpawnPooledEffect(UClass* Template, const FTransform& SpawnTransform);
+
+	void DeactivateEffect(AActor* Effect);
+
+	void ReleaseDecal(UDecalComponent* Decal);
+
+	TMap<TWeakObjectPtr<UClass>, FShooterEffectClassPool> ClassPools;
+
+	/** every decal component the pool made, nothing else references them */
+	UPROPERTY(Transient)
+	TArray<UDecalComponent*> PooledDecals;
+
+	TArray<TWeakObjectPtr<UDecalComponent>> FreeDecals;
+
+	/** in activation order, so the front is the least recently used */
+	TArray<FShooterPooledDecal> ActiveDecals;
+};
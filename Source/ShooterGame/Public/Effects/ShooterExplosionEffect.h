@@ -40,15 +40,24 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category=Surface)
 	FHitResult SurfaceHit;
 
+	/** set by UShooterEffectPoolSubsystem before spawning finishes, it plays pooled effects itself */
+	bool bPooledEffect;
+
 	/** update fading light */
 	virtual void Tick(float DeltaSeconds) override;
 
+	/** play particles, sound and decal for SurfaceHit and start the light fading */
+	void PlayExplosion();
+
 protected:
 	/** spawn explosion */
 	virtual void BeginPlay() override;
 
 private:
 
+	/** world time PlayExplosion was last called */
+	float ExplosionStartTime;
+
 	/** Point light component name */
 	FName ExplosionLightComponentName;
 
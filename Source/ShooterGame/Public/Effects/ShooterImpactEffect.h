@@ -94,9 +94,15 @@ class AShooterImpactEffect : public AActor
 	UPROPERTY(BlueprintReadOnly, Category=Surface)
 	FHitResult SurfaceHit;
 
+	/** set by UShooterEffectPoolSubsystem before spawning finishes, it plays pooled effects itself */
+	bool bPooledEffect;
+
 	/** spawn effect */
 	virtual void PostInitializeComponents() override;
 
+	/** play particles, sound and decal for SurfaceHit */
+	void PlayImpact();
+
 protected:
 
 	/** get FX for material type */
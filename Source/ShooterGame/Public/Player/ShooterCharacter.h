@@ -493,6 +493,19 @@ protected:
 	/** Builds list of points to check for pausing replication for a connection*/
 	void BuildPauseReplicationCheckPoints(TArray<FVector>& RelevancyCheckPoints);
 
+	/** Last line of sight result for one viewer, reused for a few frames (p.NetPauseRelevancyCache*) */
+	struct FPauseRelevancyCacheEntry
+	{
+		uint64 ValidUntilFrame = 0;
+		FVector ViewLocation = FVector::ZeroVector;
+		FVector ActorLocation = FVector::ZeroVector;
+		/** Check point that was visible last time, tested first */
+		int32 LastVisiblePoint = 0;
+		bool bPaused = false;
+	};
+
+	TMap<TWeakObjectPtr<APlayerController>, FPauseRelevancyCacheEntry> PauseRelevancyCache;
+
 protected:
 	/** Returns Mesh1P subobject **/
 	FORCEINLINE USkeletalMeshComponent* GetMesh1P() const { return Mesh1P; }
@@ -0,0 +1,48 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#pragma once
+
+#include "Tests/ShooterTestControllerBase.h"
+#include "ShooterTestControllerNetEmulation.generated.h"
+
+/**
+ * Runs on the dedicated server while clients play (e.g. with ShooterTestControllerDedicatedServerTest).
+ * Once a client is in, applies packet loss/lag and a low net speed to every client connection and checks the replication graph
+ * backs them off (ShooterRepGraph.Adaptive.*), then removes the emulation and checks they recover.
+ *
+ * Command line: -NetEmuLoss=<percent> -NetEmuLag=<ms> -NetEmuSpeed=<bytes/s> -NetEmuPhaseTime=<seconds>
+ */
+UCLASS()
+class UShooterTestControllerNetEmulation : public UShooterTestControllerBase
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnInit() override;
+	virtual void OnPostMapChange(UWorld* World) override;
+
+protected:
+	virtual void OnTick(float TimeDelta) override;
+
+	enum class EPhase : uint8
+	{
+		WaitingForClient,
+		Degraded,
+		Recovering
+	};
+
+	void ApplyEmulation(bool bEnable);
+
+	/** Highest adaptive level over all client connections */
+	int32 GetMaxAdaptiveLevel() const;
+
+	EPhase Phase;
+	float PhaseTime;
+
+	int32 PktLoss;
+	int32 PktLag;
+	int32 LowNetSpeed;
+	float MaxPhaseTime;
+
+	/** CurrentNetSpeed of each connection before it was throttled */
+	TMap<TWeakObjectPtr<UNetConnection>, int32> SavedNetSpeeds;
+};
@@ -0,0 +1,153 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ShooterTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterHitRegLog.generated.h"
+
+class IFileHandle;
+
+/** what AShooterWeapon_Instant::ServerConfirmHit made of a client side hit */
+namespace EHitRegDecision
+{
+	enum Type
+	{
+		/** world geometry or static actors, taken as reported */
+		Trusted,
+		ConfirmedRewind,
+		ConfirmedBounds,
+		RejectedRewind,
+		RejectedBounds,
+		/** view too far from the hit direction */
+		RejectedViewAngle,
+		/** view off the hit direction by more than the weapon's spread allows */
+		RejectedSpread,
+		/** weapon wasn't firing on the server */
+		RejectedNotFiring,
+		MAX,
+	};
+
+	const TCHAR* ToString(Type Decision);
+
+	inline bool IsRejected(Type Decision)
+	{
+		return Decision >= RejectedRewind;
+	}
+}
+
+/** one client side hit checked by the server, fixed size on disk (see FShooterHitRegLogFile::RecordSize) */
+struct FShooterHitRegRecord
+{
+	/** server world time the hit was checked at */
+	float ServerTime = 0.0f;
+
+	/** when the client says it fired, in server time */
+	float ClientTimestamp = 0.0f;
+
+	/** how far back the hit had to be rewound, ServerTime - ClientTimestamp */
+	float RewindDelta = 0.0f;
+
+	/** player ids, INDEX_NONE when the target isn't a player */
+	int32 ShooterId = INDEX_NONE;
+	int32 TargetId = INDEX_NONE;
+
+	/** muzzle to impact */
+	float ShotDistance = 0.0f;
+
+	/** client trace start to where the server has the shooter's eyes */
+	float TraceStartError = 0.0f;
+
+	float ViewDotHitDir = 0.0f;
+
+	uint16 ShotIndex = 0;
+
+	/** into FShooterHitRegLogFile::WeaponNames */
+	uint8 WeaponIndex = 0;
+
+	/** EHitRegDecision */
+	uint8 Decision = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FShooterHitRegRecord& Record);
+};
+
+/**
+ * Layout of a hit registration log: a header padded to HeaderSize, then a ring of Capacity records of RecordSize bytes.
+ * Record N (counting from the first ever written) lives in slot N % Capacity, so once the ring wraps the file holds the latest Capacity hits.
+ */
+struct FShooterHitRegLogFile
+{
+	static const int32 HeaderSize = 4096;
+	static const int32 RecordSize = 36;
+
+	/** weapon classes past this, or past what fits in the header, are all logged as OtherWeaponIndex */
+	static const int32 MaxWeapons = 64;
+
+	/** WeaponNames[0] is always "Other" */
+	static const uint8 OtherWeaponIndex = 0;
+
+	static FString GetDirectory();
+
+	uint32 Capacity = 0;
+
+	/** records ever written, the ring holds the last Min(NumWritten, Capacity) */
+	uint64 NumWritten = 0;
+
+	TArray<FString> WeaponNames;
+
+	void SerializeHeader(FArchive& Ar);
+
+	/** read a whole log, records come out oldest first */
+	bool Load(const FString& Filename, TArray<FShooterHitRegRecord>& OutRecords);
+};
+
+//
+// Server side audit log of every client side hit AShooterWeapon_Instant checks, for tuning the leeway settings and spotting players with
+// unusual rejection rates (see UShooterHitRegReportCommandlet). Records are queued in memory and written to the ring in Saved/HitReg
+// every ShooterHitRegLog.FlushInterval seconds, so logging a hit costs a struct copy rather than a formatted log line.
+//
+UCLASS()
+class UShooterHitRegLogSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** queue a record, WeaponIndex is filled in from WeaponClass */
+	void AddRecord(const UClass* WeaponClass, FShooterHitRegRecord& Record);
+
+	/** write everything queued out to the ring */
+	void Flush();
+
+private:
+
+	/** creates the log on first use, false if logging is off or the file can't be written */
+	bool OpenLog();
+
+	/** header into WriteBuffer, returns its size */
+	int32 SerializeHeaderToBuffer();
+
+	void WriteHeader();
+
+	FShooterHitRegLogFile FileLayout;
+
+	TMap<FName, uint8> WeaponIndices;
+
+	TArray<FShooterHitRegRecord> PendingRecords;
+
+	/** scratch for serializing PendingRecords */
+	TArray<uint8> WriteBuffer;
+
+	IFileHandle* LogFile = nullptr;
+
+	bool bTriedOpen = false;
+
+	bool bWarnedWeaponsFull = false;
+
+	float TimeSinceFlush = 0.0f;
+};
@@ -25,6 +25,9 @@ class AShooterProjectile : public AActor
 	UFUNCTION()
 	void OnImpact(const FHitResult& HitResult);
 
+	/** fill in speed, collision and effects for UShooterProjectileManager, called on the class default object */
+	void InitManagedProjectileType(struct FShooterManagedProjectileType& Type) const;
+
 private:
 	/** movement component */
 	UPROPERTY(VisibleDefaultsOnly, Category=Projectile)
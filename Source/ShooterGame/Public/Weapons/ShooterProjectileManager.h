@@ -0,0 +1,125 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ShooterTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterProjectileManager.generated.h"
+
+class AShooterWeapon_Projectile;
+class AShooterExplosionEffect;
+
+/** everything needed to fly one weapon class's projectiles without an actor, see AShooterProjectile::InitManagedProjectileType */
+USTRUCT()
+struct FShooterManagedProjectileType
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+	TWeakObjectPtr<UClass> WeaponClass;
+
+	UPROPERTY()
+	float Speed = 0.0f;
+
+	UPROPERTY()
+	float CollisionRadius = 0.0f;
+
+	UPROPERTY()
+	float GravityScale = 0.0f;
+
+	UPROPERTY()
+	float Life = 0.0f;
+
+	UPROPERTY()
+	int32 ExplosionDamage = 0;
+
+	UPROPERTY()
+	float ExplosionRadius = 0.0f;
+
+	UPROPERTY()
+	TSubclassOf<UDamageType> DamageType;
+
+	UPROPERTY()
+	TSubclassOf<AShooterExplosionEffect> ExplosionTemplate;
+
+	UPROPERTY()
+	UParticleSystem* TrailFX = nullptr;
+};
+
+/** projectile spawn as multicast to everyone but the shooter, who predicted it */
+USTRUCT()
+struct FShooterProjectileSpawn
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize10 Origin;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction;
+
+	FShooterProjectileSpawn()
+		: Origin(ForceInitToZero)
+		, Direction(ForceInitToZero)
+	{
+	}
+};
+
+//
+// Flies projectiles of AShooterWeapon_Projectile weapons with ProjectileConfig.bUseProjectileManager as plain data instead of actors.
+// Projectiles live in parallel arrays (structure of arrays), are moved and swept in one pass per tick and only their spawn is replicated;
+// every machine then simulates them itself. The server's copy deals the damage, everyone else's is cosmetic.
+//
+UCLASS()
+class UShooterProjectileManager : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** type index for the weapon's class, added from its config the first time */
+	int32 GetProjectileType(AShooterWeapon_Projectile* Weapon);
+
+	/** start a projectile, already ElapsedTime seconds into its flight. bAuthority projectiles deal damage */
+	void SpawnProjectile(int32 TypeIndex, AShooterWeapon_Projectile* Weapon, const FVector& Origin, const FVector& Direction, float ElapsedTime, bool bAuthority);
+
+	int32 GetNumProjectiles() const { return Positions.Num(); }
+
+private:
+
+	/** move every projectile DeltaTime, exploding the ones that hit something and dropping expired ones */
+	void SimulateProjectiles(float DeltaTime);
+
+	/** move one projectile, true if it hit something */
+	bool SimulateProjectile(int32 Index, float DeltaTime, FCollisionQueryParams& QueryParams, const struct FGravityFieldQuery* GravityQuery, FHitResult& OutHit);
+
+	void ExplodeProjectile(int32 Index, const FHitResult& Impact);
+
+	void RemoveProjectile(int32 Index);
+
+	/** gather the world's gravity fields for a batch of moves, false (and OutQuery unused) if the subsystem is missing */
+	bool GatherGravityFields(struct FGravityFieldQuery& OutQuery) const;
+
+	/** referenced so the effects and classes the projectiles use stay loaded */
+	UPROPERTY(Transient)
+	TArray<FShooterManagedProjectileType> Types;
+
+	/** one entry per projectile in each array */
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> LifeRemaining;
+	TArray<int32> TypeIndices;
+	TArray<bool> Authority;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+	TArray<TWeakObjectPtr<AController>> InstigatorControllers;
+	TArray<TWeakObjectPtr<AActor>> DamageCausers;
+
+	/** pooled trail per projectile, null on dedicated servers */
+	UPROPERTY(Transient)
+	TArray<UParticleSystemComponent*> Trails;
+};
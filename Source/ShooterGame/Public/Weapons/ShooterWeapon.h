@@ -25,6 +25,75 @@ namespace EWeaponState
 	};
 }
 
+/** ammo counts, only the owner needs them. Both are small and never negative, so they're sent as packed ints (a byte each below 128) */
+USTRUCT()
+struct FShooterWeaponAmmoState
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** current total ammo */
+	UPROPERTY()
+	int32 CurrentAmmo;
+
+	/** current ammo - inside clip */
+	UPROPERTY()
+	int32 CurrentAmmoInClip;
+
+	FShooterWeaponAmmoState()
+		: CurrentAmmo(0)
+		, CurrentAmmoInClip(0)
+	{
+	}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterWeaponAmmoState> : public TStructOpsTypeTraitsBase2<FShooterWeaponAmmoState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/** what everyone but the owner needs to play the weapon: a reload flag and a burst counter, 2 bits while idle and 10 while firing */
+USTRUCT()
+struct FShooterWeaponFireState
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** burst counter, used for replicating fire events to remote clients. 0 while not firing, then counts 1-255 and wraps back to 1 */
+	UPROPERTY()
+	uint8 BurstCounter;
+
+	/** is reload animation playing? */
+	UPROPERTY()
+	uint8 bPendingReload : 1;
+
+	FShooterWeaponFireState()
+		: BurstCounter(0)
+		, bPendingReload(false)
+	{
+	}
+
+	void IncrementBurstCounter()
+	{
+		BurstCounter = (BurstCounter == MAX_uint8) ? 1 : BurstCounter + 1;
+	}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterWeaponFireState> : public TStructOpsTypeTraitsBase2<FShooterWeaponFireState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
 USTRUCT()
 struct FWeaponData
 {
@@ -252,11 +321,7 @@ class AShooterWeapon : public AActor
 	UPROPERTY(EditDefaultsOnly, Category=HUD)
 	bool bHideCrosshairWhileNotAiming;
 
-	/** Adjustment to handle frame rate affecting actual timer interval. */
-	UPROPERTY(Transient)
-	float TimerIntervalAdjustment;
-
-	/** Whether to allow automatic weapons to catch up with shorter refire cycles */
+	/** Whether to allow automatic weapons to catch up with shorter refire cycles, timing each shot from when the last one was due rather than when it fired */
 	UPROPERTY(Config)
 	bool bAllowAutomaticWeaponCatchup = true;
 
@@ -380,10 +445,6 @@ protected:
 	/** is weapon fire active? */
 	uint32 bWantsToFire : 1;
 
-	/** is reload animation playing? */
-	UPROPERTY(Transient, ReplicatedUsing=OnRep_Reload)
-	uint32 bPendingReload : 1;
-
 	/** is equip animation playing? */
 	uint32 bPendingEquip : 1;
 
@@ -394,7 +455,7 @@ protected:
 	EWeaponState::Type CurrentState;
 
 	/** time of last successful weapon fire */
-	float LastFireTime;
+	double LastFireTime;
 
 	/** last time when this weapon was switched to */
 	float EquipStartedTime;
@@ -402,17 +463,13 @@ protected:
 	/** how much time weapon needs to be equipped */
 	float EquipDuration;
 
-	/** current total ammo */
+	/** ammo, replicated to the owner */
 	UPROPERTY(Transient, Replicated)
-	int32 CurrentAmmo;
+	FShooterWeaponAmmoState AmmoState;
 
-	/** current ammo - inside clip */
-	UPROPERTY(Transient, Replicated)
-	int32 CurrentAmmoInClip;
-
-	/** burst counter, used for replicating fire events to remote clients */
-	UPROPERTY(Transient, ReplicatedUsing=OnRep_BurstCounter)
-	int32 BurstCounter;
+	/** burst counter and reload, replicated to everyone else */
+	UPROPERTY(Transient, ReplicatedUsing=OnRep_FireState)
+	FShooterWeaponFireState FireState;
 
 	/** Handle for efficient management of OnEquipFinished timer */
 	FTimerHandle TimerHandle_OnEquipFinished;
@@ -423,9 +480,6 @@ protected:
 	/** Handle for efficient management of ReloadWeapon timer */
 	FTimerHandle TimerHandle_ReloadWeapon;
 
-	/** Handle for efficient management of HandleFiring timer */
-	FTimerHandle TimerHandle_HandleFiring;
-
 	//////////////////////////////////////////////////////////////////////////
 	// Input - server side
 
@@ -449,9 +503,10 @@ protected:
 	void OnRep_MyPawn();
 
 	UFUNCTION()
+	void OnRep_FireState(const FShooterWeaponFireState& PreviousFireState);
+
 	void OnRep_BurstCounter();
 
-	UFUNCTION()
 	void OnRep_Reload();
 
 	/** Called in network play to do the cosmetic fx for firing */
@@ -471,11 +526,14 @@ protected:
 	UFUNCTION(reliable, server, WithValidation)
 	void ServerHandleFiring();
 
-	/** [local + server] handle weapon refire, compensating for slack time if the timer can't sample fast enough */
-	void HandleReFiring();
+	/** [local + server] handle weapon fire, FireTime is when the shot is due */
+	void HandleFiring(double FireTime);
+
+	/** [local + server] refire scheduled with UShooterWeaponScheduler, FireTime is when it was due which can be earlier this frame */
+	void HandleReFiring(double FireTime);
 
-	/** [local + server] handle weapon fire */
-	void HandleFiring();
+	/** calls HandleReFiring */
+	friend class UShooterWeaponScheduler;
 
 	/** [local + server] firing started */
 	virtual void OnBurstStarted();
@@ -0,0 +1,80 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ShooterTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterWeaponScheduler.generated.h"
+
+class AShooterWeapon;
+
+//
+// Refire timing for every AShooterWeapon in the world, in place of a FTimerManager timer per weapon.
+// Pending refires sit in a hashed timer wheel of fixed width slots and are all fired in one pass per tick, in order of due time
+// (ties in the order they were scheduled). Each refire keeps its exact due time, so a weapon scheduling its next shot from the
+// last one's due time rather than from the frame it actually fired in keeps its fire rate at any tick rate.
+//
+UCLASS()
+class UShooterWeaponScheduler : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** call Weapon->HandleReFiring at FireTime (world time), replacing its pending refire if it has one */
+	void ScheduleReFiring(AShooterWeapon* Weapon, double FireTime);
+
+	/** drop the weapon's pending refire */
+	void CancelReFiring(AShooterWeapon* Weapon);
+
+	bool IsReFiringScheduled(AShooterWeapon* Weapon) const;
+
+private:
+
+	struct FScheduledReFiring
+	{
+		TWeakObjectPtr<AShooterWeapon> Weapon;
+		double FireTime;
+		uint32 Sequence;
+
+		bool operator<(const FScheduledReFiring& Other) const
+		{
+			return FireTime < Other.FireTime || (FireTime == Other.FireTime && Sequence < Other.Sequence);
+		}
+	};
+
+	/** absolute slot the time falls in, never before the slot being processed so late refires still get picked up */
+	int64 GetSlot(double Time) const;
+
+	/** move everything due by Now out of the wheel into DueReFirings */
+	void CollectDueReFirings(double Now);
+
+	/** true if the entry is still the weapon's pending refire, cancelled and rescheduled ones are dropped lazily */
+	bool IsCurrent(const FScheduledReFiring& Entry) const;
+
+	/** the wheel, NumSlots buckets covering SlotTime each. Entries more than a turn away stay in their bucket until they're due */
+	TArray<TArray<FScheduledReFiring>> Slots;
+
+	/** sequence of each weapon's pending refire */
+	TMap<TWeakObjectPtr<AShooterWeapon>, uint32> PendingSequences;
+
+	/** due this tick, as a heap */
+	TArray<FScheduledReFiring> DueReFirings;
+
+	/** refires per weapon in the current pass, kept between ticks so it doesn't reallocate */
+	TMap<AShooterWeapon*, int32> ReFiresThisTick;
+
+	/** first slot not fully processed */
+	int64 CurrentSlot;
+
+	uint32 NextSequence;
+
+	/** set while Tick fires DueReFirings, refires already due then join the pass */
+	bool bFiringDueReFirings;
+};
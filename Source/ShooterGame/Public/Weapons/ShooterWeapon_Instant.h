@@ -3,23 +3,117 @@
 #pragma once
 
 #include "ShooterWeapon.h"
+#include "ShooterHitRegLog.h"
+#include "Circuit/Components/LagCompensationComponent.h"
 #include "ShooterWeapon_Instant.generated.h"
 
 class AShooterImpactEffect;
 
+/**
+ * One shot as every machine needs it: the spread cone is regenerated from the weapon's replicated ShotSeedBase and ShotIndex,
+ * so the shot's random seed and origin are never sent. Aim and spread are stored quantized and the shooter fires with the quantized
+ * values too, so remote tracers follow the exact same directions.
+ */
 USTRUCT()
 struct FInstantHitInfo
 {
 	GENERATED_USTRUCT_BODY()
 
+	/** counts up with every shot the owner fires, so each shot is also a new value for OnRep_HitNotify */
 	UPROPERTY()
-	FVector Origin;
+	uint16 ShotIndex;
 
+	/** spread cone in hundredths of a degree */
 	UPROPERTY()
-	float ReticleSpread;
+	uint16 ReticleSpread;
 
+	/** aim rotation, see FRotator::CompressAxisToShort */
 	UPROPERTY()
-	int32 RandomSeed;
+	uint16 AimPitch;
+
+	UPROPERTY()
+	uint16 AimYaw;
+
+	FInstantHitInfo()
+		: ShotIndex(0)
+		, ReticleSpread(0)
+		, AimPitch(0)
+		, AimYaw(0)
+	{
+	}
+
+	void SetAim(const FVector& AimDir);
+	FVector GetAimDir() const;
+
+	void SetReticleSpread(float SpreadDegrees);
+	float GetReticleSpread() const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FInstantHitInfo> : public TStructOpsTypeTraitsBase2<FInstantHitInfo>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/** every pellet of a multi-pellet shot in one server RPC: which pellets hit (bit mask) and a quantized impact point and actor for each of those */
+USTRUCT()
+struct FInstantPelletBatch
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** pellets in a shot are capped so the hit mask fits in 32 bits */
+	static const int32 MaxPellets = 32;
+
+	UPROPERTY()
+	FVector_NetQuantize TraceStart;
+
+	/** the shot, so the server can regenerate each pellet's direction */
+	UPROPERTY()
+	FInstantHitInfo Shot;
+
+	UPROPERTY()
+	float ClientTimestamp;
+
+	UPROPERTY()
+	uint8 NumPellets;
+
+	/** bit N set if pellet N is reported as a hit */
+	UPROPERTY()
+	uint32 HitMask;
+
+	/** one entry per set bit in HitMask, in pellet order */
+	UPROPERTY()
+	TArray<FVector_NetQuantize> HitPoints;
+
+	UPROPERTY()
+	TArray<AActor*> HitActors;
+
+	FInstantPelletBatch()
+		: TraceStart(ForceInitToZero)
+		, ClientTimestamp(0.0f)
+		, NumPellets(0)
+		, HitMask(0)
+	{
+	}
+
+	/** rebuild the hit result for the HitIndex-th reported hit */
+	FHitResult MakeHitResult(int32 HitIndex, float WeaponRange) const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FInstantPelletBatch> : public TStructOpsTypeTraitsBase2<FInstantPelletBatch>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
 };
 
 USTRUCT()
@@ -51,10 +145,30 @@ struct FInstantWeaponData
 	UPROPERTY(EditDefaultsOnly, Category=WeaponStat)
 	int32 HitDamage;
 
+	/** traces per shot, all generated from the shot's random seed and reported to the server in one RPC (shotguns) */
+	UPROPERTY(EditDefaultsOnly, Category=WeaponStat, meta=(ClampMin="1", ClampMax="32"))
+	int32 PelletsPerShot;
+
 	/** type of damage */
 	UPROPERTY(EditDefaultsOnly, Category=WeaponStat)
 	TSubclassOf<UDamageType> DamageType;
 
+	/** damage scale for hits on a head hitbox (see ULagCompensationComponent) */
+	UPROPERTY(EditDefaultsOnly, Category=WeaponStat)
+	float HeadDamageMultiplier;
+
+	/** damage scale for hits on a torso hitbox, and on characters without hitboxes */
+	UPROPERTY(EditDefaultsOnly, Category=WeaponStat)
+	float TorsoDamageMultiplier;
+
+	/** damage scale for hits on an arm hitbox */
+	UPROPERTY(EditDefaultsOnly, Category=WeaponStat)
+	float ArmDamageMultiplier;
+
+	/** damage scale for hits on a leg hitbox */
+	UPROPERTY(EditDefaultsOnly, Category=WeaponStat)
+	float LegDamageMultiplier;
+
 	/** hit verification: scale for bounding box of hit actor */
 	UPROPERTY(EditDefaultsOnly, Category=HitVerification)
 	float ClientSideHitLeeway;
@@ -63,6 +177,34 @@ struct FInstantWeaponData
 	UPROPERTY(EditDefaultsOnly, Category=HitVerification)
 	float AllowedViewDotHitDir;
 
+	/** hit verification: furthest back (seconds) a target with lag compensation is rewound to the shooter's timestamp */
+	UPROPERTY(EditDefaultsOnly, Category=HitVerification)
+	float MaxRewindTime;
+
+	/** hit verification: extra radius on rewound hitboxes (or the capsule, for characters without a physics asset) */
+	UPROPERTY(EditDefaultsOnly, Category=HitVerification)
+	float RewindHitLeeway;
+
+	/** hit verification: how far the client's trace may start from the shooter's view location on the server */
+	UPROPERTY(EditDefaultsOnly, Category=HitVerification)
+	float MaxTraceStartError;
+
+	/** shots follow a path bent by gravity fields (and world gravity) instead of a straight line */
+	UPROPERTY(EditDefaultsOnly, Category=Ballistics)
+	bool bBallistic;
+
+	/** ballistic: muzzle velocity (cm/s), slower shots curve more */
+	UPROPERTY(EditDefaultsOnly, Category=Ballistics, meta=(EditCondition="bBallistic"))
+	float BallisticSpeed;
+
+	/** ballistic: most line traces one shot is split into */
+	UPROPERTY(EditDefaultsOnly, Category=Ballistics, meta=(EditCondition="bBallistic", ClampMin="1", ClampMax="64"))
+	int32 MaxBallisticSegments;
+
+	/** hit verification: how far a reported ballistic impact may be from the path the server computes */
+	UPROPERTY(EditDefaultsOnly, Category=HitVerification, meta=(EditCondition="bBallistic"))
+	float BallisticHitTolerance;
+
 	/** defaults */
 	FInstantWeaponData()
 	{
@@ -72,9 +214,21 @@ struct FInstantWeaponData
 		FiringSpreadMax = 10.0f;
 		WeaponRange = 10000.0f;
 		HitDamage = 10;
+		PelletsPerShot = 1;
 		DamageType = UDamageType::StaticClass();
+		HeadDamageMultiplier = 1.0f;
+		TorsoDamageMultiplier = 1.0f;
+		ArmDamageMultiplier = 1.0f;
+		LegDamageMultiplier = 1.0f;
 		ClientSideHitLeeway = 200.0f;
 		AllowedViewDotHitDir = 0.8f;
+		MaxRewindTime = 0.25f;
+		RewindHitLeeway = 15.0f;
+		MaxTraceStartError = 250.0f;
+		bBallistic = false;
+		BallisticSpeed = 50000.0f;
+		MaxBallisticSegments = 16;
+		BallisticHitTolerance = 50.0f;
 	}
 };
 
@@ -87,6 +241,9 @@ class AShooterWeapon_Instant : public AShooterWeapon
 	/** get current spread */
 	float GetCurrentSpread() const;
 
+	/** get number of traces per shot */
+	int32 GetPelletsPerShot() const;
+
 protected:
 
 	virtual EAmmoType GetAmmoType() const override
@@ -110,6 +267,9 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category=Effects)
 	FName TrailTargetParam;
 
+	/** [local] have the effect pool ready the impact effect */
+	virtual void BeginPlay() override;
+
 	/** instant hit notify for replication */
 	UPROPERTY(Transient, ReplicatedUsing=OnRep_HitNotify)
 	FInstantHitInfo HitNotify;
@@ -117,22 +277,60 @@ protected:
 	/** current spread from continuous firing */
 	float CurrentFiringSpread;
 
+	/** picked by the server, combined with each shot's ShotIndex to seed its spread */
+	UPROPERTY(Transient, Replicated)
+	int32 ShotSeedBase;
+
+	/** [local] ShotIndex of the last shot fired */
+	uint16 ShotCounter;
+
 	//////////////////////////////////////////////////////////////////////////
 	// Weapon usage
 
-	/** server notified of hit from client to verify */
+	/** server notified of hit from client to verify, ClientTimestamp is the server time the client saw the hit at */
+	UFUNCTION(reliable, server, WithValidation)
+	void ServerNotifyHit(const FHitResult& Impact, FInstantHitInfo ShotInfo, float ClientTimestamp);
+
+	/** server notified of every pellet of a multi-pellet shot */
 	UFUNCTION(reliable, server, WithValidation)
-	void ServerNotifyHit(const FHitResult& Impact, FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread);
+	void ServerNotifyPellets(const FInstantPelletBatch& Batch);
+
+	/** [server] verify a hit the client reported and process it if it checks out */
+	void ServerConfirmHit(const FHitResult& Impact, const FVector& ShootDir, const FInstantHitInfo& ShotInfo, float ClientTimestamp);
+
+	/** [server] add the outcome of ServerConfirmHit to the hit registration log */
+	void RecordHitReg(const FHitResult& Impact, const FVector& Origin, const FInstantHitInfo& ShotInfo, float ClientTimestamp, float ViewDotHitDir, EHitRegDecision::Type Decision) const;
 
 	/** server notified of miss to show trail FX */
 	UFUNCTION(unreliable, server, WithValidation)
-	void ServerNotifyMiss(FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread);
+	void ServerNotifyMiss(FInstantHitInfo ShotInfo);
 
 	/** process the instant hit and notify the server if necessary */
-	void ProcessInstantHit(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread);
+	void ProcessInstantHit(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, const FInstantHitInfo& ShotInfo);
+
+	/** [server] re-trace the shot along the server's ShootDir from the client's start against where the target was at ClientTimestamp, OutBoneName is the rewound hitbox that was hit */
+	bool ConfirmRewoundHit(const FHitResult& Impact, const FVector& ShootDir, const ULagCompensationComponent* LagCompensation, float ClientTimestamp, FName& OutBoneName) const;
+
+	/** trace one shot from StartTrace, a straight line or the ballistic path. Ballistic hits keep StartTrace as TraceStart so the server can rebuild the path */
+	FHitResult InstantTrace(const FVector& StartTrace, const FVector& ShootDir) const;
+
+	/** points of the ballistic path of a shot, the same on every machine for the same inputs */
+	void GetBallisticPath(const FVector& StartTrace, const FVector& ShootDir, TArray<FVector>& OutPath) const;
+
+	/** [server] segment of the ballistic path closest to ImpactPoint, false if it's further than BallisticHitTolerance */
+	bool FindBallisticSegment(const FVector& StartTrace, const FVector& ShootDir, const FVector& ImpactPoint, FVector& OutSegmentStart, FVector& OutSegmentEnd) const;
+
+	/** [client] server time the remote characters on screen were at */
+	float GetClientHitTimestamp() const;
 
 	/** continue processing the instant hit, as if it has been confirmed by the server */
-	void ProcessInstantHit_Confirmed(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread);
+	void ProcessInstantHit_Confirmed(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, const FInstantHitInfo& ShotInfo);
+
+	/** random stream for a shot, the same on every machine */
+	FRandomStream GetShotRandomStream(const FInstantHitInfo& ShotInfo) const;
+
+	/** next direction in the shot's spread cone, call once per pellet in order */
+	FVector GetShotDirection(FRandomStream& WeaponRandomStream, const FInstantHitInfo& ShotInfo) const;
 
 	/** check if weapon should deal damage to actor */
 	bool ShouldDealDamage(AActor* TestActor) const;
@@ -140,9 +338,15 @@ protected:
 	/** handle damage */
 	void DealDamage(const FHitResult& Impact, const FVector& ShootDir);
 
+	/** damage scale for a hit in the region */
+	float GetHitboxDamageMultiplier(ECircuitHitboxRegion::Type Region) const;
+
 	/** [local] weapon specific fire implementation */
 	virtual void FireWeapon() override;
 
+	/** [local] trace every pellet of a shot and send the server a single batch */
+	void FirePellets(const FInstantHitInfo& ShotInfo, const FVector& StartTrace);
+
 	/** [local + server] update spread on firing */
 	virtual void OnBurstFinished() override;
 
@@ -154,7 +358,7 @@ protected:
 	void OnRep_HitNotify();
 
 	/** called in network play to do the cosmetic fx  */
-	void SimulateInstantHit(const FVector& Origin, int32 RandomSeed, float ReticleSpread);
+	void SimulateInstantHit(const FInstantHitInfo& ShotInfo);
 
 	/** spawn effects for impact */
 	void SpawnImpactEffects(const FHitResult& Impact);
@@ -4,6 +4,7 @@
 
 #include "ShooterWeapon.h"
 #include "GameFramework/DamageType.h" // for UDamageType::StaticClass()
+#include "ShooterProjectileManager.h"
 #include "ShooterWeapon_Projectile.generated.h"
 
 USTRUCT()
@@ -31,10 +32,15 @@ struct FProjectileWeaponData
 	UPROPERTY(EditDefaultsOnly, Category=WeaponStat)
 	TSubclassOf<UDamageType> DamageType;
 
+	/** fly projectiles as data in UShooterProjectileManager instead of spawning ProjectileClass (which still provides speed, collision and effects), for high rate weapons. Leave off for long lived projectiles like rockets */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile)
+	bool bUseProjectileManager;
+
 	/** defaults */
 	FProjectileWeaponData()
 	{
 		ProjectileClass = NULL;
+		bUseProjectileManager = false;
 		ProjectileLife = 10.0f;
 		ExplosionDamage = 100;
 		ExplosionRadius = 300.0f;
@@ -71,4 +77,11 @@ protected:
 	/** spawn projectile on server */
 	UFUNCTION(reliable, server, WithValidation)
 	void ServerFireProjectile(FVector Origin, FVector_NetQuantizeNormal ShootDir);
+
+	/** [server] tell everyone else to simulate a managed projectile */
+	UFUNCTION(unreliable, NetMulticast)
+	void MulticastSpawnProjectile(FShooterProjectileSpawn Spawn);
+
+	/** start a managed projectile here, false if this weapon doesn't use the projectile manager */
+	bool SpawnManagedProjectile(const FVector& Origin, const FVector& ShootDir, float ElapsedTime);
 };